@@ -0,0 +1,186 @@
+/*
+  ==============================================================================
+
+    AutoGain.cpp
+    Loudness-matching gain from a K-weighted envelope follower, run across channels in SIMD registers.
+
+  ==============================================================================
+*/
+
+#include "AutoGain.h"
+
+//==============================================================================
+void AutoGain::prepare (double newSampleRate, const juce::AudioChannelSet& channels)
+{
+    sampleRate = newSampleRate;
+    numPreparedChannels = juce::jlimit (0, maxChannels, channels.size());
+    kWeighting = LoudnessMeter::getKWeighting (sampleRate);
+
+    const int numGroups = (numPreparedChannels + channelsPerGroup - 1) / channelsPerGroup;
+    state.assign ((size_t) (4 * numGroups), Register::expand (0.0));
+    weights.assign ((size_t) numGroups, Register::expand (0.0));
+
+    for (int channel = 0; channel < numPreparedChannels; ++channel)
+        weights[(size_t) (channel / channelsPerGroup)].set ((size_t) (channel % channelsPerGroup),
+                                                            LoudnessMeter::getChannelWeight (channels, channel));
+
+    windowEnergies.assign ((size_t) juce::jmax (1, juce::roundToInt (windowSeconds * sampleRate / subBlockSize)), 0.0);
+
+    attackCoefficient = getCoefficient (attackMs);
+    releaseCoefficient = getCoefficient (releaseMs);
+    reset (0.0f);
+}
+
+void AutoGain::reset (float newGainDb) noexcept
+{
+    std::fill (state.begin(), state.end(), Register::expand (0.0));
+    subBlockSamples = 0;
+    subBlockEnergy = 0.0;
+
+    // The envelope, and the window behind it, start at the loudness the gain would be
+    // right for
+    gainDb = juce::jlimit (minGainDb, maxGainDb, newGainDb);
+    envelope = std::pow (10.0, (targetLufs - gainDb + 0.691) / 10.0);
+
+    std::fill (windowEnergies.begin(), windowEnergies.end(), envelope * subBlockSize);
+    windowSum = envelope * subBlockSize * (double) windowEnergies.size();
+    windowPosition = 0;
+}
+
+void AutoGain::setParameters (float newTargetLufs, float newAttackMs, float newReleaseMs) noexcept
+{
+    targetLufs = juce::jlimit (minTargetLufs, maxTargetLufs, newTargetLufs);
+
+    if (newAttackMs != attackMs)
+    {
+        attackMs = newAttackMs;
+        attackCoefficient = getCoefficient (attackMs);
+    }
+
+    if (newReleaseMs != releaseMs)
+    {
+        releaseMs = newReleaseMs;
+        releaseCoefficient = getCoefficient (releaseMs);
+    }
+}
+
+double AutoGain::getCoefficient (float ms) const noexcept
+{
+    // A one-pole stepped once per sub-block that gets 1 - 1/e of the way in ms
+    const auto numSubBlocks = juce::jmax (1.0, ms * 0.001 * sampleRate / subBlockSize);
+    return 1.0 - std::exp (-1.0 / numSubBlocks);
+}
+
+//==============================================================================
+template <typename SampleType>
+double AutoGain::weighGroup (const SampleType* const* channels, int firstChannel, int numChannels,
+                             int startSample, int numSamples) noexcept
+{
+    constexpr int lanes = channelsPerGroup;
+    alignas (Register::SIMDRegisterSize) double samples[subBlockSize * lanes];
+
+    // Lanes past the last channel are fed silence, and weighted zero
+    if (numChannels < lanes)
+        std::fill (std::begin (samples), std::end (samples), 0.0);
+
+    for (int lane = 0; lane < numChannels; ++lane)
+    {
+        const auto* source = channels[firstChannel + lane] + startSample;
+
+        for (int i = 0; i < numSamples; ++i)
+            samples[i * lanes + lane] = (double) source[i];
+    }
+
+    const int group = firstChannel / lanes;
+    auto& s1 = state[(size_t) (4 * group)];
+    auto& s2 = state[(size_t) (4 * group + 1)];
+    auto& h1 = state[(size_t) (4 * group + 2)];
+    auto& h2 = state[(size_t) (4 * group + 3)];
+
+    const auto& shelf = kWeighting.shelf;
+    const auto& highPass = kWeighting.highPass;
+    const auto sb0 = Register::expand (shelf.b0), sb1 = Register::expand (shelf.b1), sb2 = Register::expand (shelf.b2);
+    const auto sa1 = Register::expand (shelf.a1), sa2 = Register::expand (shelf.a2);
+    const auto ha1 = Register::expand (highPass.a1), ha2 = Register::expand (highPass.a2);
+    auto sumOfSquares = Register::expand (0.0);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto x = Register::fromRawArray (samples + i * lanes);
+
+        const auto y = x * sb0 + s1;
+        s1 = x * sb1 - y * sa1 + s2;
+        s2 = x * sb2 - y * sa2;
+
+        // The high-pass's numerator is 1, -2, 1
+        const auto z = y + h1;
+        h1 = h2 - (y + y) - z * ha1;
+        h2 = y - z * ha2;
+
+        sumOfSquares += z * z;
+    }
+
+    return (sumOfSquares * weights[(size_t) group]).sum();
+}
+
+void AutoGain::updateGain (double energy) noexcept
+{
+    // A quiet sub-block doesn't go into the window at all, so a pause neither drags the
+    // window down as it fills with silence nor leaves a hole in it once the sound is back
+    if (LoudnessMeter::loudnessOf (energy / subBlockSize) < gateLufs)
+        return;
+
+    auto& oldest = windowEnergies[(size_t) windowPosition];
+    windowSum += energy - oldest;
+    oldest = energy;
+
+    // Adding and taking away drifts, so the sum starts again from scratch every lap
+    if (++windowPosition == (int) windowEnergies.size())
+    {
+        windowPosition = 0;
+        windowSum = std::accumulate (windowEnergies.begin(), windowEnergies.end(), 0.0);
+    }
+
+    const auto meanSquare = windowSum / ((double) windowEnergies.size() * subBlockSize);
+    envelope += (meanSquare > envelope ? attackCoefficient : releaseCoefficient) * (meanSquare - envelope);
+    gainDb = juce::jlimit (minGainDb, maxGainDb, targetLufs - LoudnessMeter::loudnessOf (envelope));
+}
+
+template <typename SampleType>
+void AutoGain::process (const SampleType* const* channels, int numChannels, int numSamples, GainAutomationQueue& points) noexcept
+{
+    numChannels = juce::jmin (numChannels, numPreparedChannels);
+
+    // A long block completes more sub-blocks than the queue holds, so only every
+    // stride-th one adds a point, counted back from the last so the block always
+    // ends on the newest gain. The gain stage ramps across the ones in between.
+    const int numToComplete = (subBlockSamples + numSamples) / subBlockSize;
+    const int room = juce::jmax (1, GainAutomationQueue::capacity - points.size());
+    const int stride = (numToComplete + room - 1) / room;
+    int numCompleted = 0;
+
+    for (int position = 0; position < numSamples;)
+    {
+        const int numToDo = juce::jmin (numSamples - position, subBlockSize - subBlockSamples);
+
+        for (int first = 0; first < numChannels; first += channelsPerGroup)
+            subBlockEnergy += weighGroup (channels, first, juce::jmin (channelsPerGroup, numChannels - first), position, numToDo);
+
+        position += numToDo;
+        subBlockSamples += numToDo;
+
+        if (subBlockSamples == subBlockSize)
+        {
+            updateGain (subBlockEnergy);
+
+            if ((numToComplete - ++numCompleted) % stride == 0)
+                points.add (position, gainDb);
+
+            subBlockSamples = 0;
+            subBlockEnergy = 0.0;
+        }
+    }
+}
+
+template void AutoGain::process (const float* const*, int, int, GainAutomationQueue&) noexcept;
+template void AutoGain::process (const double* const*, int, int, GainAutomationQueue&) noexcept;
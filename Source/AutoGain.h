@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    AutoGain.h
+    Loudness-matching gain from a K-weighted envelope follower, run across channels in SIMD registers.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "GainAutomation.h"
+#include "LoudnessMeter.h"
+
+//==============================================================================
+/**
+    Works out the gain that brings the input to a target loudness, for the gain
+    stage to follow in place of the GAIN parameter.
+
+    The detector K-weights every channel the way the loudness meter does, with the
+    filter state kept as structure-of-arrays in juce::dsp::SIMDRegister<double>, one
+    channel per lane, as the DC blocker does. The squares are summed per lane and
+    only folded across the lanes, with BS.1770's channel weights, once per
+    sub-block of subBlockSize samples. So everything past the filters, i.e. the
+    envelope, the logarithm and the gain, is worked out once per sub-block rather
+    than per sample.
+
+    The sub-blocks' energies feed a running sum over 400 ms, BS.1770's momentary
+    window. A single sub-block is too short to measure anything steady, and with
+    the attack faster than the release, an envelope following its ripple would
+    settle too loud. Sub-blocks quieter than the BS.1770 absolute gate are left out
+    of the window and hold everything where it is, so a pause doesn't wind the gain
+    up to its maximum. The envelope follows the momentary mean square with a
+    one-pole that rises with the attack time and falls with the release time. The
+    gain is the target less the envelope's loudness, held within the GAIN
+    parameter's range. Each sub-block's gain goes to the gain stage as a point to
+    ramp to, the way host automation does, or every few sub-blocks' once a block
+    runs to more of them than GainAutomationQueue holds.
+
+    Everything is allocated by prepare(); the rest is for the audio thread.
+*/
+class AutoGain
+{
+public:
+    static constexpr int maxChannels = 128, subBlockSize = 32;
+
+    // The GAIN parameter's range
+    static constexpr float minGainDb = -12.0f, maxGainDb = 12.0f;
+
+    static constexpr float minTargetLufs = -36.0f, maxTargetLufs = 0.0f, defaultTargetLufs = -18.0f;
+    static constexpr float minAttackMs = 10.0f, maxAttackMs = 5000.0f, defaultAttackMs = 300.0f;
+    static constexpr float minReleaseMs = 50.0f, maxReleaseMs = 10000.0f, defaultReleaseMs = 1500.0f;
+
+    using Register = juce::dsp::SIMDRegister<double>;
+
+    /** Channels are filtered in groups of this many, one per lane. */
+    static constexpr int channelsPerGroup = (int) Register::SIMDNumElements;
+
+    //==============================================================================
+    /** Allocates the filter state for the layout's channels and resets. Not on the audio thread. */
+    void prepare (double sampleRate, const juce::AudioChannelSet& channels);
+
+    /** Clears the detector and starts the gain at gainDb, so switching on doesn't jump. */
+    void reset (float gainDb) noexcept;
+
+    /** Audio thread. The coefficients are only worked out again when something changes. */
+    void setParameters (float targetLufs, float attackMs, float releaseMs) noexcept;
+
+    /** Audio thread. Measures the first numChannels channels of the block, before any
+        gain, and adds a point to points, at its offset in the block, for every
+        sub-block that the block completes. When that would be more than the queue
+        has room for, only every stride-th sub-block adds one, with the stride the
+        smallest that fits and the last sub-block always among them.
+    */
+    template <typename SampleType>
+    void process (const SampleType* const* channels, int numChannels, int numSamples, GainAutomationQueue& points) noexcept;
+
+    /** The gain the last completed sub-block asked for. Audio thread. */
+    float getGainDb() const noexcept                    { return gainDb; }
+
+private:
+    //==============================================================================
+    // Filters samples [startSample, startSample + numSamples) of one group of lanes,
+    // at most subBlockSize of them, and returns their weighted sum of squares
+    template <typename SampleType>
+    double weighGroup (const SampleType* const* channels, int firstChannel, int numChannels,
+                       int startSample, int numSamples) noexcept;
+
+    void updateGain (double energy) noexcept;
+    double getCoefficient (float ms) const noexcept;
+
+    // Anything quieter is left out, as in BS.1770's absolute gate
+    static constexpr float gateLufs = -70.0f;
+    static constexpr double windowSeconds = 0.4;
+
+    double sampleRate = 44100.0;
+    int numPreparedChannels = 0;
+    LoudnessMeter::KWeighting kWeighting;
+
+    float targetLufs = defaultTargetLufs, attackMs = defaultAttackMs, releaseMs = defaultReleaseMs;
+    double attackCoefficient = 0.0, releaseCoefficient = 0.0;
+
+    // Four state registers per group of channels (two per biquad), and the weights
+    // of each group's lanes, zero past the last channel
+    std::vector<Register> state, weights;
+
+    // The energies of the last sub-blocks above the gate, oldest at windowPosition
+    std::vector<double> windowEnergies;
+    int windowPosition = 0;
+    double windowSum = 0.0;
+
+    int subBlockSamples = 0;
+    double subBlockEnergy = 0.0, envelope = 0.0;
+    float gainDb = 0.0f;
+};
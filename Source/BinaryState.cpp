@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+
+    BinaryState.cpp
+    Compact, versioned binary form of the plugin's saved parameter state.
+
+  ==============================================================================
+*/
+
+#include "BinaryState.h"
+
+namespace
+{
+    constexpr int headerSize = 8, maxIDLength = 255, maxParameters = 64;
+
+    template <typename Callback>
+    void forEachParameter (juce::AudioProcessorValueTreeState& apvts, Callback&& callback)
+    {
+        for (auto* parameter : apvts.processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+                if (ranged->getParameterID().getNumBytesAsUTF8() <= (size_t) maxIDLength)
+                    callback (*ranged);
+    }
+
+    // Compares the stored UTF-8 bytes with each ID in place, as looking them up through
+    // the APVTS would build a juce::String for every one
+    juce::RangedAudioParameter* findParameter (juce::AudioProcessorValueTreeState& apvts,
+                                               const juce::uint8* id, size_t idLength) noexcept
+    {
+        for (auto* parameter : apvts.processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+                if (ranged->paramID.getNumBytesAsUTF8() == idLength
+                     && std::memcmp (ranged->paramID.toRawUTF8(), id, idLength) == 0)
+                    return ranged;
+
+        return nullptr;
+    }
+
+    float floatFromLittleEndian (const juce::uint8* bytes) noexcept
+    {
+        const auto bits = juce::ByteOrder::littleEndianInt (bytes);
+        float value;
+        std::memcpy (&value, &bits, sizeof (value));
+        return value;
+    }
+}
+
+//==============================================================================
+void BinaryState::write (juce::AudioProcessorValueTreeState& apvts, juce::MemoryBlock& destData)
+{
+    // Sized up front, so the block is allocated once and written straight into
+    size_t size = headerSize;
+    int numParameters = 0;
+
+    forEachParameter (apvts, [&] (juce::RangedAudioParameter& parameter)
+    {
+        size += 1 + parameter.getParameterID().getNumBytesAsUTF8() + sizeof (float);
+        ++numParameters;
+    });
+
+    destData.setSize (size);
+    auto* out = static_cast<juce::uint8*> (destData.getData());
+
+    auto writeUInt16 = [&out] (juce::uint16 value)
+    {
+        out[0] = (juce::uint8) value;
+        out[1] = (juce::uint8) (value >> 8);
+        out += 2;
+    };
+
+    auto writeUInt32 = [&out] (juce::uint32 value)
+    {
+        for (int i = 0; i < 4; ++i)
+            *out++ = (juce::uint8) (value >> (8 * i));
+    };
+
+    writeUInt32 (magic);
+    writeUInt16 (currentVersion);
+    writeUInt16 ((juce::uint16) numParameters);
+
+    forEachParameter (apvts, [&] (juce::RangedAudioParameter& parameter)
+    {
+        const auto& id = parameter.getParameterID();
+        const auto idLength = id.getNumBytesAsUTF8();
+
+        *out++ = (juce::uint8) idLength;
+        std::memcpy (out, id.toRawUTF8(), idLength);
+        out += idLength;
+
+        const auto value = parameter.convertFrom0to1 (parameter.getValue());
+        juce::uint32 bits;
+        std::memcpy (&bits, &value, sizeof (bits));
+        writeUInt32 (bits);
+    });
+
+    jassert (out == static_cast<juce::uint8*> (destData.getData()) + size);
+}
+
+bool BinaryState::isBinaryState (const void* data, int sizeInBytes) noexcept
+{
+    return data != nullptr && sizeInBytes >= headerSize
+            && juce::ByteOrder::littleEndianInt (data) == magic;
+}
+
+bool BinaryState::read (juce::AudioProcessorValueTreeState& apvts, const void* data, int sizeInBytes)
+{
+    if (! isBinaryState (data, sizeInBytes))
+        return false;
+
+    const auto* in = static_cast<const juce::uint8*> (data);
+    const auto* end = in + sizeInBytes;
+    const auto version = juce::ByteOrder::littleEndianShort (in + 4);
+    const int numStored = juce::ByteOrder::littleEndianShort (in + 6);
+    in += headerSize;
+
+    if (version == 0)
+        return false;
+
+    // Everything is checked before any parameter changes, so a damaged state leaves
+    // the plugin as it was
+    std::array<juce::RangedAudioParameter*, maxParameters> parameters {};
+    std::array<float, maxParameters> values {};
+    int numFound = 0;
+
+    for (int i = 0; i < numStored; ++i)
+    {
+        if (end - in < 1 || end - in < 1 + in[0] + (int) sizeof (float))
+            return false;
+
+        const auto idLength = (size_t) *in++;
+        const auto* id = in;
+        in += idLength;
+
+        const auto value = floatFromLittleEndian (in);
+        in += sizeof (float);
+
+        if (! std::isfinite (value))
+            return false;
+
+        // IDs this version doesn't have are skipped
+        if (auto* parameter = findParameter (apvts, id, idLength); parameter != nullptr && numFound < maxParameters)
+        {
+            parameters[(size_t) numFound] = parameter;
+            values[(size_t) numFound] = value;
+            ++numFound;
+        }
+    }
+
+    const auto foundEnd = parameters.begin() + numFound;
+
+    forEachParameter (apvts, [&] (juce::RangedAudioParameter& parameter)
+    {
+        const auto stored = std::find (parameters.begin(), foundEnd, &parameter);
+
+        const auto normalised = stored != foundEnd ? parameter.convertTo0to1 (values[(size_t) (stored - parameters.begin())])
+                                                   : parameter.getDefaultValue();
+
+        parameter.setValueNotifyingHost (normalised);
+    });
+
+    return true;
+}
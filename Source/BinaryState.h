@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+    BinaryState.h
+    Compact, versioned binary form of the plugin's saved parameter state.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Saves and restores every parameter of an AudioProcessorValueTreeState without
+    going through a ValueTree, XML text or an XmlElement DOM, so that sessions with
+    hundreds of instances open quickly.
+
+    The layout, all little-endian:
+
+        4 bytes     magic, "OGst"
+        uint16      format version
+        uint16      number of parameters
+        then for each parameter:
+        uint8       length of its ID
+        bytes       the ID, UTF-8, not terminated
+        float32     its value, in the parameter's own units (as the APVTS stores it)
+
+    Parameters are found by ID, so states survive parameters being added, removed or
+    reordered; any parameter a state doesn't mention goes back to its default, as it
+    would with AudioProcessorValueTreeState::replaceState(). A later version may only
+    append to this layout, bumping the version; readers ignore anything past the
+    parameters they understand.
+*/
+struct BinaryState
+{
+    static constexpr juce::uint32 magic = 0x7473474f; // "OGst" read as little-endian
+    static constexpr juce::uint16 currentVersion = 1;
+
+    /** Replaces the contents of destData with the current value of every parameter. */
+    static void write (juce::AudioProcessorValueTreeState& apvts, juce::MemoryBlock& destData);
+
+    /** True if data starts like a binary state, whatever its version. */
+    static bool isBinaryState (const void* data, int sizeInBytes) noexcept;
+
+    /** Sets every parameter from the state. Returns false without changing anything if
+        the data isn't a complete binary state.
+    */
+    static bool read (juce::AudioProcessorValueTreeState& apvts, const void* data, int sizeInBytes);
+};
@@ -0,0 +1,33 @@
+/*
+  ==============================================================================
+
+    ChannelTaskPool.h
+    Worker threads that the processor can split a wide bus across.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//==============================================================================
+/**
+    Somewhere for GainAudioProcessor to run groups of channels concurrently, such as
+    the host's own audio worker threads.
+
+    An implementation knows which processor it serves, and runs a task by calling
+    that processor's runChannelTask() with the task's index.
+*/
+class ChannelTaskPool
+{
+public:
+    virtual ~ChannelTaskPool() = default;
+
+    /** Audio thread. Runs every task index in [0, numTasks) once, in any order, on any
+        threads (the calling one included), and returns once they have all finished,
+        with everything they wrote visible to the caller.
+
+        Returns false without running any of them if the pool can't take them right
+        now, in which case the processor runs them itself.
+    */
+    virtual bool execute (int numTasks) noexcept = 0;
+};
@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    ClapThreadPool.cpp
+    ChannelTaskPool on the host's clap.thread-pool extension (CLAP builds only).
+
+  ==============================================================================
+*/
+
+#include "ClapThreadPool.h"
+
+#if OPENGAIN_CLAP
+
+//==============================================================================
+namespace
+{
+    // exec() only gets the clap_plugin, and runs on the host's threads in the middle of
+    // process(), so each attached pool is listed against its plugin. Entries are only
+    // ever added, on the main thread, and one whose plugin has gone is taken over by
+    // the next to attach, so exec() can walk the list without a lock and any number of
+    // instances can have the host's threads.
+    struct Attachment
+    {
+        std::atomic<const clap_plugin*> plugin { nullptr };
+        std::atomic<ClapThreadPool*> pool { nullptr };
+        Attachment* next = nullptr;
+    };
+
+    struct Attachments
+    {
+        ~Attachments()
+        {
+            for (auto* attachment = first.load(); attachment != nullptr;)
+            {
+                auto* next = attachment->next;
+                delete attachment;
+                attachment = next;
+            }
+        }
+
+        std::atomic<Attachment*> first { nullptr };
+    };
+
+    Attachments attachments;
+
+    Attachment* findAttachment (const clap_plugin* plugin) noexcept
+    {
+        for (auto* attachment = attachments.first.load (std::memory_order_acquire); attachment != nullptr; attachment = attachment->next)
+            if (attachment->plugin.load (std::memory_order_acquire) == plugin)
+                return attachment;
+
+        return nullptr;
+    }
+
+    Attachment* claimAttachment (const clap_plugin* plugin)
+    {
+        for (auto* attachment = attachments.first.load (std::memory_order_acquire); attachment != nullptr; attachment = attachment->next)
+        {
+            const clap_plugin* empty = nullptr;
+
+            if (attachment->plugin.compare_exchange_strong (empty, plugin))
+                return attachment;
+        }
+
+        auto* attachment = new Attachment();
+        attachment->plugin.store (plugin, std::memory_order_relaxed);
+        attachment->next = attachments.first.load (std::memory_order_relaxed);
+
+        while (! attachments.first.compare_exchange_weak (attachment->next, attachment, std::memory_order_release))
+        {
+        }
+
+        return attachment;
+    }
+}
+
+//==============================================================================
+ClapThreadPool::ClapThreadPool (const clap_plugin* pl, const clap_host* h, const clap_host_thread_pool* p,
+                                GainAudioProcessor& proc)
+    : plugin (pl), host (h), hostPool (p), processor (proc)
+{
+}
+
+std::unique_ptr<ClapThreadPool> ClapThreadPool::attach (const clap_plugin* plugin, const clap_host* host,
+                                                        GainAudioProcessor& processor)
+{
+    const auto* hostPool = static_cast<const clap_host_thread_pool*> (host->get_extension (host, CLAP_EXT_THREAD_POOL));
+
+    if (hostPool == nullptr || hostPool->request_exec == nullptr)
+        return {};
+
+    std::unique_ptr<ClapThreadPool> pool (new ClapThreadPool (plugin, host, hostPool, processor));
+    claimAttachment (plugin)->pool.store (pool.get(), std::memory_order_release);
+    processor.setChannelTaskPool (pool.get());
+    return pool;
+}
+
+void ClapThreadPool::detach (std::unique_ptr<ClapThreadPool> pool)
+{
+    if (pool == nullptr)
+        return;
+
+    pool->processor.setChannelTaskPool (nullptr);
+
+    if (auto* attachment = findAttachment (pool->plugin))
+    {
+        attachment->pool.store (nullptr, std::memory_order_release);
+        attachment->plugin.store (nullptr, std::memory_order_release);
+    }
+}
+
+const clap_plugin_thread_pool* ClapThreadPool::getPluginExtension() noexcept
+{
+    static const clap_plugin_thread_pool extension { &ClapThreadPool::exec };
+    return &extension;
+}
+
+//==============================================================================
+bool ClapThreadPool::execute (int numTasks) noexcept
+{
+    // False if the host can't run them right now, e.g. because its pool is in use
+    return hostPool->request_exec (host, (uint32_t) numTasks);
+}
+
+void ClapThreadPool::exec (const clap_plugin* plugin, uint32_t taskIndex)
+{
+    if (auto* attachment = findAttachment (plugin))
+        if (auto* pool = attachment->pool.load (std::memory_order_acquire))
+            pool->processor.runChannelTask ((int) taskIndex);
+}
+
+#endif
@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    ClapThreadPool.h
+    ChannelTaskPool on the host's clap.thread-pool extension (CLAP builds only).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "PluginProcessor.h"
+
+#if OPENGAIN_CLAP
+ #include <clap/clap.h>
+
+//==============================================================================
+/**
+    Lends the processor the host's worker threads in the CLAP build.
+
+    clap.thread-pool comes in two halves: from inside process() the plugin asks the
+    host's request_exec() to run some number of tasks, and the host calls back into
+    the plugin's exec() once per task index, on its own threads, before request_exec()
+    returns. Here request_exec() sits behind ChannelTaskPool::execute(), and exec()
+    goes to the runChannelTask() of whichever processor asked.
+
+    GainAudioProcessor connects it up through clap-juce-extensions: attach() when the
+    wrapper's init() gives it the host, getPluginExtension() from getExtension() for
+    CLAP_EXT_THREAD_POOL, and detach() before the plugin is destroyed. Each processor
+    owns its pool. A host without the extension simply leaves the processor on its
+    serial loop.
+*/
+class ClapThreadPool : public ChannelTaskPool
+{
+public:
+    /** Main thread. Hands the host's pool to the processor if the host has one, and
+        returns it for the processor to keep until detach(). Otherwise returns nullptr.
+    */
+    static std::unique_ptr<ClapThreadPool> attach (const clap_plugin* plugin, const clap_host* host,
+                                                   GainAudioProcessor& processor);
+
+    /** Main thread, with processing stopped. Takes the pool back off its processor and
+        deletes it. Does nothing for nullptr.
+    */
+    static void detach (std::unique_ptr<ClapThreadPool> pool);
+
+    /** What the plugin's get_extension() returns for CLAP_EXT_THREAD_POOL. */
+    static const clap_plugin_thread_pool* getPluginExtension() noexcept;
+
+    bool execute (int numTasks) noexcept override;
+
+private:
+    ClapThreadPool (const clap_plugin* plugin, const clap_host* host, const clap_host_thread_pool* hostPool,
+                    GainAudioProcessor& processor);
+
+    static void exec (const clap_plugin* plugin, uint32_t taskIndex);
+
+    const clap_plugin* plugin;
+    const clap_host* host;
+    const clap_host_thread_pool* hostPool;
+    GainAudioProcessor& processor;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ClapThreadPool)
+};
+
+#endif
@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    DcBlocker.cpp
+    Second-order high-pass that removes DC, run across channels in SIMD registers.
+
+  ==============================================================================
+*/
+
+#include "DcBlocker.h"
+
+//==============================================================================
+void DcBlocker::prepare (double newSampleRate, int numChannels)
+{
+    sampleRate = newSampleRate;
+    numPreparedChannels = juce::jlimit (0, maxChannels, numChannels);
+
+    const int numGroups = (numPreparedChannels + channelsPerGroup - 1) / channelsPerGroup;
+    state.assign ((size_t) (2 * numGroups), Register::expand (0.0));
+
+    updateCoefficients();
+    reset();
+}
+
+void DcBlocker::reset() noexcept
+{
+    std::fill (state.begin(), state.end(), Register::expand (0.0));
+}
+
+void DcBlocker::setCutoff (float hz) noexcept
+{
+    hz = juce::jlimit (minCutoffHz, maxCutoffHz, hz);
+
+    if (hz == cutoffHz)
+        return;
+
+    cutoffHz = hz;
+    updateCoefficients();
+}
+
+void DcBlocker::updateCoefficients() noexcept
+{
+    // The RBJ cookbook high-pass with a Q of 1/sqrt(2), i.e. Butterworth
+    const auto omega = juce::MathConstants<double>::twoPi * cutoffHz / sampleRate;
+    const auto cosOmega = std::cos (omega);
+    const auto alpha = std::sin (omega) * juce::MathConstants<double>::sqrt2 * 0.5;
+    const auto a0 = 1.0 + alpha;
+
+    b0 = (1.0 + cosOmega) * 0.5 / a0;
+    b1 = -2.0 * b0;
+    a1 = -2.0 * cosOmega / a0;
+    a2 = (1.0 - alpha) / a0;
+}
+
+//==============================================================================
+template <typename SampleType>
+void DcBlocker::process (SampleType* const* channels, int startChannel, int endChannel, int numSamples) noexcept
+{
+    jassert (startChannel % channelsPerGroup == 0 && endChannel <= numPreparedChannels);
+    endChannel = juce::jmin (endChannel, numPreparedChannels);
+
+    constexpr int lanes = channelsPerGroup;
+    alignas (Register::SIMDRegisterSize) double samples[chunkSize * lanes];
+
+    const auto b0s = Register::expand (b0), b1s = Register::expand (b1);
+    const auto a1s = Register::expand (a1), a2s = Register::expand (a2);
+    const auto threshold = Register::expand (flushThreshold);
+
+    for (int first = startChannel; first < endChannel; first += lanes)
+    {
+        const int numLanes = juce::jmin (lanes, endChannel - first);
+        auto& z1 = state[(size_t) (2 * (first / lanes))];
+        auto& z2 = state[(size_t) (2 * (first / lanes) + 1)];
+
+        // Lanes past the last channel are fed silence, and their output thrown away
+        if (numLanes < lanes)
+            std::fill (std::begin (samples), std::end (samples), 0.0);
+
+        for (int chunkStart = 0; chunkStart < numSamples; chunkStart += chunkSize)
+        {
+            const int n = juce::jmin (chunkSize, numSamples - chunkStart);
+
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                const auto* source = channels[first + lane] + chunkStart;
+
+                for (int i = 0; i < n; ++i)
+                    samples[i * lanes + lane] = (double) source[i];
+            }
+
+            for (int i = 0; i < n; ++i)
+            {
+                const auto x = Register::fromRawArray (samples + i * lanes);
+                const auto y = x * b0s + z1;
+
+                // b2 == b0
+                z1 = x * b1s - y * a1s + z2;
+                z2 = x * b0s - y * a2s;
+                y.copyToRawArray (samples + i * lanes);
+            }
+
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                auto* destination = channels[first + lane] + chunkStart;
+
+                for (int i = 0; i < n; ++i)
+                    destination[i] = (SampleType) samples[i * lanes + lane];
+            }
+        }
+
+        // Anything this small is far below the quietest sample, and would only go on
+        // shrinking towards the denormals
+        z1 = z1 & Register::greaterThanOrEqual (Register::abs (z1), threshold);
+        z2 = z2 & Register::greaterThanOrEqual (Register::abs (z2), threshold);
+    }
+}
+
+template void DcBlocker::process (float* const*, int, int, int) noexcept;
+template void DcBlocker::process (double* const*, int, int, int) noexcept;
@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    DcBlocker.h
+    Second-order high-pass that removes DC, run across channels in SIMD registers.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    A Butterworth high-pass biquad for taking DC offset out of the input before the
+    gain, so it doesn't eat headroom or light the clip LED.
+
+    Rather than one filter per channel, the state is kept as structure-of-arrays in
+    juce::dsp::SIMDRegister<double>: each register holds one state variable for a
+    group of channels, one channel per lane, and every sample of the group goes
+    through the filter at once. The channels are swapped into that layout a chunk at
+    a time on the stack, so a group of lanes only ever touches its own state and the
+    pool's tasks can run their groups side by side.
+
+    The state is double whatever the sample type: at a few hertz the poles sit so
+    close to the unit circle that a float filter's rounding noise comes up to about
+    -50 dB. The state is flushed to zero explicitly once it decays below
+    flushThreshold, so a long tail into silence can't reach the denormals.
+
+    Everything is allocated by prepare(); the rest is for the audio thread.
+*/
+class DcBlocker
+{
+public:
+    static constexpr int maxChannels = 128;
+    static constexpr float minCutoffHz = 2.0f, maxCutoffHz = 40.0f, defaultCutoffHz = 10.0f;
+
+    using Register = juce::dsp::SIMDRegister<double>;
+
+    /** Channels are processed in groups of this many, one per lane. */
+    static constexpr int channelsPerGroup = (int) Register::SIMDNumElements;
+
+    //==============================================================================
+    /** Allocates the state for numChannels channels and clears it. Not on the audio thread. */
+    void prepare (double sampleRate, int numChannels);
+
+    /** Clears the filter, as if it had only ever seen silence. */
+    void reset() noexcept;
+
+    /** Audio thread. The coefficients are only worked out again when it changes. */
+    void setCutoff (float hz) noexcept;
+
+    /** Audio thread. Filters channels [startChannel, endChannel) in place.
+        startChannel has to be at the start of a group, i.e. a multiple of
+        channelsPerGroup, so that groups never share a register of state.
+    */
+    template <typename SampleType>
+    void process (SampleType* const* channels, int startChannel, int endChannel, int numSamples) noexcept;
+
+private:
+    //==============================================================================
+    void updateCoefficients() noexcept;
+
+    // The chunk of samples swapped into lane order at a time, on the stack
+    static constexpr int chunkSize = 64;
+    static constexpr double flushThreshold = 1.0e-20;
+
+    double sampleRate = 44100.0;
+    float cutoffHz = defaultCutoffHz;
+    int numPreparedChannels = 0;
+
+    // Normalised by a0. For a high-pass b2 == b0 and b1 == -2 * b0.
+    double b0 = 1.0, b1 = 0.0, a1 = 0.0, a2 = 0.0;
+
+    // Transposed direct form II: two state registers per group of channels
+    std::vector<Register> state;
+};
@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    DiagnosticsPanel.cpp
+    Hidden overlay showing the processor's DSP load and real-time safety.
+
+  ==============================================================================
+*/
+
+#include "DiagnosticsPanel.h"
+
+//==============================================================================
+DiagnosticsPanel::DiagnosticsPanel (GainAudioProcessor& p, const juce::Font& f)
+    : audioProcessor (p), font (f)
+{
+    setOpaque (true);
+}
+
+void DiagnosticsPanel::update()
+{
+    snapshot = audioProcessor.dspLoad.getSnapshot();
+    numSkippedBlocks = audioProcessor.getNumSkippedBlocks();
+    numAllocations = RealtimeTripwire::getNumAllocations();
+    numLocks = RealtimeTripwire::getNumLocks();
+    repaint();
+}
+
+//==============================================================================
+void DiagnosticsPanel::paint (juce::Graphics& g)
+{
+    g.fillAll (juce::Colour (0xFF141414));
+    g.setColour (juce::Colour (0xFF3B3B3B));
+    g.drawRect (getLocalBounds());
+
+    auto area = getLocalBounds().reduced (margin);
+    auto text = area.removeFromBottom (numLines * lineHeight);
+    area.removeFromBottom (margin);
+
+    // The histogram, on a log scale so the rare slow blocks still show next to the
+    // common ones
+    const auto mostInBucket = *std::max_element (snapshot.buckets.begin(), snapshot.buckets.end());
+    const auto barWidth = (float) area.getWidth() / (float) DspLoadMonitor::numBuckets;
+
+    for (int i = 0; i < DspLoadMonitor::numBuckets; ++i)
+    {
+        const auto count = snapshot.buckets[(size_t) i];
+
+        if (count == 0)
+            continue;
+
+        const auto proportion = std::log1p ((float) count) / std::log1p ((float) mostInBucket);
+        const auto height = juce::jmax (1.0f, proportion * (float) area.getHeight());
+        const auto load = (float) i / (float) DspLoadMonitor::bucketsPerBudget;
+
+        g.setColour (load >= 1.0f ? juce::Colour (0xFFE8702A)
+                                  : load >= DspLoadMonitor::riskLoad ? juce::Colour (0xFFE8C32A)
+                                                                     : juce::Colour (0xFF0EA7B5));
+        g.fillRect ((float) area.getX() + (float) i * barWidth + 1.0f, (float) area.getBottom() - height,
+                    barWidth - 2.0f, height);
+    }
+
+    // The budget, half way along
+    g.setColour (juce::Colour (0xFFADB5BD).withAlpha (0.5f));
+    g.drawVerticalLine (area.getCentreX(), (float) area.getY(), (float) area.getBottom());
+
+    auto percent = [] (float load) { return juce::String (load * 100.0f, 1) + "%"; };
+
+    const juce::String lines[numLines] {
+        "Blocks " + juce::String (snapshot.numBlocks) + "  (" + juce::String (numSkippedBlocks) + " silent)",
+        "Load avg " + percent (snapshot.averageLoad) + "  worst " + percent (snapshot.worstLoad)
+            + " (" + juce::String (snapshot.worstMicroseconds, 0) + " us)",
+        "Near xrun (>" + juce::String (juce::roundToInt (DspLoadMonitor::riskLoad * 100.0f)) + "%) "
+            + juce::String (snapshot.numAtRisk) + "  over budget " + juce::String (snapshot.numOverBudget),
+        "Kernels " + juce::String (GainKernelSupport::getISAName (GainKernelSupport::getBestAvailableISA())),
+        RealtimeTripwire::isEnabled ? "Tripwire: " + juce::String (numAllocations) + " allocations, "
+                                          + juce::String (numLocks) + " locks on the audio thread"
+                                    : juce::String ("Tripwire: off in release builds"),
+        "Histogram 0-200% of budget. Click to reset"
+    };
+
+    g.setFont (font);
+
+    for (const auto& line : lines)
+    {
+        g.setColour (juce::Colour (0xFFADB5BD));
+        g.drawText (line, text.removeFromTop (lineHeight), juce::Justification::centredLeft, true);
+    }
+}
+
+void DiagnosticsPanel::mouseDown (const juce::MouseEvent&)
+{
+    audioProcessor.dspLoad.reset();
+}
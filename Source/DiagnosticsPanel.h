@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    DiagnosticsPanel.h
+    Hidden overlay showing the processor's DSP load and real-time safety.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+//==============================================================================
+/**
+    A histogram of how much of each block's real-time budget processBlock() took,
+    with the average and worst loads, how many blocks came close to or over budget,
+    which kernels are running and, in debug builds, what the realtime tripwire has
+    caught. Clicking it starts the statistics again.
+
+    The editor keeps it hidden until asked for, and calls update() on each meter
+    refresh while it's showing.
+*/
+class DiagnosticsPanel : public juce::Component
+{
+public:
+    DiagnosticsPanel (GainAudioProcessor& processor, const juce::Font& font);
+
+    /** Takes a fresh snapshot of the processor's statistics and repaints. */
+    void update();
+
+    //==============================================================================
+    void paint (juce::Graphics&) override;
+    void mouseDown (const juce::MouseEvent&) override;
+
+private:
+    static constexpr int lineHeight = 15, numLines = 6, margin = 8;
+
+    GainAudioProcessor& audioProcessor;
+    juce::Font font;
+
+    DspLoadMonitor::Snapshot snapshot;
+    juce::uint64 numSkippedBlocks = 0, numAllocations = 0, numLocks = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DiagnosticsPanel)
+};
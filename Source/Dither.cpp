@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    Dither.cpp
+    TPDF dither and noise shaping for requantising the output to 16 or 24 bits.
+
+  ==============================================================================
+*/
+
+#include "Dither.h"
+
+//==============================================================================
+void Dither::prepare (int maximumBlockSize, int numChannels)
+{
+    maxBlockSize = juce::jmax (1, maximumBlockSize);
+
+    // Whole chunks of lanes, so the last one needn't be a special case
+    noise.assign ((size_t) ((maxBlockSize + numLanes - 1) / numLanes * numLanes), 0.0f);
+    channelStates.resize ((size_t) juce::jlimit (0, maxChannels, numChannels));
+
+    // Every generator gets its own non-zero seed, so no two channels' dither correlate
+    juce::uint32 seed = 0x2545F491;
+
+    for (auto& state : channelStates)
+        for (auto& generator : state.generators)
+            generator = (seed += 0x9E3779B9) | 1;
+
+    reset();
+}
+
+void Dither::reset() noexcept
+{
+    for (auto& state : channelStates)
+    {
+        state.errors.fill (0.0);
+        state.errorPosition = 0;
+    }
+}
+
+void Dither::setFormat (int newBitDepth, Shape newShape) noexcept
+{
+    if (newBitDepth == bitDepth && newShape == shape)
+        return;
+
+    bitDepth = juce::jlimit (8, 24, newBitDepth);
+    shape = newShape;
+    scale = (double) (1 << (bitDepth - 1));
+
+    // The feedback filters H, for noise shaped by 1 - H(z)
+    static constexpr double firstOrder[] { 1.0 };
+    static constexpr double lipshitz[] { 2.033, -2.165, 1.959, -1.590, 0.6149 };
+    static constexpr double wannamaker[] { 2.412, -3.370, 3.937, -4.174, 3.353, -2.205, 1.281, -0.569, 0.0847 };
+
+    auto setCoefficients = [this] (const double* taps, int count) {
+        coefficients.fill (0.0);
+        std::copy_n (taps, count, coefficients.begin());
+        numTaps = count;
+    };
+
+    switch (shape)
+    {
+        case Shape::firstOrder:  setCoefficients (firstOrder, (int) std::size (firstOrder)); break;
+        case Shape::lipshitz:    setCoefficients (lipshitz, (int) std::size (lipshitz)); break;
+        case Shape::wannamaker:  setCoefficients (wannamaker, (int) std::size (wannamaker)); break;
+        case Shape::flat:
+        default:                 setCoefficients (nullptr, 0); break;
+    }
+
+    reset();
+}
+
+//==============================================================================
+void Dither::generateNoise (ChannelState& state, int numSamples) noexcept
+{
+    // Two xorshift32 steps per value, each taken to a 24-bit uniform; their difference
+    // is triangular over (-1, 1) LSB. The lanes are independent, so the inner loop is
+    // numLanes generators stepping side by side.
+    constexpr float toUnit = 1.0f / 16777216.0f;
+    auto generators = state.generators;
+
+    for (int i = 0; i < numSamples; i += numLanes)
+    {
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            auto s = generators[(size_t) lane];
+            s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+            const auto first = (int) (s >> 8);
+            s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+            const auto second = (int) (s >> 8);
+            generators[(size_t) lane] = s;
+
+            noise[(size_t) (i + lane)] = (float) (first - second) * toUnit;
+        }
+    }
+
+    state.generators = generators;
+}
+
+template <typename SampleType>
+void Dither::processChannel (SampleType* data, ChannelState& state, int numSamples) noexcept
+{
+    generateNoise (state, numSamples);
+
+    // In double throughout: a 24-bit LSB is below float's resolution near full scale
+    const auto inverseScale = 1.0 / scale;
+    auto errors = state.errors;
+    auto position = state.errorPosition;
+
+    // Every shape runs the full maxTaps, with the unused coefficients at zero: a loop
+    // of fixed length unrolls, where one of numTaps would stay a loop. Only the newest
+    // error depends on the last sample's rounding, so everything else is added up
+    // first, leaving a multiply and a few adds from one sample's rounding to the next.
+    // Adding 1.5 * 2^52 and taking it away again rounds to the nearest integer, the
+    // trick juce::roundToInt() uses, but without converting to an int and back.
+    constexpr double roundingOffset = 6755399441055744.0;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto* history = errors.data() + position;
+        double olderErrors = 0.0;
+
+        for (size_t tap = 1; tap < maxTaps; ++tap)
+            olderErrors += coefficients[tap] * history[tap];
+
+        const auto target = (double) data[i] * scale - olderErrors;
+        const auto dithered = target + (double) noise[(size_t) i];
+        const auto newestError = coefficients[0] * history[0];
+
+        const auto wanted = target - newestError;
+        const auto quantised = ((dithered - newestError) + roundingOffset) - roundingOffset;
+
+        position = position == 0 ? maxTaps - 1 : position - 1;
+        errors[(size_t) position] = errors[(size_t) (position + maxTaps)] = quantised - wanted;
+        data[i] = (SampleType) (quantised * inverseScale);
+    }
+
+    state.errors = errors;
+    state.errorPosition = position;
+}
+
+template <typename SampleType>
+void Dither::process (SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    numChannels = juce::jmin (numChannels, (int) channelStates.size());
+
+    // Blocks longer than the noise buffer go through in pieces
+    for (int channel = 0; channel < numChannels; ++channel)
+        for (int start = 0; start < numSamples; start += maxBlockSize)
+            processChannel (channels[channel] + start, channelStates[(size_t) channel], juce::jmin (maxBlockSize, numSamples - start));
+}
+
+template void Dither::process (float* const*, int, int) noexcept;
+template void Dither::process (double* const*, int, int) noexcept;
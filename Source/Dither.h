@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    Dither.h
+    TPDF dither and noise shaping for requantising the output to 16 or 24 bits.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Requantises the output to a fixed-point word length, with triangular (TPDF)
+    dither so the rounding error is noise rather than distortion, optionally shaped
+    by error feedback to move it to where the ear is least sensitive.
+
+    Each sample is scaled to the target's LSBs, has the filtered error of the last
+    few samples subtracted, and is rounded with a TPDF value added; what the rounding
+    changed is kept as the error for the next samples. So the noise comes out as
+    1 - H(z) times white noise, for the shape's feedback filter H. However the input
+    behaves, the error stays within 1.5 LSB, so the feedback can't run away.
+
+    The dither comes from xorshift32 generators, numLanes of them per channel side by
+    side in plain arrays, so the loop that fills a block's worth of noise vectorises
+    rather than calling juce::Random per sample. The noise buffer and every channel's
+    generators and error history are allocated by prepare().
+
+    The shaped curves are designed for 44.1 and 48 kHz; at higher rates they still
+    work, but put less of the noise out of the ear's way.
+*/
+class Dither
+{
+public:
+    enum class Shape
+    {
+        flat,           // plain TPDF
+        firstOrder,     // 1 - z^-1: rises 6 dB per octave
+        lipshitz,       // Lipshitz's 5-tap E-weighted curve
+        wannamaker      // Wannamaker's 9-tap F-weighted curve
+    };
+
+    static constexpr int maxChannels = 128, maxTaps = 9, numLanes = 8;
+
+    //==============================================================================
+    /** Allocates everything for blocks up to maximumBlockSize and resets. Not on the
+        audio thread.
+    */
+    void prepare (int maximumBlockSize, int numChannels);
+
+    /** Clears the error history. The generators carry on. */
+    void reset() noexcept;
+
+    /** Audio thread. A new word length or shape clears the error history. */
+    void setFormat (int bitDepth, Shape shape) noexcept;
+    int getBitDepth() const noexcept                    { return bitDepth; }
+
+    /** Audio thread. Requantises the first numChannels channels in place. */
+    template <typename SampleType>
+    void process (SampleType* const* channels, int numChannels, int numSamples) noexcept;
+
+private:
+    //==============================================================================
+    struct alignas (32) ChannelState
+    {
+        std::array<juce::uint32, numLanes> generators;
+
+        // The last maxTaps errors, newest first from errorPosition, written twice over
+        // so they can always be read as one run without wrapping
+        std::array<double, 2 * maxTaps> errors {};
+        int errorPosition = 0;
+    };
+
+    // Fills noise with numSamples TPDF values, in LSBs, from state's generators
+    void generateNoise (ChannelState& state, int numSamples) noexcept;
+
+    template <typename SampleType>
+    void processChannel (SampleType* data, ChannelState& state, int numSamples) noexcept;
+
+    int bitDepth = 24, numTaps = 0, maxBlockSize = 0;
+    Shape shape = Shape::flat;
+    double scale = 8388608.0;
+    std::array<double, maxTaps> coefficients {};
+
+    std::vector<ChannelState> channelStates;
+    std::vector<float> noise;
+};
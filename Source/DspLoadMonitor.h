@@ -0,0 +1,148 @@
+/*
+  ==============================================================================
+
+    DspLoadMonitor.h
+    How long each processBlock() call takes against its block's real-time budget.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Times every processed block with the high-resolution tick counter, as a fraction
+    of the time the block's samples last at the sample rate (its load: at 1 or more
+    the plugin alone would have the host drop out). The loads go into a histogram,
+    along with the worst block and counts of the blocks that came close to or over
+    the budget.
+
+    The audio thread is the only writer, and nothing here locks or allocates. Any
+    other thread can take a snapshot at any time; it reads each value on its own, so
+    a snapshot taken mid-block can be one block out between fields.
+*/
+class DspLoadMonitor
+{
+public:
+    /** Each bucket covers 5% of the budget, from 0 up to twice the budget; the last
+        one also takes every block beyond that.
+    */
+    static constexpr int numBuckets = 40, bucketsPerBudget = 20;
+
+    /** Blocks over this much of their budget leave the host little room for anything
+        else, and count as at risk of an xrun.
+    */
+    static constexpr float riskLoad = 0.7f;
+
+    struct Snapshot
+    {
+        std::array<juce::uint32, numBuckets> buckets {};
+        juce::uint64 numBlocks = 0, numAtRisk = 0, numOverBudget = 0;
+        float averageLoad = 0.0f, worstLoad = 0.0f;
+        float worstMicroseconds = 0.0f;
+    };
+
+    //==============================================================================
+    /** Not while processing. */
+    void prepare (double sampleRate) noexcept
+    {
+        ticksPerSample = (double) juce::Time::getHighResolutionTicksPerSecond() / sampleRate;
+    }
+
+    /** Any thread. The statistics start again from the next block. */
+    void reset() noexcept                               { resetPending.store (true, std::memory_order_relaxed); }
+
+    /** Audio thread. Times the block from construction to destruction. */
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock (DspLoadMonitor& m, int n) noexcept
+            : monitor (m), numSamples (n), startTicks (juce::Time::getHighResolutionTicks()) {}
+
+        ~ScopedBlock()                                  { monitor.addBlock (numSamples, juce::Time::getHighResolutionTicks() - startTicks); }
+
+    private:
+        DspLoadMonitor& monitor;
+        const int numSamples;
+        const juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedBlock)
+    };
+
+    /** Any thread. */
+    Snapshot getSnapshot() const noexcept
+    {
+        Snapshot snapshot;
+
+        for (size_t i = 0; i < buckets.size(); ++i)
+            snapshot.buckets[i] = buckets[i].load (std::memory_order_relaxed);
+
+        snapshot.numBlocks = numBlocks.load (std::memory_order_relaxed);
+        snapshot.numAtRisk = numAtRisk.load (std::memory_order_relaxed);
+        snapshot.numOverBudget = numOverBudget.load (std::memory_order_relaxed);
+        snapshot.averageLoad = averageLoad.load (std::memory_order_relaxed);
+        snapshot.worstLoad = worstLoad.load (std::memory_order_relaxed);
+        snapshot.worstMicroseconds = worstMicroseconds.load (std::memory_order_relaxed);
+        return snapshot;
+    }
+
+private:
+    //==============================================================================
+    // One writer, so plain loads and stores rather than read-modify-writes
+    template <typename T>
+    static void increment (std::atomic<T>& counter) noexcept
+    {
+        counter.store (counter.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void addBlock (int numSamples, juce::int64 elapsedTicks) noexcept
+    {
+        if (numSamples <= 0)
+            return;
+
+        if (resetPending.exchange (false, std::memory_order_relaxed))
+        {
+            for (auto& bucket : buckets)
+                bucket.store (0, std::memory_order_relaxed);
+
+            for (auto* counter : { &numBlocks, &numAtRisk, &numOverBudget })
+                counter->store (0, std::memory_order_relaxed);
+
+            worstLoad.store (0.0f, std::memory_order_relaxed);
+            worstMicroseconds.store (0.0f, std::memory_order_relaxed);
+            totalLoad = 0.0;
+        }
+
+        const auto load = (float) ((double) elapsedTicks / (ticksPerSample * numSamples));
+        increment (buckets[(size_t) juce::jlimit (0, numBuckets - 1, (int) (load * (float) bucketsPerBudget))]);
+        increment (numBlocks);
+
+        if (load > riskLoad)
+            increment (numAtRisk);
+
+        if (load >= 1.0f)
+            increment (numOverBudget);
+
+        if (load > worstLoad.load (std::memory_order_relaxed))
+        {
+            worstLoad.store (load, std::memory_order_relaxed);
+            worstMicroseconds.store ((float) juce::Time::highResolutionTicksToSeconds (elapsedTicks) * 1.0e6f,
+                                     std::memory_order_relaxed);
+        }
+
+        totalLoad += load;
+        averageLoad.store ((float) (totalLoad / (double) numBlocks.load (std::memory_order_relaxed)), std::memory_order_relaxed);
+    }
+
+    double ticksPerSample = (double) juce::Time::getHighResolutionTicksPerSecond() / 44100.0;
+
+    std::array<std::atomic<juce::uint32>, numBuckets> buckets {};
+    std::atomic<juce::uint64> numBlocks { 0 }, numAtRisk { 0 }, numOverBudget { 0 };
+    std::atomic<float> averageLoad { 0.0f }, worstLoad { 0.0f }, worstMicroseconds { 0.0f };
+    std::atomic<bool> resetPending { false };
+
+    // audio thread only
+    double totalLoad = 0.0;
+};
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    GainAutomation.h
+    Fixed-capacity list of timestamped gain changes for the current block.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Holds the timestamped GAIN points a host delivered for one block, in sample
+    order, so processBlock() can split the block at each of them.
+
+    Storage is a fixed array, so adding points never allocates. It is filled and
+    drained on the audio thread only.
+*/
+class GainAutomationQueue
+{
+public:
+    struct Point
+    {
+        int sampleOffset = 0;
+        float gainDb = 0.0f;
+    };
+
+    static constexpr int capacity = 64;
+
+    //==============================================================================
+    /** Adds a point, keeping the list sorted by offset. Points at the same offset keep
+        their arrival order. When the list is full the last point is replaced, so the
+        block still ends on the most recent value.
+    */
+    void add (int sampleOffset, float gainDb) noexcept
+    {
+        if (numPoints == capacity)
+        {
+            points[numPoints - 1] = { juce::jmax (sampleOffset, points[numPoints - 1].sampleOffset), gainDb };
+            return;
+        }
+
+        int i = numPoints++;
+
+        for (; i > 0 && points[i - 1].sampleOffset > sampleOffset; --i)
+            points[i] = points[i - 1];
+
+        points[i] = { sampleOffset, gainDb };
+    }
+
+    void clear() noexcept                       { numPoints = 0; }
+    bool isEmpty() const noexcept               { return numPoints == 0; }
+    int size() const noexcept                   { return numPoints; }
+
+    const Point* begin() const noexcept         { return points.data(); }
+    const Point* end() const noexcept           { return points.data() + numPoints; }
+
+private:
+    //==============================================================================
+    std::array<Point, capacity> points;
+    int numPoints = 0;
+};
@@ -0,0 +1,1945 @@
+/*
+  ==============================================================================
+
+    GainKernels.cpp
+    Vectorised gain + metering kernels, dispatched on the host CPU's instruction set.
+
+  ==============================================================================
+*/
+
+#include "GainKernels.h"
+
+#if defined (_M_X64) || defined (__x86_64__) || defined (__SSE2__) || (defined (_M_IX86_FP) && _M_IX86_FP == 2)
+ #define GAIN_KERNELS_X86 1
+ #include <immintrin.h>
+
+ // MSVC lets us use any intrinsic without extra flags, GCC and Clang need each
+ // function that uses AVX to be marked with the instruction set it targets.
+ #if JUCE_MSVC
+  #define GAIN_KERNELS_TARGET(isa)
+ #else
+  #define GAIN_KERNELS_TARGET(isa) __attribute__ ((target (isa)))
+ #endif
+
+ // The AVX kernels clear the upper halves of the vector registers themselves before
+ // handing back to SSE code (their scalar tails, or the caller), as compilers don't
+ // reliably do it for functions that are only AVX through a target attribute. Left
+ // dirty, every SSE instruction that follows pays for a state transition.
+#elif defined (__ARM_NEON__) || defined (__ARM_NEON) || defined (_M_ARM64)
+ #define GAIN_KERNELS_NEON 1
+ #include <arm_neon.h>
+
+ // Double-precision NEON only exists on 64-bit ARM
+ #if defined (__aarch64__) || defined (_M_ARM64)
+  #define GAIN_KERNELS_NEON_DOUBLE 1
+ #endif
+#endif
+
+// Compilers fuse the ramp's multiply and add into an FMA whenever the target has one
+// (AVX-512 implies FMA), which would make the vector kernels and the scalar tails in
+// them round differently to the scalar reference. GCC contracts across statements
+// by default and Clang within one, so both are told not to; so is MSVC, whose
+// default has changed between versions. CMake also builds this file with
+// -ffp-contract=off, for compilers that ignore the pragmas.
+#if JUCE_CLANG
+ #pragma clang fp contract (off)
+#elif JUCE_GCC
+ #pragma GCC optimize ("fp-contract=off")
+#elif JUCE_MSVC
+ #pragma fp_contract (off)
+#endif
+
+//==============================================================================
+// The vector kernels keep the scalar kernels' exact operations on the samples:
+// one multiply per sample, and ramp gains computed as start + increment * index
+// rather than accumulated. Peaks use max (abs, peak) with the same operand order,
+// so NaNs and ties resolve the same way as std::max (peak, std::abs (x)) does.
+// Only sumOfSquares depends on summation order, so it may differ in the last bits.
+
+// Everything is accumulated at the sample type's precision and only narrowed to
+// SampleStats at the end, so the double kernels meter at double precision.
+template <typename T>
+struct Totals
+{
+    T peak = 0, sumOfSquares = 0;
+    int numClipped = 0;
+
+    void merge (const Totals& other) noexcept
+    {
+        peak = std::max (peak, other.peak);
+        sumOfSquares += other.sumOfSquares;
+        numClipped += other.numClipped;
+    }
+
+    SampleStats toSampleStats() const noexcept
+    {
+        return { (float) peak, (float) sumOfSquares, numClipped };
+    }
+};
+
+template <typename T>
+static inline void accumulate (Totals<T>& stats, T x) noexcept
+{
+    const T magnitude = std::abs (x);
+    stats.peak = std::max (stats.peak, magnitude);
+    stats.sumOfSquares += x * x;
+    stats.numClipped += magnitude > (T) 1 ? 1 : 0;
+}
+
+template <typename T>
+static void gainRange (T* data, int begin, int end, T gain, Totals<T>& stats) noexcept
+{
+    for (int i = begin; i < end; ++i)
+    {
+        data[i] *= gain;
+        accumulate (stats, data[i]);
+    }
+}
+
+template <typename T>
+static void rampRange (T* data, int begin, int end, T start, T increment, Totals<T>& stats) noexcept
+{
+    for (int i = begin; i < end; ++i)
+    {
+        data[i] *= start + increment * (T) i;
+        accumulate (stats, data[i]);
+    }
+}
+
+template <typename T>
+static void measureRange (const T* data, int begin, int end, Totals<T>& stats) noexcept
+{
+    for (int i = begin; i < end; ++i)
+        accumulate (stats, data[i]);
+}
+
+template <typename T, typename Count>
+static Totals<T> reduceLanes (const T* peaks, const T* squares, const Count* clipped, int numLanes) noexcept
+{
+    Totals<T> stats;
+
+    for (int i = 0; i < numLanes; ++i)
+    {
+        stats.peak = std::max (stats.peak, peaks[i]);
+        stats.sumOfSquares += squares[i];
+        stats.numClipped += (int) clipped[i];
+    }
+
+    return stats;
+}
+
+template <typename T>
+static bool isSilentRange (const T* data, int begin, int end, T threshold) noexcept
+{
+    for (int i = begin; i < end; ++i)
+        if (! (std::abs (data[i]) <= threshold))
+            return false;
+
+    return true;
+}
+
+// The soft clipper's curve, worked out once per call so the vector kernels use the
+// same constants. The vector versions take the min and max with the operands the
+// other way round, which is what makes them pick the same value as std::min and
+// std::max whenever one side is a NaN.
+template <typename T>
+struct SoftClipCurve
+{
+    explicit SoftClipCurve (T kneeToUse) noexcept
+        : knee (kneeToUse), range ((T) 2 * ((T) 1 - kneeToUse)), curvature ((T) 1 / ((T) 2 * range)) {}
+
+    T apply (T x) const noexcept
+    {
+        const T magnitude = std::abs (x);
+        const T over = std::min (std::max (magnitude - knee, (T) 0), range);
+        return std::copysign (std::min (magnitude, knee) + (over - over * over * curvature), x);
+    }
+
+    T knee, range, curvature;
+};
+
+template <typename T>
+static void softClipRange (T* data, int begin, int end, const SoftClipCurve<T>& curve) noexcept
+{
+    for (int i = begin; i < end; ++i)
+        data[i] = curve.apply (data[i]);
+}
+
+// Mid/side gain as the matrix it amounts to, so both channels are read and written
+// once. Each coefficient is a ramp, worked out per sample like the gain ramps.
+template <typename T>
+static void midSideRange (T* left, T* right, int begin, int end, T directStart, T directIncrement,
+                          T crossStart, T crossIncrement, Totals<T>& leftStats, Totals<T>& rightStats) noexcept
+{
+    for (int i = begin; i < end; ++i)
+    {
+        const T direct = directStart + directIncrement * (T) i;
+        const T cross = crossStart + crossIncrement * (T) i;
+        const T l = left[i], r = right[i];
+
+        left[i] = direct * l + cross * r;
+        right[i] = cross * l + direct * r;
+        accumulate (leftStats, left[i]);
+        accumulate (rightStats, right[i]);
+    }
+}
+
+//==============================================================================
+template <typename T>
+static SampleStats applyGainScalar (T* data, int numSamples, T gain) noexcept
+{
+    Totals<T> stats;
+    gainRange (data, 0, numSamples, gain, stats);
+    return stats.toSampleStats();
+}
+
+template <typename T>
+static SampleStats applyGainRampScalar (T* data, int numSamples, T start, T increment) noexcept
+{
+    Totals<T> stats;
+    rampRange (data, 0, numSamples, start, increment, stats);
+    return stats.toSampleStats();
+}
+
+template <typename T>
+static SampleStats measureScalar (const T* data, int numSamples) noexcept
+{
+    Totals<T> stats;
+    measureRange (data, 0, numSamples, stats);
+    return stats.toSampleStats();
+}
+
+template <typename T>
+static bool isSilentScalar (const T* data, int numSamples, T threshold) noexcept
+{
+    return isSilentRange (data, 0, numSamples, threshold);
+}
+
+// The vector cross-channel kernels finish any channels left over with this
+template <typename T>
+static void rampChannels (T* const* channels, int beginChannel, int endChannel, int startSample, int numSamples,
+                          T start, T increment, ChannelStats& stats) noexcept
+{
+    for (int channel = beginChannel; channel < endChannel; ++channel)
+    {
+        Totals<T> totals;
+        rampRange (channels[channel] + startSample, 0, numSamples, start, increment, totals);
+        stats.add (channel, totals.toSampleStats());
+    }
+}
+
+template <typename T>
+static void applyGainAcrossChannelsScalar (T* const* channels, int numChannels, int startSample, int numSamples,
+                                           T start, T increment, ChannelStats& stats) noexcept
+{
+    rampChannels (channels, 0, numChannels, startSample, numSamples, start, increment, stats);
+}
+
+template <typename T>
+static void softClipScalar (T* data, int numSamples, T knee) noexcept
+{
+    softClipRange (data, 0, numSamples, SoftClipCurve<T> (knee));
+}
+
+template <typename T>
+static void applyMidSideScalar (T* left, T* right, int numSamples, T directStart, T directIncrement,
+                                T crossStart, T crossIncrement, SampleStats& leftStats, SampleStats& rightStats) noexcept
+{
+    Totals<T> leftTotals, rightTotals;
+    midSideRange (left, right, 0, numSamples, directStart, directIncrement, crossStart, crossIncrement, leftTotals, rightTotals);
+    leftStats = leftTotals.toSampleStats();
+    rightStats = rightTotals.toSampleStats();
+}
+
+#if GAIN_KERNELS_X86
+//==============================================================================
+struct StatsSSE2
+{
+    __m128 peak = _mm_setzero_ps(), squares = _mm_setzero_ps();
+    __m128i clipped = _mm_setzero_si128();
+
+    void add (__m128 v) noexcept
+    {
+        const auto magnitude = _mm_and_ps (v, _mm_castsi128_ps (_mm_set1_epi32 (0x7fffffff)));
+        peak = _mm_max_ps (magnitude, peak);
+        squares = _mm_add_ps (squares, _mm_mul_ps (v, v));
+
+        // a true comparison is all ones, i.e. -1
+        clipped = _mm_sub_epi32 (clipped, _mm_castps_si128 (_mm_cmpgt_ps (magnitude, _mm_set1_ps (1.0f))));
+    }
+
+    Totals<float> reduce() const noexcept
+    {
+        float peaks[4], sums[4];
+        juce::int32 counts[4];
+        _mm_storeu_ps (peaks, peak);
+        _mm_storeu_ps (sums, squares);
+        _mm_storeu_si128 ((__m128i*) counts, clipped);
+        return reduceLanes (peaks, sums, counts, 4);
+    }
+};
+
+static SampleStats applyGainSSE2 (float* data, int numSamples, float gain) noexcept
+{
+    const auto g = _mm_set1_ps (gain);
+    StatsSSE2 lanes;
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        const auto v = _mm_mul_ps (_mm_loadu_ps (data + i), g);
+        _mm_storeu_ps (data + i, v);
+        lanes.add (v);
+    }
+
+    auto stats = lanes.reduce();
+    gainRange (data, i, numSamples, gain, stats);
+    return stats.toSampleStats();
+}
+
+static SampleStats applyGainRampSSE2 (float* data, int numSamples, float start, float increment) noexcept
+{
+    const auto s = _mm_set1_ps (start);
+    const auto inc = _mm_set1_ps (increment);
+    const auto step = _mm_set1_ps (4.0f);
+    auto index = _mm_setr_ps (0.0f, 1.0f, 2.0f, 3.0f);
+    StatsSSE2 lanes;
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        const auto g = _mm_add_ps (s, _mm_mul_ps (inc, index));
+        const auto v = _mm_mul_ps (_mm_loadu_ps (data + i), g);
+        _mm_storeu_ps (data + i, v);
+        lanes.add (v);
+        index = _mm_add_ps (index, step);
+    }
+
+    auto stats = lanes.reduce();
+    rampRange (data, i, numSamples, start, increment, stats);
+    return stats.toSampleStats();
+}
+
+static SampleStats measureSSE2 (const float* data, int numSamples) noexcept
+{
+    StatsSSE2 lanesA, lanesB;
+    int i = 0;
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        lanesA.add (_mm_loadu_ps (data + i));
+        lanesB.add (_mm_loadu_ps (data + i + 4));
+    }
+
+    auto stats = lanesA.reduce();
+    stats.merge (lanesB.reduce());
+    measureRange (data, i, numSamples, stats);
+    return stats.toSampleStats();
+}
+
+// The silence checks look at a few vectors per test and branch, so an early loud
+// sample costs one iteration. A not-less-or-equal compare is true for NaNs too.
+static bool isSilentSSE2 (const float* data, int numSamples, float threshold) noexcept
+{
+    const auto t = _mm_set1_ps (threshold);
+    const auto absMask = _mm_castsi128_ps (_mm_set1_epi32 (0x7fffffff));
+    int i = 0;
+
+    for (; i + 16 <= numSamples; i += 16)
+    {
+        const auto a = _mm_cmpnle_ps (_mm_and_ps (_mm_loadu_ps (data + i), absMask), t);
+        const auto b = _mm_cmpnle_ps (_mm_and_ps (_mm_loadu_ps (data + i + 4), absMask), t);
+        const auto c = _mm_cmpnle_ps (_mm_and_ps (_mm_loadu_ps (data + i + 8), absMask), t);
+        const auto d = _mm_cmpnle_ps (_mm_and_ps (_mm_loadu_ps (data + i + 12), absMask), t);
+
+        if (_mm_movemask_ps (_mm_or_ps (_mm_or_ps (a, b), _mm_or_ps (c, d))) != 0)
+            return false;
+    }
+
+    return isSilentRange (data, i, numSamples, threshold);
+}
+
+static void softClipSSE2 (float* data, int numSamples, float knee) noexcept
+{
+    const SoftClipCurve<float> curve (knee);
+    const auto k = _mm_set1_ps (curve.knee), range = _mm_set1_ps (curve.range), curvature = _mm_set1_ps (curve.curvature);
+    const auto zero = _mm_setzero_ps();
+    const auto absMask = _mm_castsi128_ps (_mm_set1_epi32 (0x7fffffff));
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        const auto x = _mm_loadu_ps (data + i);
+        const auto magnitude = _mm_and_ps (x, absMask);
+        const auto over = _mm_min_ps (range, _mm_max_ps (zero, _mm_sub_ps (magnitude, k)));
+        const auto shaped = _mm_add_ps (_mm_min_ps (k, magnitude), _mm_sub_ps (over, _mm_mul_ps (_mm_mul_ps (over, over), curvature)));
+
+        // shaped is never negative, so the sign can just be or'ed back in
+        _mm_storeu_ps (data + i, _mm_or_ps (shaped, _mm_andnot_ps (absMask, x)));
+    }
+
+    softClipRange (data, i, numSamples, curve);
+}
+
+// The cross-channel kernels take four channels at a time and transpose 4x4 tiles of
+// samples, so that each vector holds one sample of four channels and needs only one
+// gain. Peaks and clip counts are loaded from and stored back to ChannelStats' arrays
+// directly, with no horizontal reduction per channel. Wider vectors wouldn't help
+// the short blocks these are for, so the AVX tables use these too.
+static void applyGainAcrossChannelsSSE2 (float* const* channels, int numChannels, int startSample, int numSamples,
+                                         float start, float increment, ChannelStats& stats) noexcept
+{
+    StatsSSE2 lanes;
+    int channel = 0;
+
+    for (; channel + 4 <= numChannels; channel += 4)
+    {
+        float* const ch0 = channels[channel] + startSample;
+        float* const ch1 = channels[channel + 1] + startSample;
+        float* const ch2 = channels[channel + 2] + startSample;
+        float* const ch3 = channels[channel + 3] + startSample;
+
+        lanes.peak = _mm_loadu_ps (stats.peaks.data() + channel);
+        lanes.clipped = _mm_loadu_si128 ((const __m128i*) (stats.numClipped.data() + channel));
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            auto r0 = _mm_loadu_ps (ch0 + i), r1 = _mm_loadu_ps (ch1 + i);
+            auto r2 = _mm_loadu_ps (ch2 + i), r3 = _mm_loadu_ps (ch3 + i);
+            _MM_TRANSPOSE4_PS (r0, r1, r2, r3);
+
+            r0 = _mm_mul_ps (r0, _mm_set1_ps (start + increment * (float) i));
+            r1 = _mm_mul_ps (r1, _mm_set1_ps (start + increment * (float) (i + 1)));
+            r2 = _mm_mul_ps (r2, _mm_set1_ps (start + increment * (float) (i + 2)));
+            r3 = _mm_mul_ps (r3, _mm_set1_ps (start + increment * (float) (i + 3)));
+            lanes.add (r0);
+            lanes.add (r1);
+            lanes.add (r2);
+            lanes.add (r3);
+
+            _MM_TRANSPOSE4_PS (r0, r1, r2, r3);
+            _mm_storeu_ps (ch0 + i, r0);
+            _mm_storeu_ps (ch1 + i, r1);
+            _mm_storeu_ps (ch2 + i, r2);
+            _mm_storeu_ps (ch3 + i, r3);
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            const auto gain = start + increment * (float) i;
+            ch0[i] *= gain;
+            ch1[i] *= gain;
+            ch2[i] *= gain;
+            ch3[i] *= gain;
+            lanes.add (_mm_setr_ps (ch0[i], ch1[i], ch2[i], ch3[i]));
+        }
+
+        _mm_storeu_ps (stats.peaks.data() + channel, lanes.peak);
+        _mm_storeu_si128 ((__m128i*) (stats.numClipped.data() + channel), lanes.clipped);
+    }
+
+    float sums[4];
+    _mm_storeu_ps (sums, lanes.squares);
+    stats.sumOfSquares += (sums[0] + sums[1]) + (sums[2] + sums[3]);
+
+    rampChannels (channels, channel, numChannels, startSample, numSamples, start, increment, stats);
+}
+
+static void applyMidSideSSE2 (float* left, float* right, int numSamples, float directStart, float directIncrement,
+                              float crossStart, float crossIncrement, SampleStats& leftStats, SampleStats& rightStats) noexcept
+{
+    const auto ds = _mm_set1_ps (directStart), di = _mm_set1_ps (directIncrement);
+    const auto cs = _mm_set1_ps (crossStart), ci = _mm_set1_ps (crossIncrement);
+    const auto step = _mm_set1_ps (4.0f);
+    auto index = _mm_setr_ps (0.0f, 1.0f, 2.0f, 3.0f);
+    StatsSSE2 leftLanes, rightLanes;
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        const auto direct = _mm_add_ps (ds, _mm_mul_ps (di, index));
+        const auto cross = _mm_add_ps (cs, _mm_mul_ps (ci, index));
+        const auto l = _mm_loadu_ps (left + i);
+        const auto r = _mm_loadu_ps (right + i);
+        const auto newLeft = _mm_add_ps (_mm_mul_ps (direct, l), _mm_mul_ps (cross, r));
+        const auto newRight = _mm_add_ps (_mm_mul_ps (cross, l), _mm_mul_ps (direct, r));
+        _mm_storeu_ps (left + i, newLeft);
+        _mm_storeu_ps (right + i, newRight);
+        leftLanes.add (newLeft);
+        rightLanes.add (newRight);
+        index = _mm_add_ps (index, step);
+    }
+
+    auto leftTotals = leftLanes.reduce();
+    auto rightTotals = rightLanes.reduce();
+    midSideRange (left, right, i, numSamples, directStart, directIncrement, crossStart, crossIncrement, leftTotals, rightTotals);
+    leftStats = leftTotals.toSampleStats();
+    rightStats = rightTotals.toSampleStats();
+}
+
+//==============================================================================
+struct StatsAVX2
+{
+    __m256 peak, squares;
+    __m256i clipped;
+
+    GAIN_KERNELS_TARGET ("avx2") void clear() noexcept
+    {
+        peak = squares = _mm256_setzero_ps();
+        clipped = _mm256_setzero_si256();
+    }
+
+    GAIN_KERNELS_TARGET ("avx2") void add (__m256 v) noexcept
+    {
+        const auto magnitude = _mm256_and_ps (v, _mm256_castsi256_ps (_mm256_set1_epi32 (0x7fffffff)));
+        peak = _mm256_max_ps (magnitude, peak);
+        squares = _mm256_add_ps (squares, _mm256_mul_ps (v, v));
+        clipped = _mm256_sub_epi32 (clipped, _mm256_castps_si256 (_mm256_cmp_ps (magnitude, _mm256_set1_ps (1.0f), _CMP_GT_OQ)));
+    }
+
+    GAIN_KERNELS_TARGET ("avx2") Totals<float> reduce() const noexcept
+    {
+        float peaks[8], sums[8];
+        juce::int32 counts[8];
+        _mm256_storeu_ps (peaks, peak);
+        _mm256_storeu_ps (sums, squares);
+        _mm256_storeu_si256 ((__m256i*) counts, clipped);
+        return reduceLanes (peaks, sums, counts, 8);
+    }
+};
+
+GAIN_KERNELS_TARGET ("avx2")
+static SampleStats applyGainAVX2 (float* data, int numSamples, float gain) noexcept
+{
+    const auto g = _mm256_set1_ps (gain);
+    StatsAVX2 lanesA, lanesB;
+    lanesA.clear();
+    lanesB.clear();
+    int i = 0;
+
+    for (; i + 16 <= numSamples; i += 16)
+    {
+        const auto a = _mm256_mul_ps (_mm256_loadu_ps (data + i), g);
+        const auto b = _mm256_mul_ps (_mm256_loadu_ps (data + i + 8), g);
+        _mm256_storeu_ps (data + i, a);
+        _mm256_storeu_ps (data + i + 8, b);
+        lanesA.add (a);
+        lanesB.add (b);
+    }
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const auto a = _mm256_mul_ps (_mm256_loadu_ps (data + i), g);
+        _mm256_storeu_ps (data + i, a);
+        lanesA.add (a);
+    }
+
+    auto stats = lanesA.reduce();
+    stats.merge (lanesB.reduce());
+    _mm256_zeroupper();
+    gainRange (data, i, numSamples, gain, stats);
+    return stats.toSampleStats();
+}
+
+GAIN_KERNELS_TARGET ("avx2")
+static SampleStats applyGainRampAVX2 (float* data, int numSamples, float start, float increment) noexcept
+{
+    const auto s = _mm256_set1_ps (start);
+    const auto inc = _mm256_set1_ps (increment);
+    const auto step = _mm256_set1_ps (8.0f);
+    auto index = _mm256_setr_ps (0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    StatsAVX2 lanes;
+    lanes.clear();
+    int i = 0;
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const auto g = _mm256_add_ps (s, _mm256_mul_ps (inc, index));
+        const auto v = _mm256_mul_ps (_mm256_loadu_ps (data + i), g);
+        _mm256_storeu_ps (data + i, v);
+        lanes.add (v);
+        index = _mm256_add_ps (index, step);
+    }
+
+    auto stats = lanes.reduce();
+    _mm256_zeroupper();
+    rampRange (data, i, numSamples, start, increment, stats);
+    return stats.toSampleStats();
+}
+
+GAIN_KERNELS_TARGET ("avx2")
+static SampleStats measureAVX2 (const float* data, int numSamples) noexcept
+{
+    StatsAVX2 lanesA, lanesB;
+    lanesA.clear();
+    lanesB.clear();
+    int i = 0;
+
+    for (; i + 16 <= numSamples; i += 16)
+    {
+        lanesA.add (_mm256_loadu_ps (data + i));
+        lanesB.add (_mm256_loadu_ps (data + i + 8));
+    }
+
+    auto stats = lanesA.reduce();
+    stats.merge (lanesB.reduce());
+    _mm256_zeroupper();
+    measureRange (data, i, numSamples, stats);
+    return stats.toSampleStats();
+}
+
+GAIN_KERNELS_TARGET ("avx2")
+static bool isSilentAVX2 (const float* data, int numSamples, float threshold) noexcept
+{
+    const auto t = _mm256_set1_ps (threshold);
+    const auto absMask = _mm256_castsi256_ps (_mm256_set1_epi32 (0x7fffffff));
+    int i = 0;
+
+    for (; i + 32 <= numSamples; i += 32)
+    {
+        const auto a = _mm256_cmp_ps (_mm256_and_ps (_mm256_loadu_ps (data + i), absMask), t, _CMP_NLE_UQ);
+        const auto b = _mm256_cmp_ps (_mm256_and_ps (_mm256_loadu_ps (data + i + 8), absMask), t, _CMP_NLE_UQ);
+        const auto c = _mm256_cmp_ps (_mm256_and_ps (_mm256_loadu_ps (data + i + 16), absMask), t, _CMP_NLE_UQ);
+        const auto d = _mm256_cmp_ps (_mm256_and_ps (_mm256_loadu_ps (data + i + 24), absMask), t, _CMP_NLE_UQ);
+
+        if (_mm256_movemask_ps (_mm256_or_ps (_mm256_or_ps (a, b), _mm256_or_ps (c, d))) != 0)
+        {
+            _mm256_zeroupper();
+            return false;
+        }
+    }
+
+    _mm256_zeroupper();
+    return isSilentRange (data, i, numSamples, threshold);
+}
+
+GAIN_KERNELS_TARGET ("avx2")
+static void softClipAVX2 (float* data, int numSamples, float knee) noexcept
+{
+    const SoftClipCurve<float> curve (knee);
+    const auto k = _mm256_set1_ps (curve.knee), range = _mm256_set1_ps (curve.range), curvature = _mm256_set1_ps (curve.curvature);
+    const auto zero = _mm256_setzero_ps();
+    const auto absMask = _mm256_castsi256_ps (_mm256_set1_epi32 (0x7fffffff));
+    int i = 0;
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const auto x = _mm256_loadu_ps (data + i);
+        const auto magnitude = _mm256_and_ps (x, absMask);
+        const auto over = _mm256_min_ps (range, _mm256_max_ps (zero, _mm256_sub_ps (magnitude, k)));
+        const auto shaped = _mm256_add_ps (_mm256_min_ps (k, magnitude), _mm256_sub_ps (over, _mm256_mul_ps (_mm256_mul_ps (over, over), curvature)));
+
+        // shaped is never negative, so the sign can just be or'ed back in
+        _mm256_storeu_ps (data + i, _mm256_or_ps (shaped, _mm256_andnot_ps (absMask, x)));
+    }
+
+    _mm256_zeroupper();
+    softClipRange (data, i, numSamples, curve);
+}
+
+GAIN_KERNELS_TARGET ("avx2")
+static void applyMidSideAVX2 (float* left, float* right, int numSamples, float directStart, float directIncrement,
+                              float crossStart, float crossIncrement, SampleStats& leftStats, SampleStats& rightStats) noexcept
+{
+    const auto ds = _mm256_set1_ps (directStart), di = _mm256_set1_ps (directIncrement);
+    const auto cs = _mm256_set1_ps (crossStart), ci = _mm256_set1_ps (crossIncrement);
+    const auto step = _mm256_set1_ps (8.0f);
+    auto index = _mm256_setr_ps (0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    StatsAVX2 leftLanes, rightLanes;
+    leftLanes.clear();
+    rightLanes.clear();
+    int i = 0;
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const auto direct = _mm256_add_ps (ds, _mm256_mul_ps (di, index));
+        const auto cross = _mm256_add_ps (cs, _mm256_mul_ps (ci, index));
+        const auto l = _mm256_loadu_ps (left + i);
+        const auto r = _mm256_loadu_ps (right + i);
+        const auto newLeft = _mm256_add_ps (_mm256_mul_ps (direct, l), _mm256_mul_ps (cross, r));
+        const auto newRight = _mm256_add_ps (_mm256_mul_ps (cross, l), _mm256_mul_ps (direct, r));
+        _mm256_storeu_ps (left + i, newLeft);
+        _mm256_storeu_ps (right + i, newRight);
+        leftLanes.add (newLeft);
+        rightLanes.add (newRight);
+        index = _mm256_add_ps (index, step);
+    }
+
+    auto leftTotals = leftLanes.reduce();
+    auto rightTotals = rightLanes.reduce();
+    _mm256_zeroupper();
+    midSideRange (left, right, i, numSamples, directStart, directIncrement, crossStart, crossIncrement, leftTotals, rightTotals);
+    leftStats = leftTotals.toSampleStats();
+    rightStats = rightTotals.toSampleStats();
+}
+
+//==============================================================================
+struct StatsAVX512
+{
+    __m512 peak, squares;
+    __m512i clipped;
+
+    GAIN_KERNELS_TARGET ("avx512f") void clear() noexcept
+    {
+        peak = squares = _mm512_setzero_ps();
+        clipped = _mm512_setzero_si512();
+    }
+
+    GAIN_KERNELS_TARGET ("avx512f") void add (__m512 v) noexcept
+    {
+        const auto magnitude = _mm512_abs_ps (v);
+        peak = _mm512_max_ps (magnitude, peak);
+        squares = _mm512_add_ps (squares, _mm512_mul_ps (v, v));
+
+        const auto isClipped = _mm512_cmp_ps_mask (magnitude, _mm512_set1_ps (1.0f), _CMP_GT_OQ);
+        clipped = _mm512_mask_add_epi32 (clipped, isClipped, clipped, _mm512_set1_epi32 (1));
+    }
+
+    GAIN_KERNELS_TARGET ("avx512f") Totals<float> reduce() const noexcept
+    {
+        float peaks[16], sums[16];
+        juce::int32 counts[16];
+        _mm512_storeu_ps (peaks, peak);
+        _mm512_storeu_ps (sums, squares);
+        _mm512_storeu_si512 (counts, clipped);
+        return reduceLanes (peaks, sums, counts, 16);
+    }
+};
+
+GAIN_KERNELS_TARGET ("avx512f")
+static SampleStats applyGainAVX512 (float* data, int numSamples, float gain) noexcept
+{
+    const auto g = _mm512_set1_ps (gain);
+    StatsAVX512 lanes;
+    lanes.clear();
+    int i = 0;
+
+    for (; i + 16 <= numSamples; i += 16)
+    {
+        const auto v = _mm512_mul_ps (_mm512_loadu_ps (data + i), g);
+        _mm512_storeu_ps (data + i, v);
+        lanes.add (v);
+    }
+
+    auto stats = lanes.reduce();
+    _mm256_zeroupper();
+    gainRange (data, i, numSamples, gain, stats);
+    return stats.toSampleStats();
+}
+
+GAIN_KERNELS_TARGET ("avx512f")
+static SampleStats applyGainRampAVX512 (float* data, int numSamples, float start, float increment) noexcept
+{
+    const auto s = _mm512_set1_ps (start);
+    const auto inc = _mm512_set1_ps (increment);
+    const auto step = _mm512_set1_ps (16.0f);
+    auto index = _mm512_setr_ps (0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f,
+                                 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f);
+    StatsAVX512 lanes;
+    lanes.clear();
+    int i = 0;
+
+    for (; i + 16 <= numSamples; i += 16)
+    {
+        const auto g = _mm512_add_ps (s, _mm512_mul_ps (inc, index));
+        const auto v = _mm512_mul_ps (_mm512_loadu_ps (data + i), g);
+        _mm512_storeu_ps (data + i, v);
+        lanes.add (v);
+        index = _mm512_add_ps (index, step);
+    }
+
+    auto stats = lanes.reduce();
+    _mm256_zeroupper();
+    rampRange (data, i, numSamples, start, increment, stats);
+    return stats.toSampleStats();
+}
+
+GAIN_KERNELS_TARGET ("avx512f")
+static SampleStats measureAVX512 (const float* data, int numSamples) noexcept
+{
+    StatsAVX512 lanes;
+    lanes.clear();
+    int i = 0;
+
+    for (; i + 16 <= numSamples; i += 16)
+        lanes.add (_mm512_loadu_ps (data + i));
+
+    auto stats = lanes.reduce();
+    _mm256_zeroupper();
+    measureRange (data, i, numSamples, stats);
+    return stats.toSampleStats();
+}
+
+GAIN_KERNELS_TARGET ("avx512f")
+static bool isSilentAVX512 (const float* data, int numSamples, float threshold) noexcept
+{
+    const auto t = _mm512_set1_ps (threshold);
+    int i = 0;
+
+    for (; i + 32 <= numSamples; i += 32)
+    {
+        const auto a = _mm512_cmp_ps_mask (_mm512_abs_ps (_mm512_loadu_ps (data + i)), t, _CMP_NLE_UQ);
+        const auto b = _mm512_cmp_ps_mask (_mm512_abs_ps (_mm512_loadu_ps (data + i + 16)), t, _CMP_NLE_UQ);
+
+        if ((a | b) != 0)
+        {
+            _mm256_zeroupper();
+            return false;
+        }
+    }
+
+    _mm256_zeroupper();
+    return isSilentRange (data, i, numSamples, threshold);
+}
+
+GAIN_KERNELS_TARGET ("avx512f")
+static void softClipAVX512 (float* data, int numSamples, float knee) noexcept
+{
+    const SoftClipCurve<float> curve (knee);
+    const auto k = _mm512_set1_ps (curve.knee), range = _mm512_set1_ps (curve.range), curvature = _mm512_set1_ps (curve.curvature);
+    const auto zero = _mm512_setzero_ps();
+    const auto signMask = _mm512_set1_epi32 ((int) 0x80000000);
+    int i = 0;
+
+    for (; i + 16 <= numSamples; i += 16)
+    {
+        const auto x = _mm512_loadu_ps (data + i);
+        const auto magnitude = _mm512_abs_ps (x);
+        const auto over = _mm512_min_ps (range, _mm512_max_ps (zero, _mm512_sub_ps (magnitude, k)));
+        const auto shaped = _mm512_add_ps (_mm512_min_ps (k, magnitude), _mm512_sub_ps (over, _mm512_mul_ps (_mm512_mul_ps (over, over), curvature)));
+
+        // shaped is never negative, so the sign can just be or'ed back in
+        _mm512_storeu_ps (data + i, _mm512_castsi512_ps (_mm512_or_si512 (_mm512_castps_si512 (shaped), _mm512_and_si512 (_mm512_castps_si512 (x), signMask))));
+    }
+
+    _mm256_zeroupper();
+    softClipRange (data, i, numSamples, curve);
+}
+
+//==============================================================================
+// The double kernels do exactly what the float ones do, two, four or eight lanes
+// at a time, so they keep the same agreement with the scalar reference.
+
+struct DoubleStatsSSE2
+{
+    __m128d peak = _mm_setzero_pd(), squares = _mm_setzero_pd();
+    __m128i clipped = _mm_setzero_si128();
+
+    void add (__m128d v) noexcept
+    {
+        const auto magnitude = _mm_and_pd (v, _mm_castsi128_pd (_mm_set1_epi64x (0x7fffffffffffffffLL)));
+        peak = _mm_max_pd (magnitude, peak);
+        squares = _mm_add_pd (squares, _mm_mul_pd (v, v));
+        clipped = _mm_sub_epi64 (clipped, _mm_castpd_si128 (_mm_cmpgt_pd (magnitude, _mm_set1_pd (1.0))));
+    }
+
+    Totals<double> reduce() const noexcept
+    {
+        double peaks[2], sums[2];
+        juce::int64 counts[2];
+        _mm_storeu_pd (peaks, peak);
+        _mm_storeu_pd (sums, squares);
+        _mm_storeu_si128 ((__m128i*) counts, clipped);
+        return reduceLanes (peaks, sums, counts, 2);
+    }
+};
+
+static SampleStats applyGainSSE2 (double* data, int numSamples, double gain) noexcept
+{
+    const auto g = _mm_set1_pd (gain);
+    DoubleStatsSSE2 lanesA, lanesB;
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        const auto a = _mm_mul_pd (_mm_loadu_pd (data + i), g);
+        const auto b = _mm_mul_pd (_mm_loadu_pd (data + i + 2), g);
+        _mm_storeu_pd (data + i, a);
+        _mm_storeu_pd (data + i + 2, b);
+        lanesA.add (a);
+        lanesB.add (b);
+    }
+
+    auto stats = lanesA.reduce();
+    stats.merge (lanesB.reduce());
+    gainRange (data, i, numSamples, gain, stats);
+    return stats.toSampleStats();
+}
+
+static SampleStats applyGainRampSSE2 (double* data, int numSamples, double start, double increment) noexcept
+{
+    const auto s = _mm_set1_pd (start);
+    const auto inc = _mm_set1_pd (increment);
+    const auto step = _mm_set1_pd (2.0);
+    auto index = _mm_setr_pd (0.0, 1.0);
+    DoubleStatsSSE2 lanes;
+    int i = 0;
+
+    for (; i + 2 <= numSamples; i += 2)
+    {
+        const auto g = _mm_add_pd (s, _mm_mul_pd (inc, index));
+        const auto v = _mm_mul_pd (_mm_loadu_pd (data + i), g);
+        _mm_storeu_pd (data + i, v);
+        lanes.add (v);
+        index = _mm_add_pd (index, step);
+    }
+
+    auto stats = lanes.reduce();
+    rampRange (data, i, numSamples, start, increment, stats);
+    return stats.toSampleStats();
+}
+
+static SampleStats measureSSE2 (const double* data, int numSamples) noexcept
+{
+    DoubleStatsSSE2 lanesA, lanesB;
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        lanesA.add (_mm_loadu_pd (data + i));
+        lanesB.add (_mm_loadu_pd (data + i + 2));
+    }
+
+    auto stats = lanesA.reduce();
+    stats.merge (lanesB.reduce());
+    measureRange (data, i, numSamples, stats);
+    return stats.toSampleStats();
+}
+
+static bool isSilentSSE2 (const double* data, int numSamples, double threshold) noexcept
+{
+    const auto t = _mm_set1_pd (threshold);
+    const auto absMask = _mm_castsi128_pd (_mm_set1_epi64x (0x7fffffffffffffffLL));
+    int i = 0;
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const auto a = _mm_cmpnle_pd (_mm_and_pd (_mm_loadu_pd (data + i), absMask), t);
+        const auto b = _mm_cmpnle_pd (_mm_and_pd (_mm_loadu_pd (data + i + 2), absMask), t);
+        const auto c = _mm_cmpnle_pd (_mm_and_pd (_mm_loadu_pd (data + i + 4), absMask), t);
+        const auto d = _mm_cmpnle_pd (_mm_and_pd (_mm_loadu_pd (data + i + 6), absMask), t);
+
+        if (_mm_movemask_pd (_mm_or_pd (_mm_or_pd (a, b), _mm_or_pd (c, d))) != 0)
+            return false;
+    }
+
+    return isSilentRange (data, i, numSamples, threshold);
+}
+
+static void softClipSSE2 (double* data, int numSamples, double knee) noexcept
+{
+    const SoftClipCurve<double> curve (knee);
+    const auto k = _mm_set1_pd (curve.knee), range = _mm_set1_pd (curve.range), curvature = _mm_set1_pd (curve.curvature);
+    const auto zero = _mm_setzero_pd();
+    const auto absMask = _mm_castsi128_pd (_mm_set1_epi64x (0x7fffffffffffffffLL));
+    int i = 0;
+
+    for (; i + 2 <= numSamples; i += 2)
+    {
+        const auto x = _mm_loadu_pd (data + i);
+        const auto magnitude = _mm_and_pd (x, absMask);
+        const auto over = _mm_min_pd (range, _mm_max_pd (zero, _mm_sub_pd (magnitude, k)));
+        const auto shaped = _mm_add_pd (_mm_min_pd (k, magnitude), _mm_sub_pd (over, _mm_mul_pd (_mm_mul_pd (over, over), curvature)));
+
+        // shaped is never negative, so the sign can just be or'ed back in
+        _mm_storeu_pd (data + i, _mm_or_pd (shaped, _mm_andnot_pd (absMask, x)));
+    }
+
+    softClipRange (data, i, numSamples, curve);
+}
+
+// Two channels at a time, with 2x2 tiles
+static void applyGainAcrossChannelsSSE2 (double* const* channels, int numChannels, int startSample, int numSamples,
+                                         double start, double increment, ChannelStats& stats) noexcept
+{
+    DoubleStatsSSE2 lanes;
+    int channel = 0;
+
+    for (; channel + 2 <= numChannels; channel += 2)
+    {
+        double* const ch0 = channels[channel] + startSample;
+        double* const ch1 = channels[channel + 1] + startSample;
+        float* const peaks = stats.peaks.data() + channel;
+        int* const clipped = stats.numClipped.data() + channel;
+
+        lanes.peak = _mm_setr_pd (peaks[0], peaks[1]);
+        lanes.clipped = _mm_set_epi64x (clipped[1], clipped[0]);
+        int i = 0;
+
+        for (; i + 2 <= numSamples; i += 2)
+        {
+            const auto a = _mm_loadu_pd (ch0 + i), b = _mm_loadu_pd (ch1 + i);
+            const auto first = _mm_mul_pd (_mm_unpacklo_pd (a, b), _mm_set1_pd (start + increment * (double) i));
+            const auto second = _mm_mul_pd (_mm_unpackhi_pd (a, b), _mm_set1_pd (start + increment * (double) (i + 1)));
+            lanes.add (first);
+            lanes.add (second);
+
+            _mm_storeu_pd (ch0 + i, _mm_unpacklo_pd (first, second));
+            _mm_storeu_pd (ch1 + i, _mm_unpackhi_pd (first, second));
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            const auto gain = start + increment * (double) i;
+            ch0[i] *= gain;
+            ch1[i] *= gain;
+            lanes.add (_mm_setr_pd (ch0[i], ch1[i]));
+        }
+
+        double newPeaks[2];
+        juce::int64 counts[2];
+        _mm_storeu_pd (newPeaks, lanes.peak);
+        _mm_storeu_si128 ((__m128i*) counts, lanes.clipped);
+
+        for (int k = 0; k < 2; ++k)
+        {
+            peaks[k] = (float) newPeaks[k];
+            clipped[k] = (int) counts[k];
+        }
+    }
+
+    double sums[2];
+    _mm_storeu_pd (sums, lanes.squares);
+    stats.sumOfSquares += (float) (sums[0] + sums[1]);
+
+    rampChannels (channels, channel, numChannels, startSample, numSamples, start, increment, stats);
+}
+
+static void applyMidSideSSE2 (double* left, double* right, int numSamples, double directStart, double directIncrement,
+                              double crossStart, double crossIncrement, SampleStats& leftStats, SampleStats& rightStats) noexcept
+{
+    const auto ds = _mm_set1_pd (directStart), di = _mm_set1_pd (directIncrement);
+    const auto cs = _mm_set1_pd (crossStart), ci = _mm_set1_pd (crossIncrement);
+    const auto step = _mm_set1_pd (2.0);
+    auto index = _mm_setr_pd (0.0, 1.0);
+    DoubleStatsSSE2 leftLanes, rightLanes;
+    int i = 0;
+
+    for (; i + 2 <= numSamples; i += 2)
+    {
+        const auto direct = _mm_add_pd (ds, _mm_mul_pd (di, index));
+        const auto cross = _mm_add_pd (cs, _mm_mul_pd (ci, index));
+        const auto l = _mm_loadu_pd (left + i);
+        const auto r = _mm_loadu_pd (right + i);
+        const auto newLeft = _mm_add_pd (_mm_mul_pd (direct, l), _mm_mul_pd (cross, r));
+        const auto newRight = _mm_add_pd (_mm_mul_pd (cross, l), _mm_mul_pd (direct, r));
+        _mm_storeu_pd (left + i, newLeft);
+        _mm_storeu_pd (right + i, newRight);
+        leftLanes.add (newLeft);
+        rightLanes.add (newRight);
+        index = _mm_add_pd (index, step);
+    }
+
+    auto leftTotals = leftLanes.reduce();
+    auto rightTotals = rightLanes.reduce();
+    midSideRange (left, right, i, numSamples, directStart, directIncrement, crossStart, crossIncrement, leftTotals, rightTotals);
+    leftStats = leftTotals.toSampleStats();
+    rightStats = rightTotals.toSampleStats();
+}
+
+//==============================================================================
+struct DoubleStatsAVX2
+{
+    __m256d peak, squares;
+    __m256i clipped;
+
+    GAIN_KERNELS_TARGET ("avx2") void clear() noexcept
+    {
+        peak = squares = _mm256_setzero_pd();
+        clipped = _mm256_setzero_si256();
+    }
+
+    GAIN_KERNELS_TARGET ("avx2") void add (__m256d v) noexcept
+    {
+        const auto magnitude = _mm256_and_pd (v, _mm256_castsi256_pd (_mm256_set1_epi64x (0x7fffffffffffffffLL)));
+        peak = _mm256_max_pd (magnitude, peak);
+        squares = _mm256_add_pd (squares, _mm256_mul_pd (v, v));
+        clipped = _mm256_sub_epi64 (clipped, _mm256_castpd_si256 (_mm256_cmp_pd (magnitude, _mm256_set1_pd (1.0), _CMP_GT_OQ)));
+    }
+
+    GAIN_KERNELS_TARGET ("avx2") Totals<double> reduce() const noexcept
+    {
+        double peaks[4], sums[4];
+        juce::int64 counts[4];
+        _mm256_storeu_pd (peaks, peak);
+        _mm256_storeu_pd (sums, squares);
+        _mm256_storeu_si256 ((__m256i*) counts, clipped);
+        return reduceLanes (peaks, sums, counts, 4);
+    }
+};
+
+GAIN_KERNELS_TARGET ("avx2")
+static SampleStats applyGainAVX2 (double* data, int numSamples, double gain) noexcept
+{
+    const auto g = _mm256_set1_pd (gain);
+    DoubleStatsAVX2 lanesA, lanesB;
+    lanesA.clear();
+    lanesB.clear();
+    int i = 0;
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const auto a = _mm256_mul_pd (_mm256_loadu_pd (data + i), g);
+        const auto b = _mm256_mul_pd (_mm256_loadu_pd (data + i + 4), g);
+        _mm256_storeu_pd (data + i, a);
+        _mm256_storeu_pd (data + i + 4, b);
+        lanesA.add (a);
+        lanesB.add (b);
+    }
+
+    auto stats = lanesA.reduce();
+    stats.merge (lanesB.reduce());
+    _mm256_zeroupper();
+    gainRange (data, i, numSamples, gain, stats);
+    return stats.toSampleStats();
+}
+
+GAIN_KERNELS_TARGET ("avx2")
+static SampleStats applyGainRampAVX2 (double* data, int numSamples, double start, double increment) noexcept
+{
+    const auto s = _mm256_set1_pd (start);
+    const auto inc = _mm256_set1_pd (increment);
+    const auto step = _mm256_set1_pd (4.0);
+    auto index = _mm256_setr_pd (0.0, 1.0, 2.0, 3.0);
+    DoubleStatsAVX2 lanes;
+    lanes.clear();
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        const auto g = _mm256_add_pd (s, _mm256_mul_pd (inc, index));
+        const auto v = _mm256_mul_pd (_mm256_loadu_pd (data + i), g);
+        _mm256_storeu_pd (data + i, v);
+        lanes.add (v);
+        index = _mm256_add_pd (index, step);
+    }
+
+    auto stats = lanes.reduce();
+    _mm256_zeroupper();
+    rampRange (data, i, numSamples, start, increment, stats);
+    return stats.toSampleStats();
+}
+
+GAIN_KERNELS_TARGET ("avx2")
+static SampleStats measureAVX2 (const double* data, int numSamples) noexcept
+{
+    DoubleStatsAVX2 lanesA, lanesB;
+    lanesA.clear();
+    lanesB.clear();
+    int i = 0;
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        lanesA.add (_mm256_loadu_pd (data + i));
+        lanesB.add (_mm256_loadu_pd (data + i + 4));
+    }
+
+    auto stats = lanesA.reduce();
+    stats.merge (lanesB.reduce());
+    _mm256_zeroupper();
+    measureRange (data, i, numSamples, stats);
+    return stats.toSampleStats();
+}
+
+GAIN_KERNELS_TARGET ("avx2")
+static bool isSilentAVX2 (const double* data, int numSamples, double threshold) noexcept
+{
+    const auto t = _mm256_set1_pd (threshold);
+    const auto absMask = _mm256_castsi256_pd (_mm256_set1_epi64x (0x7fffffffffffffffLL));
+    int i = 0;
+
+    for (; i + 16 <= numSamples; i += 16)
+    {
+        const auto a = _mm256_cmp_pd (_mm256_and_pd (_mm256_loadu_pd (data + i), absMask), t, _CMP_NLE_UQ);
+        const auto b = _mm256_cmp_pd (_mm256_and_pd (_mm256_loadu_pd (data + i + 4), absMask), t, _CMP_NLE_UQ);
+        const auto c = _mm256_cmp_pd (_mm256_and_pd (_mm256_loadu_pd (data + i + 8), absMask), t, _CMP_NLE_UQ);
+        const auto d = _mm256_cmp_pd (_mm256_and_pd (_mm256_loadu_pd (data + i + 12), absMask), t, _CMP_NLE_UQ);
+
+        if (_mm256_movemask_pd (_mm256_or_pd (_mm256_or_pd (a, b), _mm256_or_pd (c, d))) != 0)
+        {
+            _mm256_zeroupper();
+            return false;
+        }
+    }
+
+    _mm256_zeroupper();
+    return isSilentRange (data, i, numSamples, threshold);
+}
+
+GAIN_KERNELS_TARGET ("avx2")
+static void softClipAVX2 (double* data, int numSamples, double knee) noexcept
+{
+    const SoftClipCurve<double> curve (knee);
+    const auto k = _mm256_set1_pd (curve.knee), range = _mm256_set1_pd (curve.range), curvature = _mm256_set1_pd (curve.curvature);
+    const auto zero = _mm256_setzero_pd();
+    const auto absMask = _mm256_castsi256_pd (_mm256_set1_epi64x (0x7fffffffffffffffLL));
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        const auto x = _mm256_loadu_pd (data + i);
+        const auto magnitude = _mm256_and_pd (x, absMask);
+        const auto over = _mm256_min_pd (range, _mm256_max_pd (zero, _mm256_sub_pd (magnitude, k)));
+        const auto shaped = _mm256_add_pd (_mm256_min_pd (k, magnitude), _mm256_sub_pd (over, _mm256_mul_pd (_mm256_mul_pd (over, over), curvature)));
+
+        // shaped is never negative, so the sign can just be or'ed back in
+        _mm256_storeu_pd (data + i, _mm256_or_pd (shaped, _mm256_andnot_pd (absMask, x)));
+    }
+
+    _mm256_zeroupper();
+    softClipRange (data, i, numSamples, curve);
+}
+
+GAIN_KERNELS_TARGET ("avx2")
+static void applyMidSideAVX2 (double* left, double* right, int numSamples, double directStart, double directIncrement,
+                              double crossStart, double crossIncrement, SampleStats& leftStats, SampleStats& rightStats) noexcept
+{
+    const auto ds = _mm256_set1_pd (directStart), di = _mm256_set1_pd (directIncrement);
+    const auto cs = _mm256_set1_pd (crossStart), ci = _mm256_set1_pd (crossIncrement);
+    const auto step = _mm256_set1_pd (4.0);
+    auto index = _mm256_setr_pd (0.0, 1.0, 2.0, 3.0);
+    DoubleStatsAVX2 leftLanes, rightLanes;
+    leftLanes.clear();
+    rightLanes.clear();
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        const auto direct = _mm256_add_pd (ds, _mm256_mul_pd (di, index));
+        const auto cross = _mm256_add_pd (cs, _mm256_mul_pd (ci, index));
+        const auto l = _mm256_loadu_pd (left + i);
+        const auto r = _mm256_loadu_pd (right + i);
+        const auto newLeft = _mm256_add_pd (_mm256_mul_pd (direct, l), _mm256_mul_pd (cross, r));
+        const auto newRight = _mm256_add_pd (_mm256_mul_pd (cross, l), _mm256_mul_pd (direct, r));
+        _mm256_storeu_pd (left + i, newLeft);
+        _mm256_storeu_pd (right + i, newRight);
+        leftLanes.add (newLeft);
+        rightLanes.add (newRight);
+        index = _mm256_add_pd (index, step);
+    }
+
+    auto leftTotals = leftLanes.reduce();
+    auto rightTotals = rightLanes.reduce();
+    _mm256_zeroupper();
+    midSideRange (left, right, i, numSamples, directStart, directIncrement, crossStart, crossIncrement, leftTotals, rightTotals);
+    leftStats = leftTotals.toSampleStats();
+    rightStats = rightTotals.toSampleStats();
+}
+
+//==============================================================================
+struct DoubleStatsAVX512
+{
+    __m512d peak, squares;
+    __m512i clipped;
+
+    GAIN_KERNELS_TARGET ("avx512f") void clear() noexcept
+    {
+        peak = squares = _mm512_setzero_pd();
+        clipped = _mm512_setzero_si512();
+    }
+
+    GAIN_KERNELS_TARGET ("avx512f") void add (__m512d v) noexcept
+    {
+        const auto magnitude = _mm512_abs_pd (v);
+        peak = _mm512_max_pd (magnitude, peak);
+        squares = _mm512_add_pd (squares, _mm512_mul_pd (v, v));
+
+        const auto isClipped = _mm512_cmp_pd_mask (magnitude, _mm512_set1_pd (1.0), _CMP_GT_OQ);
+        clipped = _mm512_mask_add_epi64 (clipped, isClipped, clipped, _mm512_set1_epi64 (1));
+    }
+
+    GAIN_KERNELS_TARGET ("avx512f") Totals<double> reduce() const noexcept
+    {
+        double peaks[8], sums[8];
+        juce::int64 counts[8];
+        _mm512_storeu_pd (peaks, peak);
+        _mm512_storeu_pd (sums, squares);
+        _mm512_storeu_si512 (counts, clipped);
+        return reduceLanes (peaks, sums, counts, 8);
+    }
+};
+
+GAIN_KERNELS_TARGET ("avx512f")
+static SampleStats applyGainAVX512 (double* data, int numSamples, double gain) noexcept
+{
+    const auto g = _mm512_set1_pd (gain);
+    DoubleStatsAVX512 lanes;
+    lanes.clear();
+    int i = 0;
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const auto v = _mm512_mul_pd (_mm512_loadu_pd (data + i), g);
+        _mm512_storeu_pd (data + i, v);
+        lanes.add (v);
+    }
+
+    auto stats = lanes.reduce();
+    _mm256_zeroupper();
+    gainRange (data, i, numSamples, gain, stats);
+    return stats.toSampleStats();
+}
+
+GAIN_KERNELS_TARGET ("avx512f")
+static SampleStats applyGainRampAVX512 (double* data, int numSamples, double start, double increment) noexcept
+{
+    const auto s = _mm512_set1_pd (start);
+    const auto inc = _mm512_set1_pd (increment);
+    const auto step = _mm512_set1_pd (8.0);
+    auto index = _mm512_setr_pd (0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0);
+    DoubleStatsAVX512 lanes;
+    lanes.clear();
+    int i = 0;
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const auto g = _mm512_add_pd (s, _mm512_mul_pd (inc, index));
+        const auto v = _mm512_mul_pd (_mm512_loadu_pd (data + i), g);
+        _mm512_storeu_pd (data + i, v);
+        lanes.add (v);
+        index = _mm512_add_pd (index, step);
+    }
+
+    auto stats = lanes.reduce();
+    _mm256_zeroupper();
+    rampRange (data, i, numSamples, start, increment, stats);
+    return stats.toSampleStats();
+}
+
+GAIN_KERNELS_TARGET ("avx512f")
+static SampleStats measureAVX512 (const double* data, int numSamples) noexcept
+{
+    DoubleStatsAVX512 lanes;
+    lanes.clear();
+    int i = 0;
+
+    for (; i + 8 <= numSamples; i += 8)
+        lanes.add (_mm512_loadu_pd (data + i));
+
+    auto stats = lanes.reduce();
+    _mm256_zeroupper();
+    measureRange (data, i, numSamples, stats);
+    return stats.toSampleStats();
+}
+
+GAIN_KERNELS_TARGET ("avx512f")
+static bool isSilentAVX512 (const double* data, int numSamples, double threshold) noexcept
+{
+    const auto t = _mm512_set1_pd (threshold);
+    int i = 0;
+
+    for (; i + 16 <= numSamples; i += 16)
+    {
+        const auto a = _mm512_cmp_pd_mask (_mm512_abs_pd (_mm512_loadu_pd (data + i)), t, _CMP_NLE_UQ);
+        const auto b = _mm512_cmp_pd_mask (_mm512_abs_pd (_mm512_loadu_pd (data + i + 8)), t, _CMP_NLE_UQ);
+
+        if ((a | b) != 0)
+        {
+            _mm256_zeroupper();
+            return false;
+        }
+    }
+
+    _mm256_zeroupper();
+    return isSilentRange (data, i, numSamples, threshold);
+}
+
+GAIN_KERNELS_TARGET ("avx512f")
+static void softClipAVX512 (double* data, int numSamples, double knee) noexcept
+{
+    const SoftClipCurve<double> curve (knee);
+    const auto k = _mm512_set1_pd (curve.knee), range = _mm512_set1_pd (curve.range), curvature = _mm512_set1_pd (curve.curvature);
+    const auto zero = _mm512_setzero_pd();
+    const auto signMask = _mm512_set1_epi64 ((long long) 0x8000000000000000ULL);
+    int i = 0;
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const auto x = _mm512_loadu_pd (data + i);
+        const auto magnitude = _mm512_abs_pd (x);
+        const auto over = _mm512_min_pd (range, _mm512_max_pd (zero, _mm512_sub_pd (magnitude, k)));
+        const auto shaped = _mm512_add_pd (_mm512_min_pd (k, magnitude), _mm512_sub_pd (over, _mm512_mul_pd (_mm512_mul_pd (over, over), curvature)));
+
+        // shaped is never negative, so the sign can just be or'ed back in
+        _mm512_storeu_pd (data + i, _mm512_castsi512_pd (_mm512_or_si512 (_mm512_castpd_si512 (shaped), _mm512_and_si512 (_mm512_castpd_si512 (x), signMask))));
+    }
+
+    _mm256_zeroupper();
+    softClipRange (data, i, numSamples, curve);
+}
+#endif
+
+#if GAIN_KERNELS_NEON
+//==============================================================================
+struct StatsNEON
+{
+    float32x4_t peak = vdupq_n_f32 (0.0f), squares = vdupq_n_f32 (0.0f);
+    uint32x4_t clipped = vdupq_n_u32 (0);
+
+    void add (float32x4_t v) noexcept
+    {
+        const auto magnitude = vabsq_f32 (v);
+
+        // vmaxq_f32 propagates NaNs, so select explicitly to match the scalar kernel
+        peak = vbslq_f32 (vcgtq_f32 (magnitude, peak), magnitude, peak);
+        squares = vaddq_f32 (squares, vmulq_f32 (v, v));
+        clipped = vsubq_u32 (clipped, vcgtq_f32 (magnitude, vdupq_n_f32 (1.0f)));
+    }
+
+    Totals<float> reduce() const noexcept
+    {
+        float peaks[4], sums[4];
+        juce::int32 counts[4];
+        vst1q_f32 (peaks, peak);
+        vst1q_f32 (sums, squares);
+        vst1q_s32 (counts, vreinterpretq_s32_u32 (clipped));
+        return reduceLanes (peaks, sums, counts, 4);
+    }
+};
+
+static SampleStats applyGainNEON (float* data, int numSamples, float gain) noexcept
+{
+    const auto g = vdupq_n_f32 (gain);
+    StatsNEON lanesA, lanesB;
+    int i = 0;
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const auto a = vmulq_f32 (vld1q_f32 (data + i), g);
+        const auto b = vmulq_f32 (vld1q_f32 (data + i + 4), g);
+        vst1q_f32 (data + i, a);
+        vst1q_f32 (data + i + 4, b);
+        lanesA.add (a);
+        lanesB.add (b);
+    }
+
+    auto stats = lanesA.reduce();
+    stats.merge (lanesB.reduce());
+    gainRange (data, i, numSamples, gain, stats);
+    return stats.toSampleStats();
+}
+
+static SampleStats applyGainRampNEON (float* data, int numSamples, float start, float increment) noexcept
+{
+    static const float firstIndices[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+    const auto s = vdupq_n_f32 (start);
+    const auto inc = vdupq_n_f32 (increment);
+    const auto step = vdupq_n_f32 (4.0f);
+    auto index = vld1q_f32 (firstIndices);
+    StatsNEON lanes;
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        const auto g = vaddq_f32 (s, vmulq_f32 (inc, index));
+        const auto v = vmulq_f32 (vld1q_f32 (data + i), g);
+        vst1q_f32 (data + i, v);
+        lanes.add (v);
+        index = vaddq_f32 (index, step);
+    }
+
+    auto stats = lanes.reduce();
+    rampRange (data, i, numSamples, start, increment, stats);
+    return stats.toSampleStats();
+}
+
+static SampleStats measureNEON (const float* data, int numSamples) noexcept
+{
+    StatsNEON lanesA, lanesB;
+    int i = 0;
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        lanesA.add (vld1q_f32 (data + i));
+        lanesB.add (vld1q_f32 (data + i + 4));
+    }
+
+    auto stats = lanesA.reduce();
+    stats.merge (lanesB.reduce());
+    measureRange (data, i, numSamples, stats);
+    return stats.toSampleStats();
+}
+
+static bool isSilentNEON (const float* data, int numSamples, float threshold) noexcept
+{
+    const auto t = vdupq_n_f32 (threshold);
+    int i = 0;
+
+    for (; i + 16 <= numSamples; i += 16)
+    {
+        // All ones in lanes that are silent, and NaNs compare false
+        const auto a = vcleq_f32 (vabsq_f32 (vld1q_f32 (data + i)), t);
+        const auto b = vcleq_f32 (vabsq_f32 (vld1q_f32 (data + i + 4)), t);
+        const auto c = vcleq_f32 (vabsq_f32 (vld1q_f32 (data + i + 8)), t);
+        const auto d = vcleq_f32 (vabsq_f32 (vld1q_f32 (data + i + 12)), t);
+        const auto all = vandq_u32 (vandq_u32 (a, b), vandq_u32 (c, d));
+
+        auto pair = vpmin_u32 (vget_low_u32 (all), vget_high_u32 (all));
+        pair = vpmin_u32 (pair, pair);
+
+        if (vget_lane_u32 (pair, 0) == 0)
+            return false;
+    }
+
+    return isSilentRange (data, i, numSamples, threshold);
+}
+
+static void softClipNEON (float* data, int numSamples, float knee) noexcept
+{
+    const SoftClipCurve<float> curve (knee);
+    const auto k = vdupq_n_f32 (curve.knee), range = vdupq_n_f32 (curve.range), curvature = vdupq_n_f32 (curve.curvature);
+    const auto zero = vdupq_n_f32 (0.0f), signMask = vdupq_n_u32 (0x80000000u);
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        const auto x = vld1q_f32 (data + i);
+        const auto magnitude = vabsq_f32 (x);
+        const auto excess = vsubq_f32 (magnitude, k);
+
+        // Selects rather than vminq/vmaxq, which propagate NaNs, as in the stats
+        const auto floored = vbslq_f32 (vcltq_f32 (excess, zero), zero, excess);
+        const auto over = vbslq_f32 (vcgtq_f32 (floored, range), range, floored);
+        const auto below = vbslq_f32 (vcgtq_f32 (magnitude, k), k, magnitude);
+        const auto shaped = vaddq_f32 (below, vsubq_f32 (over, vmulq_f32 (vmulq_f32 (over, over), curvature)));
+        vst1q_f32 (data + i, vbslq_f32 (signMask, x, shaped));
+    }
+
+    softClipRange (data, i, numSamples, curve);
+}
+
+// As the SSE2 version: four channels at a time, in 4x4 tiles
+static inline void transposeNEON (float32x4_t& r0, float32x4_t& r1, float32x4_t& r2, float32x4_t& r3) noexcept
+{
+    const auto t01 = vtrnq_f32 (r0, r1);
+    const auto t23 = vtrnq_f32 (r2, r3);
+    r0 = vcombine_f32 (vget_low_f32 (t01.val[0]), vget_low_f32 (t23.val[0]));
+    r1 = vcombine_f32 (vget_low_f32 (t01.val[1]), vget_low_f32 (t23.val[1]));
+    r2 = vcombine_f32 (vget_high_f32 (t01.val[0]), vget_high_f32 (t23.val[0]));
+    r3 = vcombine_f32 (vget_high_f32 (t01.val[1]), vget_high_f32 (t23.val[1]));
+}
+
+static void applyGainAcrossChannelsNEON (float* const* channels, int numChannels, int startSample, int numSamples,
+                                         float start, float increment, ChannelStats& stats) noexcept
+{
+    StatsNEON lanes;
+    int channel = 0;
+
+    for (; channel + 4 <= numChannels; channel += 4)
+    {
+        float* const ch0 = channels[channel] + startSample;
+        float* const ch1 = channels[channel + 1] + startSample;
+        float* const ch2 = channels[channel + 2] + startSample;
+        float* const ch3 = channels[channel + 3] + startSample;
+
+        lanes.peak = vld1q_f32 (stats.peaks.data() + channel);
+        lanes.clipped = vreinterpretq_u32_s32 (vld1q_s32 (stats.numClipped.data() + channel));
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            auto r0 = vld1q_f32 (ch0 + i), r1 = vld1q_f32 (ch1 + i);
+            auto r2 = vld1q_f32 (ch2 + i), r3 = vld1q_f32 (ch3 + i);
+            transposeNEON (r0, r1, r2, r3);
+
+            r0 = vmulq_f32 (r0, vdupq_n_f32 (start + increment * (float) i));
+            r1 = vmulq_f32 (r1, vdupq_n_f32 (start + increment * (float) (i + 1)));
+            r2 = vmulq_f32 (r2, vdupq_n_f32 (start + increment * (float) (i + 2)));
+            r3 = vmulq_f32 (r3, vdupq_n_f32 (start + increment * (float) (i + 3)));
+            lanes.add (r0);
+            lanes.add (r1);
+            lanes.add (r2);
+            lanes.add (r3);
+
+            transposeNEON (r0, r1, r2, r3);
+            vst1q_f32 (ch0 + i, r0);
+            vst1q_f32 (ch1 + i, r1);
+            vst1q_f32 (ch2 + i, r2);
+            vst1q_f32 (ch3 + i, r3);
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            const auto gain = start + increment * (float) i;
+            ch0[i] *= gain;
+            ch1[i] *= gain;
+            ch2[i] *= gain;
+            ch3[i] *= gain;
+
+            const float column[4] = { ch0[i], ch1[i], ch2[i], ch3[i] };
+            lanes.add (vld1q_f32 (column));
+        }
+
+        vst1q_f32 (stats.peaks.data() + channel, lanes.peak);
+        vst1q_s32 (stats.numClipped.data() + channel, vreinterpretq_s32_u32 (lanes.clipped));
+    }
+
+    float sums[4];
+    vst1q_f32 (sums, lanes.squares);
+    stats.sumOfSquares += (sums[0] + sums[1]) + (sums[2] + sums[3]);
+
+    rampChannels (channels, channel, numChannels, startSample, numSamples, start, increment, stats);
+}
+
+static void applyMidSideNEON (float* left, float* right, int numSamples, float directStart, float directIncrement,
+                              float crossStart, float crossIncrement, SampleStats& leftStats, SampleStats& rightStats) noexcept
+{
+    static const float firstIndices[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+    const auto ds = vdupq_n_f32 (directStart), di = vdupq_n_f32 (directIncrement);
+    const auto cs = vdupq_n_f32 (crossStart), ci = vdupq_n_f32 (crossIncrement);
+    const auto step = vdupq_n_f32 (4.0f);
+    auto index = vld1q_f32 (firstIndices);
+    StatsNEON leftLanes, rightLanes;
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        const auto direct = vaddq_f32 (ds, vmulq_f32 (di, index));
+        const auto cross = vaddq_f32 (cs, vmulq_f32 (ci, index));
+        const auto l = vld1q_f32 (left + i);
+        const auto r = vld1q_f32 (right + i);
+        const auto newLeft = vaddq_f32 (vmulq_f32 (direct, l), vmulq_f32 (cross, r));
+        const auto newRight = vaddq_f32 (vmulq_f32 (cross, l), vmulq_f32 (direct, r));
+        vst1q_f32 (left + i, newLeft);
+        vst1q_f32 (right + i, newRight);
+        leftLanes.add (newLeft);
+        rightLanes.add (newRight);
+        index = vaddq_f32 (index, step);
+    }
+
+    auto leftTotals = leftLanes.reduce();
+    auto rightTotals = rightLanes.reduce();
+    midSideRange (left, right, i, numSamples, directStart, directIncrement, crossStart, crossIncrement, leftTotals, rightTotals);
+    leftStats = leftTotals.toSampleStats();
+    rightStats = rightTotals.toSampleStats();
+}
+#endif
+
+#if GAIN_KERNELS_NEON_DOUBLE
+//==============================================================================
+struct DoubleStatsNEON
+{
+    float64x2_t peak = vdupq_n_f64 (0.0), squares = vdupq_n_f64 (0.0);
+    uint64x2_t clipped = vdupq_n_u64 (0);
+
+    void add (float64x2_t v) noexcept
+    {
+        const auto magnitude = vabsq_f64 (v);
+        peak = vbslq_f64 (vcgtq_f64 (magnitude, peak), magnitude, peak);
+        squares = vaddq_f64 (squares, vmulq_f64 (v, v));
+        clipped = vsubq_u64 (clipped, vcgtq_f64 (magnitude, vdupq_n_f64 (1.0)));
+    }
+
+    Totals<double> reduce() const noexcept
+    {
+        double peaks[2], sums[2];
+        juce::int64 counts[2];
+        vst1q_f64 (peaks, peak);
+        vst1q_f64 (sums, squares);
+        vst1q_s64 (counts, vreinterpretq_s64_u64 (clipped));
+        return reduceLanes (peaks, sums, counts, 2);
+    }
+};
+
+static SampleStats applyGainNEON (double* data, int numSamples, double gain) noexcept
+{
+    const auto g = vdupq_n_f64 (gain);
+    DoubleStatsNEON lanesA, lanesB;
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        const auto a = vmulq_f64 (vld1q_f64 (data + i), g);
+        const auto b = vmulq_f64 (vld1q_f64 (data + i + 2), g);
+        vst1q_f64 (data + i, a);
+        vst1q_f64 (data + i + 2, b);
+        lanesA.add (a);
+        lanesB.add (b);
+    }
+
+    auto stats = lanesA.reduce();
+    stats.merge (lanesB.reduce());
+    gainRange (data, i, numSamples, gain, stats);
+    return stats.toSampleStats();
+}
+
+static SampleStats applyGainRampNEON (double* data, int numSamples, double start, double increment) noexcept
+{
+    static const double firstIndices[2] = { 0.0, 1.0 };
+    const auto s = vdupq_n_f64 (start);
+    const auto inc = vdupq_n_f64 (increment);
+    const auto step = vdupq_n_f64 (2.0);
+    auto index = vld1q_f64 (firstIndices);
+    DoubleStatsNEON lanes;
+    int i = 0;
+
+    for (; i + 2 <= numSamples; i += 2)
+    {
+        const auto g = vaddq_f64 (s, vmulq_f64 (inc, index));
+        const auto v = vmulq_f64 (vld1q_f64 (data + i), g);
+        vst1q_f64 (data + i, v);
+        lanes.add (v);
+        index = vaddq_f64 (index, step);
+    }
+
+    auto stats = lanes.reduce();
+    rampRange (data, i, numSamples, start, increment, stats);
+    return stats.toSampleStats();
+}
+
+static SampleStats measureNEON (const double* data, int numSamples) noexcept
+{
+    DoubleStatsNEON lanesA, lanesB;
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        lanesA.add (vld1q_f64 (data + i));
+        lanesB.add (vld1q_f64 (data + i + 2));
+    }
+
+    auto stats = lanesA.reduce();
+    stats.merge (lanesB.reduce());
+    measureRange (data, i, numSamples, stats);
+    return stats.toSampleStats();
+}
+
+static bool isSilentNEON (const double* data, int numSamples, double threshold) noexcept
+{
+    const auto t = vdupq_n_f64 (threshold);
+    int i = 0;
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const auto a = vcleq_f64 (vabsq_f64 (vld1q_f64 (data + i)), t);
+        const auto b = vcleq_f64 (vabsq_f64 (vld1q_f64 (data + i + 2)), t);
+        const auto c = vcleq_f64 (vabsq_f64 (vld1q_f64 (data + i + 4)), t);
+        const auto d = vcleq_f64 (vabsq_f64 (vld1q_f64 (data + i + 6)), t);
+        const auto all = vandq_u64 (vandq_u64 (a, b), vandq_u64 (c, d));
+
+        if ((vgetq_lane_u64 (all, 0) & vgetq_lane_u64 (all, 1)) == 0)
+            return false;
+    }
+
+    return isSilentRange (data, i, numSamples, threshold);
+}
+
+static void softClipNEON (double* data, int numSamples, double knee) noexcept
+{
+    const SoftClipCurve<double> curve (knee);
+    const auto k = vdupq_n_f64 (curve.knee), range = vdupq_n_f64 (curve.range), curvature = vdupq_n_f64 (curve.curvature);
+    const auto zero = vdupq_n_f64 (0.0), signMask = vdupq_n_u64 (0x8000000000000000ull);
+    int i = 0;
+
+    for (; i + 2 <= numSamples; i += 2)
+    {
+        const auto x = vld1q_f64 (data + i);
+        const auto magnitude = vabsq_f64 (x);
+        const auto excess = vsubq_f64 (magnitude, k);
+
+        // Selects rather than vminq/vmaxq, which propagate NaNs, as in the stats
+        const auto floored = vbslq_f64 (vcltq_f64 (excess, zero), zero, excess);
+        const auto over = vbslq_f64 (vcgtq_f64 (floored, range), range, floored);
+        const auto below = vbslq_f64 (vcgtq_f64 (magnitude, k), k, magnitude);
+        const auto shaped = vaddq_f64 (below, vsubq_f64 (over, vmulq_f64 (vmulq_f64 (over, over), curvature)));
+        vst1q_f64 (data + i, vbslq_f64 (signMask, x, shaped));
+    }
+
+    softClipRange (data, i, numSamples, curve);
+}
+
+static void applyGainAcrossChannelsNEON (double* const* channels, int numChannels, int startSample, int numSamples,
+                                         double start, double increment, ChannelStats& stats) noexcept
+{
+    DoubleStatsNEON lanes;
+    int channel = 0;
+
+    for (; channel + 2 <= numChannels; channel += 2)
+    {
+        double* const ch0 = channels[channel] + startSample;
+        double* const ch1 = channels[channel + 1] + startSample;
+        float* const peaks = stats.peaks.data() + channel;
+        int* const clipped = stats.numClipped.data() + channel;
+
+        lanes.peak = vcvt_f64_f32 (vld1_f32 (peaks));
+        lanes.clipped = vreinterpretq_u64_s64 (vmovl_s32 (vld1_s32 (clipped)));
+        int i = 0;
+
+        for (; i + 2 <= numSamples; i += 2)
+        {
+            const auto a = vld1q_f64 (ch0 + i), b = vld1q_f64 (ch1 + i);
+            const auto first = vmulq_f64 (vzip1q_f64 (a, b), vdupq_n_f64 (start + increment * (double) i));
+            const auto second = vmulq_f64 (vzip2q_f64 (a, b), vdupq_n_f64 (start + increment * (double) (i + 1)));
+            lanes.add (first);
+            lanes.add (second);
+
+            vst1q_f64 (ch0 + i, vzip1q_f64 (first, second));
+            vst1q_f64 (ch1 + i, vzip2q_f64 (first, second));
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            const auto gain = start + increment * (double) i;
+            ch0[i] *= gain;
+            ch1[i] *= gain;
+
+            const double column[2] = { ch0[i], ch1[i] };
+            lanes.add (vld1q_f64 (column));
+        }
+
+        vst1_f32 (peaks, vcvt_f32_f64 (lanes.peak));
+        vst1_s32 (clipped, vmovn_s64 (vreinterpretq_s64_u64 (lanes.clipped)));
+    }
+
+    double sums[2];
+    vst1q_f64 (sums, lanes.squares);
+    stats.sumOfSquares += (float) (sums[0] + sums[1]);
+
+    rampChannels (channels, channel, numChannels, startSample, numSamples, start, increment, stats);
+}
+
+static void applyMidSideNEON (double* left, double* right, int numSamples, double directStart, double directIncrement,
+                              double crossStart, double crossIncrement, SampleStats& leftStats, SampleStats& rightStats) noexcept
+{
+    static const double firstIndices[2] = { 0.0, 1.0 };
+    const auto ds = vdupq_n_f64 (directStart), di = vdupq_n_f64 (directIncrement);
+    const auto cs = vdupq_n_f64 (crossStart), ci = vdupq_n_f64 (crossIncrement);
+    const auto step = vdupq_n_f64 (2.0);
+    auto index = vld1q_f64 (firstIndices);
+    DoubleStatsNEON leftLanes, rightLanes;
+    int i = 0;
+
+    for (; i + 2 <= numSamples; i += 2)
+    {
+        const auto direct = vaddq_f64 (ds, vmulq_f64 (di, index));
+        const auto cross = vaddq_f64 (cs, vmulq_f64 (ci, index));
+        const auto l = vld1q_f64 (left + i);
+        const auto r = vld1q_f64 (right + i);
+        const auto newLeft = vaddq_f64 (vmulq_f64 (direct, l), vmulq_f64 (cross, r));
+        const auto newRight = vaddq_f64 (vmulq_f64 (cross, l), vmulq_f64 (direct, r));
+        vst1q_f64 (left + i, newLeft);
+        vst1q_f64 (right + i, newRight);
+        leftLanes.add (newLeft);
+        rightLanes.add (newRight);
+        index = vaddq_f64 (index, step);
+    }
+
+    auto leftTotals = leftLanes.reduce();
+    auto rightTotals = rightLanes.reduce();
+    midSideRange (left, right, i, numSamples, directStart, directIncrement, crossStart, crossIncrement, leftTotals, rightTotals);
+    leftStats = leftTotals.toSampleStats();
+    rightStats = rightTotals.toSampleStats();
+}
+#endif
+
+//==============================================================================
+static const GainKernels<float> scalarKernels { applyGainScalar<float>, applyGainRampScalar<float>, measureScalar<float>, isSilentScalar<float>,
+                                                applyGainAcrossChannelsScalar<float>, softClipScalar<float>, applyMidSideScalar<float> };
+static const GainKernels<double> scalarDoubleKernels { applyGainScalar<double>, applyGainRampScalar<double>, measureScalar<double>, isSilentScalar<double>,
+                                                       applyGainAcrossChannelsScalar<double>, softClipScalar<double>, applyMidSideScalar<double> };
+
+// The AVX-512 tables use the AVX2 mid/side kernels: with two streams in and out, the
+// wider vectors don't make them any quicker
+#if GAIN_KERNELS_X86
+static const GainKernels<float> sse2Kernels     { applyGainSSE2,   applyGainRampSSE2,   measureSSE2,   isSilentSSE2,   applyGainAcrossChannelsSSE2, softClipSSE2,   applyMidSideSSE2 };
+static const GainKernels<float> avx2Kernels     { applyGainAVX2,   applyGainRampAVX2,   measureAVX2,   isSilentAVX2,   applyGainAcrossChannelsSSE2, softClipAVX2,   applyMidSideAVX2 };
+static const GainKernels<float> avx512Kernels   { applyGainAVX512, applyGainRampAVX512, measureAVX512, isSilentAVX512, applyGainAcrossChannelsSSE2, softClipAVX512, applyMidSideAVX2 };
+
+static const GainKernels<double> sse2DoubleKernels   { applyGainSSE2,   applyGainRampSSE2,   measureSSE2,   isSilentSSE2,   applyGainAcrossChannelsSSE2, softClipSSE2,   applyMidSideSSE2 };
+static const GainKernels<double> avx2DoubleKernels   { applyGainAVX2,   applyGainRampAVX2,   measureAVX2,   isSilentAVX2,   applyGainAcrossChannelsSSE2, softClipAVX2,   applyMidSideAVX2 };
+static const GainKernels<double> avx512DoubleKernels { applyGainAVX512, applyGainRampAVX512, measureAVX512, isSilentAVX512, applyGainAcrossChannelsSSE2, softClipAVX512, applyMidSideAVX2 };
+#endif
+
+#if GAIN_KERNELS_NEON
+static const GainKernels<float> neonKernels     { applyGainNEON,   applyGainRampNEON,   measureNEON,   isSilentNEON,   applyGainAcrossChannelsNEON, softClipNEON, applyMidSideNEON };
+#endif
+
+#if GAIN_KERNELS_NEON_DOUBLE
+static const GainKernels<double> neonDoubleKernels   { applyGainNEON,   applyGainRampNEON,   measureNEON,   isSilentNEON,   applyGainAcrossChannelsNEON, softClipNEON, applyMidSideNEON };
+#endif
+
+// The tables built for each type, or nullptr where an instruction set has none
+static const GainKernels<float>* findKernels (GainKernelISA isa, float*) noexcept
+{
+    switch (isa)
+    {
+       #if GAIN_KERNELS_X86
+        case GainKernelISA::sse2:   return &sse2Kernels;
+        case GainKernelISA::avx2:   return &avx2Kernels;
+        case GainKernelISA::avx512: return &avx512Kernels;
+       #endif
+       #if GAIN_KERNELS_NEON
+        case GainKernelISA::neon:   return &neonKernels;
+       #endif
+        case GainKernelISA::scalar: return &scalarKernels;
+        default:                    return nullptr;
+    }
+}
+
+static const GainKernels<double>* findKernels (GainKernelISA isa, double*) noexcept
+{
+    switch (isa)
+    {
+       #if GAIN_KERNELS_X86
+        case GainKernelISA::sse2:   return &sse2DoubleKernels;
+        case GainKernelISA::avx2:   return &avx2DoubleKernels;
+        case GainKernelISA::avx512: return &avx512DoubleKernels;
+       #endif
+       #if GAIN_KERNELS_NEON_DOUBLE
+        case GainKernelISA::neon:   return &neonDoubleKernels;
+       #endif
+        case GainKernelISA::scalar: return &scalarDoubleKernels;
+        default:                    return nullptr;
+    }
+}
+
+template <typename SampleType>
+const GainKernels<SampleType>& GainKernels<SampleType>::forISA (GainKernelISA isa) noexcept
+{
+    const auto* kernels = GainKernelSupport::isAvailable (isa) ? findKernels (isa, (SampleType*) nullptr) : nullptr;
+    return kernels != nullptr ? *kernels : *findKernels (GainKernelISA::scalar, (SampleType*) nullptr);
+}
+
+template struct GainKernels<float>;
+template struct GainKernels<double>;
+
+//==============================================================================
+bool GainKernelSupport::isAvailable (GainKernelISA isa) noexcept
+{
+    switch (isa)
+    {
+        case GainKernelISA::scalar: return true;
+       #if GAIN_KERNELS_X86
+        case GainKernelISA::sse2:   return juce::SystemStats::hasSSE2();
+        case GainKernelISA::avx2:   return juce::SystemStats::hasAVX2();
+        case GainKernelISA::avx512: return juce::SystemStats::hasAVX512F();
+       #endif
+       #if GAIN_KERNELS_NEON
+        case GainKernelISA::neon:   return true;
+       #endif
+        default:                    return false;
+    }
+}
+
+GainKernelISA GainKernelSupport::getBestAvailableISA() noexcept
+{
+    for (auto isa : { GainKernelISA::avx512, GainKernelISA::avx2, GainKernelISA::sse2, GainKernelISA::neon })
+        if (isAvailable (isa))
+            return isa;
+
+    return GainKernelISA::scalar;
+}
+
+const char* GainKernelSupport::getISAName (GainKernelISA isa) noexcept
+{
+    switch (isa)
+    {
+        case GainKernelISA::sse2:   return "sse2";
+        case GainKernelISA::avx2:   return "avx2";
+        case GainKernelISA::avx512: return "avx512";
+        case GainKernelISA::neon:   return "neon";
+        case GainKernelISA::scalar:
+        default:                    return "scalar";
+    }
+}
@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+    GainKernels.h
+    Vectorised gain + metering kernels, dispatched on the host CPU's instruction set.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** The instruction sets the gain kernels can be built for. */
+enum class GainKernelISA
+{
+    scalar,
+    sse2,
+    avx2,
+    avx512,
+    neon
+};
+
+//==============================================================================
+/** What the kernels measure on the way through a block, for the meters. */
+struct SampleStats
+{
+    float peak = 0.0f;          // largest absolute sample
+    float sumOfSquares = 0.0f;
+    int numClipped = 0;         // samples above full scale
+
+    void merge (const SampleStats& other) noexcept
+    {
+        peak = std::max (peak, other.peak);
+        sumOfSquares += other.sumOfSquares;
+        numClipped += other.numClipped;
+    }
+};
+
+//==============================================================================
+/**
+    Per-channel peaks and clip counts for a block, plus the energy across all its
+    channels.
+
+    The channels are kept as separate arrays rather than an array of SampleStats, so
+    that a row of meters reads contiguously and the cross-channel kernel can load and
+    store a vector's worth of channels at once.
+*/
+struct ChannelStats
+{
+    static constexpr int maxChannels = 128;
+
+    std::array<float, maxChannels> peaks {};
+    std::array<int, maxChannels> numClipped {};
+    float sumOfSquares = 0.0f;
+
+    void add (int channel, const SampleStats& stats) noexcept
+    {
+        peaks[(size_t) channel] = std::max (peaks[(size_t) channel], stats.peak);
+        numClipped[(size_t) channel] += stats.numClipped;
+        sumOfSquares += stats.sumOfSquares;
+    }
+
+    /** Folds the first numChannels channels into one. */
+    SampleStats combine (int numChannels) const noexcept
+    {
+        SampleStats stats;
+        stats.sumOfSquares = sumOfSquares;
+
+        for (int i = 0; i < numChannels; ++i)
+        {
+            stats.peak = std::max (stats.peak, peaks[(size_t) i]);
+            stats.numClipped += numClipped[(size_t) i];
+        }
+
+        return stats;
+    }
+};
+
+//==============================================================================
+/** Which instruction sets this build and this CPU can use, whatever the sample type. */
+struct GainKernelSupport
+{
+    /** Returns the fastest instruction set that this CPU supports. */
+    static GainKernelISA getBestAvailableISA() noexcept;
+
+    /** Returns true if this build contains the kernels for isa and this CPU can run them. */
+    static bool isAvailable (GainKernelISA isa) noexcept;
+
+    /** Returns a short display name, e.g. "avx2". */
+    static const char* getISAName (GainKernelISA isa) noexcept;
+};
+
+//==============================================================================
+/**
+    A table of processing kernels for one instruction set and sample type (float or
+    double, so that the double-precision path runs natively rather than converting).
+
+    The processor picks a table once in prepareToPlay(), so the audio thread only
+    pays for one indirect call per channel. The scalar table is always available
+    and is the reference every other table has to match: bit-for-bit for the
+    output samples, peak and clip count, and to rounding for sumOfSquares.
+*/
+template <typename SampleType>
+struct GainKernels
+{
+    /** Multiplies the samples in place by gain and measures the result. */
+    SampleStats (*applyGain) (SampleType* data, int numSamples, SampleType gain) noexcept;
+
+    /** Multiplies sample i in place by (start + increment * i) and measures the result. */
+    SampleStats (*applyGainRamp) (SampleType* data, int numSamples, SampleType start, SampleType increment) noexcept;
+
+    /** Measures the samples without modifying them. */
+    SampleStats (*measure) (const SampleType* data, int numSamples) noexcept;
+
+    /** Returns true if no sample's magnitude is above threshold (NaNs count as above).
+        Returns as soon as it finds one that is, so a loud block costs almost nothing.
+    */
+    bool (*isSilent) (const SampleType* data, int numSamples, SampleType threshold) noexcept;
+
+    /** Multiplies sample startSample + i of each of the first numChannels channels in
+        place by (start + increment * i), and adds each channel's peak and clip count to
+        stats. An increment of zero is a fixed gain, and matches applyGain() exactly.
+
+        This one is vectorised across the channels instead of along them, so it keeps
+        its lanes busy on blocks too short for the other kernels to fill a vector.
+    */
+    void (*applyGainAcrossChannels) (SampleType* const* channels, int numChannels, int startSample, int numSamples,
+                                     SampleType start, SampleType increment, ChannelStats& stats) noexcept;
+
+    /** Soft-clips the samples in place: unchanged up to knee (which must be below 1),
+        then bent over by a quadratic that meets the straight line with the same slope
+        and flattens out at exactly 1 by 2 - knee. Nothing ever comes out above 1.
+    */
+    void (*softClip) (SampleType* data, int numSamples, SampleType knee) noexcept;
+
+    /** Gains the mid and side of a stereo pair separately, in place and in one pass:
+        encoding, the two gains and decoding fold into one symmetric matrix, so each
+        left sample becomes direct * left + cross * right and each right sample
+        cross * left + direct * right, where direct = (midGain + sideGain) / 2 and
+        cross = (midGain - sideGain) / 2. Both coefficients move from their start by
+        their increment per sample, as in applyGainRamp(), and each channel's
+        measurements go into its own stats.
+    */
+    void (*applyMidSide) (SampleType* left, SampleType* right, int numSamples, SampleType directStart, SampleType directIncrement,
+                          SampleType crossStart, SampleType crossIncrement, SampleStats& leftStats, SampleStats& rightStats) noexcept;
+
+    //==============================================================================
+    /** Returns the kernels for isa, or the scalar ones if isa isn't available, or has
+        no kernels for this sample type (double on 32-bit ARM).
+    */
+    static const GainKernels& forISA (GainKernelISA isa) noexcept;
+};
+
+extern template struct GainKernels<float>;
+extern template struct GainKernels<double>;
@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    GainSmoother.h
+    Linear gain ramps handed out a segment at a time.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Smooths gain changes with a linear ramp, like juce::SmoothedValue, but hands
+    the ramp out as whole segments (start value + per-sample increment) so that a
+    vector kernel can apply it, instead of asking for one value per sample.
+
+    All of this is plain state owned by the audio thread; the parameter's atomic
+    is read once per block by the caller and passed to setTargetValue().
+*/
+class GainSmoother
+{
+public:
+    /** A run of samples whose gain is start + increment * index. */
+    struct Ramp
+    {
+        float start = 1.0f;
+        float increment = 0.0f;
+        int numSamples = 0;
+    };
+
+    //==============================================================================
+    /** Sets the ramp length and jumps straight to the current target. */
+    void reset (double sampleRate, double rampLengthSeconds) noexcept
+    {
+        rampLengthSamples = juce::jmax (1, juce::roundToInt (sampleRate * rampLengthSeconds));
+        setCurrentAndTargetValue (target);
+    }
+
+    /** Jumps to newValue without ramping. */
+    void setCurrentAndTargetValue (float newValue) noexcept
+    {
+        current = target = newValue;
+        increment = 0.0f;
+        samplesRemaining = 0;
+        samplesDone = 0;
+    }
+
+    /** Starts a new ramp from wherever the current one has got to. */
+    void setTargetValue (float newValue) noexcept
+    {
+        setTargetValue (newValue, rampLengthSamples);
+    }
+
+    /** Starts a ramp that reaches newValue after exactly numRampSamples samples.
+        This is used for host automation, where the time of each point is known.
+    */
+    void setTargetValue (float newValue, int numRampSamples) noexcept
+    {
+        if (newValue == target && ! isSmoothing())
+            return;
+
+        jassert (numRampSamples > 0);
+
+        current = getCurrentValue();
+        target = newValue;
+        samplesRemaining = juce::jmax (1, numRampSamples);
+        samplesDone = 0;
+        increment = (target - current) / (float) samplesRemaining;
+    }
+
+    //==============================================================================
+    bool isSmoothing() const noexcept       { return samplesRemaining > 0; }
+    float getTargetValue() const noexcept   { return target; }
+
+    float getCurrentValue() const noexcept
+    {
+        return isSmoothing() ? current + increment * (float) samplesDone : target;
+    }
+
+    /** Returns the next part of the ramp, at most maxSamples long, and advances past it.
+        Once the ramp runs out this returns an empty segment and the gain sits at the
+        exact target value.
+    */
+    Ramp takeRamp (int maxSamples) noexcept
+    {
+        Ramp ramp { getCurrentValue(), increment, juce::jmin (maxSamples, samplesRemaining) };
+
+        samplesRemaining -= ramp.numSamples;
+        samplesDone += ramp.numSamples;
+
+        if (samplesRemaining == 0)
+            current = target;
+
+        return ramp;
+    }
+
+private:
+    //==============================================================================
+    float current = 1.0f, target = 1.0f, increment = 0.0f;
+    int rampLengthSamples = 1, samplesRemaining = 0, samplesDone = 0;
+};
@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    LayerCache.h
+    A pre-rendered image of something that only changes with its size.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Keeps a drawing as an image at the display's physical pixel scale, so painting
+    it again is a blit rather than a redraw of its paths and glows.
+
+    The image is redrawn when the area's size or the display scale changes (e.g. the
+    window moved to another monitor), or after invalidate().
+*/
+class LayerCache
+{
+public:
+    /** Draws the cached layer into area, first calling drawLayer to render it if the
+        cache is out of date. drawLayer gets a Graphics whose origin is the area's
+        top-left corner.
+    */
+    template <typename DrawLayer>
+    void draw (juce::Graphics& g, juce::Rectangle<int> area, DrawLayer&& drawLayer)
+    {
+        if (area.isEmpty())
+            return;
+
+        const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+        if (image.isNull() || area.getWidth() != width || area.getHeight() != height || scale != imageScale)
+        {
+            width = area.getWidth();
+            height = area.getHeight();
+            imageScale = scale;
+
+            image = juce::Image (juce::Image::ARGB,
+                                 juce::jmax (1, juce::roundToInt ((float) width * scale)),
+                                 juce::jmax (1, juce::roundToInt ((float) height * scale)),
+                                 true);
+
+            juce::Graphics imageGraphics (image);
+            imageGraphics.addTransform (juce::AffineTransform::scale (scale));
+            drawLayer (imageGraphics);
+        }
+
+        g.drawImageTransformed (image, juce::AffineTransform::scale (1.0f / imageScale)
+                                                             .translated ((float) area.getX(), (float) area.getY()));
+    }
+
+    void invalidate()       { image = {}; }
+
+private:
+    juce::Image image;
+    int width = 0, height = 0;
+    float imageScale = 1.0f;
+};
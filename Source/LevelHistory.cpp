@@ -0,0 +1,170 @@
+/*
+  ==============================================================================
+
+    LevelHistory.cpp
+    Minutes of output level kept as a min/max pyramid, with timestamped clips.
+
+  ==============================================================================
+*/
+
+#include "LevelHistory.h"
+
+//==============================================================================
+LevelHistory::LevelHistory (double retention)
+{
+    setRetention (retention);
+}
+
+void LevelHistory::setRetention (double seconds)
+{
+    retentionSeconds = juce::jmax (1.0, seconds);
+    const auto numBaseBuckets = (juce::int64) std::ceil (retentionSeconds * bucketsPerSecond);
+
+    // Up to the level where one bucket spans the whole window. Each level has room
+    // for a partly filled bucket at either end of the window as well.
+    levels.clear();
+
+    for (int shift = 0;; shift += decimationShift)
+    {
+        Level level;
+        level.shift = shift;
+        level.buckets.resize ((size_t) (numBaseBuckets >> shift) + 2);
+        levels.push_back (std::move (level));
+
+        if ((numBaseBuckets >> shift) <= 1)
+            break;
+    }
+
+    clear();
+}
+
+void LevelHistory::clear()
+{
+    for (auto& level : levels)
+        level.numWritten = 0;
+
+    clips.clear();
+    endSeconds = 0.0;
+    endPosition = -1;
+    ++changeCount;
+}
+
+//==============================================================================
+void LevelHistory::addFrame (const MeterFrame& frame, double sampleRate)
+{
+    if (sampleRate <= 0.0 || frame.numSamples <= 0)
+        return;
+
+    // Blocks skipped as silent publish no frame, so they show up as a gap in the
+    // positions and stay in the history as one. A position that goes backwards means
+    // the processor was prepared again, and the history just carries on.
+    if (endPosition >= 0 && frame.samplePosition > endPosition)
+        endSeconds += (double) (frame.samplePosition - endPosition) / sampleRate;
+
+    const auto startSeconds = endSeconds;
+    endSeconds += (double) frame.numSamples / sampleRate;
+    endPosition = frame.samplePosition + frame.numSamples;
+
+    const bool clipped = frame.numClippedSamples > 0 || frame.truePeak > 1.0f;
+    const Range range { frame.peak, std::max (frame.peak, frame.truePeak), clipped };
+
+    // A frame that stands for a long stretch (the telemetry merges frames while the
+    // message thread is held up) only needs the buckets still in the window
+    const auto numBaseBuckets = (juce::int64) levels.front().buckets.size() - 2;
+    const auto lastBucket = juce::jmax ((juce::int64) 0, (juce::int64) std::ceil (endSeconds * bucketsPerSecond) - 1);
+    const auto firstBucket = juce::jlimit (lastBucket - numBaseBuckets + 1, lastBucket,
+                                           (juce::int64) std::floor (startSeconds * bucketsPerSecond));
+
+    for (auto bucket = firstBucket; bucket <= lastBucket; ++bucket)
+        addToBucket (bucket, range);
+
+    if (clipped)
+    {
+        // Back-to-back clipping blocks make one clip
+        if (! clips.empty() && clips.back().endSeconds >= startSeconds)
+        {
+            clips.back().endSeconds = endSeconds;
+            clips.back().numClippedSamples += frame.numClippedSamples;
+        }
+        else
+        {
+            clips.push_back ({ startSeconds, endSeconds, frame.numClippedSamples });
+
+            if ((int) clips.size() > maxClips)
+                clips.pop_front();
+        }
+    }
+
+    while (! clips.empty() && clips.front().endSeconds < getStartSeconds())
+        clips.pop_front();
+
+    ++changeCount;
+}
+
+void LevelHistory::addToBucket (juce::int64 baseIndex, const Range& range)
+{
+    for (auto& level : levels)
+    {
+        const auto index = baseIndex >> level.shift;
+        const auto size = (juce::int64) level.buckets.size();
+
+        // Buckets are reused as the window moves on, and any skipped over are emptied
+        if (index >= level.numWritten)
+        {
+            for (auto stale = juce::jmax (level.numWritten, index - size + 1); stale <= index; ++stale)
+                level.buckets[(size_t) (stale % size)] = {};
+
+            level.numWritten = index + 1;
+        }
+
+        level.buckets[(size_t) (index % size)].merge (range);
+    }
+}
+
+const LevelHistory::Range* LevelHistory::findBucket (const Level& level, juce::int64 index) const noexcept
+{
+    const auto size = (juce::int64) level.buckets.size();
+
+    if (index < 0 || index >= level.numWritten || index < level.numWritten - size)
+        return nullptr;
+
+    return &level.buckets[(size_t) (index % size)];
+}
+
+//==============================================================================
+void LevelHistory::getRanges (double start, double end, Range* pixels, int numPixels) const
+{
+    if (numPixels <= 0)
+        return;
+
+    // The coarsest level whose buckets are no wider than a pixel, so each pixel
+    // takes at most a few more than `decimation` buckets
+    const auto baseBucketsPerPixel = (end - start) * bucketsPerSecond / numPixels;
+    size_t levelIndex = 0;
+
+    while (levelIndex + 1 < levels.size() && (double) ((juce::int64) 1 << levels[levelIndex + 1].shift) <= baseBucketsPerPixel)
+        ++levelIndex;
+
+    const auto& level = levels[levelIndex];
+    const auto levelBucketsPerSecond = (double) bucketsPerSecond / (double) ((juce::int64) 1 << level.shift);
+    const auto oldest = getStartSeconds();
+
+    for (int i = 0; i < numPixels; ++i)
+    {
+        const auto pixelStart = start + (end - start) * i / numPixels;
+        const auto pixelEnd = start + (end - start) * (i + 1) / numPixels;
+        Range range;
+
+        if (pixelEnd > oldest && pixelStart < endSeconds)
+        {
+            const auto first = (juce::int64) std::floor (pixelStart * levelBucketsPerSecond);
+            const auto last = juce::jmax (first, (juce::int64) std::ceil (pixelEnd * levelBucketsPerSecond) - 1);
+
+            for (auto index = first; index <= last; ++index)
+                if (const auto* bucket = findBucket (level, index))
+                    range.merge (*bucket);
+        }
+
+        pixels[i] = range;
+    }
+}
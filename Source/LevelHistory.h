@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    LevelHistory.h
+    Minutes of output level kept as a min/max pyramid, with timestamped clips.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <deque>
+#include "MeterTelemetry.h"
+
+//==============================================================================
+/**
+    The output level over a retention window (ten minutes by default), built from
+    the processor's meter frames, for the editor's scrolling history view.
+
+    Level 0 holds the lowest block peak and the highest block true peak in each
+    10 ms bucket. Every level above it holds one bucket for each `decimation` of the
+    level below, so a range of the history can be read at any zoom from the level
+    whose buckets are closest to a pixel wide, touching a handful of buckets per
+    pixel however many samples it covers. Every level is a ring buffer sized for the retention window, so memory
+    stays fixed (about 1 MB for ten minutes) however long the session runs.
+
+    Each run of clipping blocks is also kept as a clip, with its start time and the
+    number of samples over full scale, until it falls out of the window. Times are
+    seconds of audio processed since the history was cleared; silence that the
+    processor skipped counts, and a restart of the processor carries on from the end.
+
+    Message thread only.
+*/
+class LevelHistory
+{
+public:
+    /** The level over a stretch of time, as linear gain. Empty if nothing was
+        recorded in it.
+    */
+    struct Range
+    {
+        float low = 1.0e9f, high = 0.0f;
+        bool clipped = false;
+
+        bool isEmpty() const noexcept           { return high < low; }
+
+        void merge (const Range& other) noexcept
+        {
+            low = std::min (low, other.low);
+            high = std::max (high, other.high);
+            clipped = clipped || other.clipped;
+        }
+    };
+
+    struct Clip
+    {
+        double startSeconds, endSeconds;
+        juce::int64 numClippedSamples;
+    };
+
+    static constexpr int bucketsPerSecond = 100, decimationShift = 2, decimation = 1 << decimationShift;
+    static constexpr double defaultRetentionSeconds = 600.0;
+
+    explicit LevelHistory (double retentionSeconds = defaultRetentionSeconds);
+
+    /** Changes how far back the history goes, and clears it. */
+    void setRetention (double seconds);
+    double getRetentionSeconds() const noexcept     { return retentionSeconds; }
+
+    void clear();
+
+    /** Adds a block's levels. Frames have to come in the order they were processed. */
+    void addFrame (const MeterFrame& frame, double sampleRate);
+
+    /** The time the last frame ended, and the oldest time still held. */
+    double getEndSeconds() const noexcept           { return endSeconds; }
+    double getStartSeconds() const noexcept         { return std::max (0.0, endSeconds - getRetentionSeconds()); }
+
+    /** Fills one Range per pixel for the numPixels equal slices of [start, end). */
+    void getRanges (double start, double end, Range* pixels, int numPixels) const;
+
+    /** Every clip still in the window, oldest first. */
+    const std::deque<Clip>& getClips() const noexcept   { return clips; }
+
+    /** Goes up by one whenever anything is added or cleared, so views can tell when
+        they need repainting.
+    */
+    juce::uint32 getChangeCount() const noexcept    { return changeCount; }
+
+private:
+    struct Level
+    {
+        std::vector<Range> buckets;
+        int shift;                      // each bucket spans decimation^level base buckets, i.e. 1 << shift
+        juce::int64 numWritten = 0;     // one past the newest bucket index written
+    };
+
+    void addToBucket (juce::int64 baseIndex, const Range& range);
+    const Range* findBucket (const Level& level, juce::int64 index) const noexcept;
+
+    static constexpr int maxClips = 4096;
+
+    std::vector<Level> levels;
+    std::deque<Clip> clips;
+
+    double retentionSeconds = 0.0, endSeconds = 0.0;
+    juce::int64 endPosition = -1;       // the processor's sample position after the last frame
+    juce::uint32 changeCount = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelHistory)
+};
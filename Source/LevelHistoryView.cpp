@@ -0,0 +1,194 @@
+/*
+  ==============================================================================
+
+    LevelHistoryView.cpp
+    A scrolling, zoomable strip of the output level history, with clip markers.
+
+  ==============================================================================
+*/
+
+#include "LevelHistoryView.h"
+
+//==============================================================================
+LevelHistoryView::LevelHistoryView (const LevelHistory& h, const juce::Font& f)
+    : history (h), font (f)
+{
+    setOpaque (true);
+}
+
+void LevelHistoryView::update()
+{
+    const auto changeCount = history.getChangeCount();
+
+    if (changeCount == lastChangeCount)
+        return;
+
+    lastChangeCount = changeCount;
+
+    // When scrolled back, what's on screen doesn't move as audio comes in
+    if (following)
+        repaint();
+}
+
+juce::String LevelHistoryView::formatTime (double seconds)
+{
+    const auto centiseconds = (juce::int64) std::floor (juce::jmax (0.0, seconds) * 100.0);
+    const auto hours = centiseconds / 360000;
+    const auto minutes = (centiseconds / 6000) % 60;
+    const auto secondsAndFraction = juce::String::formatted ("%02d.%02d", (int) (centiseconds / 100 % 60), (int) (centiseconds % 100));
+
+    if (hours > 0)
+        return juce::String (hours) + ":" + juce::String (minutes).paddedLeft ('0', 2) + ":" + secondsAndFraction;
+
+    return juce::String (minutes) + ":" + secondsAndFraction;
+}
+
+double LevelHistoryView::getViewEnd() const noexcept
+{
+    return following ? history.getEndSeconds() : viewEnd;
+}
+
+float LevelHistoryView::levelToY (float gain) const noexcept
+{
+    // Linear in dB from the floor at the bottom to full scale under the text line
+    const auto db = juce::Decibels::gainToDecibels (gain, floorDb);
+    const auto proportion = juce::jlimit (0.0f, 1.0f, (db - floorDb) / -floorDb);
+    return (float) getHeight() - proportion * (float) (getHeight() - textHeight);
+}
+
+//==============================================================================
+void LevelHistoryView::paint (juce::Graphics& g)
+{
+    g.fillAll (juce::Colour (0xFF141414));
+
+    const int width = (int) pixels.size();
+    const auto end = getViewEnd();
+    const auto start = end - visibleSeconds;
+
+    history.getRanges (start, end, pixels.data(), width);
+
+    const auto fullScaleY = levelToY (1.0f);
+    g.setColour (juce::Colour (0xFF3B3B3B));
+    g.fillRect (0.0f, fullScaleY, (float) width, 1.0f);
+
+    for (int x = 0; x < width; ++x)
+    {
+        const auto& range = pixels[(size_t) x];
+
+        if (range.isEmpty())
+            continue;
+
+        const auto top = levelToY (range.high);
+        const auto bottom = juce::jmax (top + 1.0f, levelToY (range.low));
+
+        g.setColour (range.clipped ? juce::Colour (0xFFE8702A) : juce::Colour (0xFF0EA7B5));
+        g.fillRect ((float) x, top, 1.0f, bottom - top);
+    }
+
+    // Every clip is looked at, as the selected one may be off screen; there are at
+    // most a few thousand
+    const auto secondsPerPixel = getSecondsPerPixel();
+    const LevelHistory::Clip* selected = nullptr;
+
+    for (const auto& clip : history.getClips())
+    {
+        const bool isSelected = selectedClipStart.has_value() && *selectedClipStart == clip.startSeconds;
+
+        if (isSelected)
+            selected = &clip;
+
+        if (clip.endSeconds < start || clip.startSeconds > end)
+            continue;
+
+        const auto x = (float) ((clip.startSeconds - start) / secondsPerPixel);
+
+        juce::Path marker;
+        marker.addTriangle (x - (float) markerSize, 0.0f, x + (float) markerSize, 0.0f, x, (float) markerSize * 1.5f);
+        g.setColour (isSelected ? juce::Colours::white : juce::Colour (0xFFE8702A));
+        g.fillPath (marker);
+    }
+
+    g.setFont (font);
+    g.setColour (juce::Colour (0xFFADB5BD));
+    const auto textArea = getLocalBounds().removeFromTop (textHeight).reduced (markerSize * 2, 0);
+
+    if (selected != nullptr)
+    {
+        const auto over = selected->numClippedSamples;
+        g.drawText ("Clip at " + formatTime (selected->startSeconds)
+                        + (over > 0 ? ", " + juce::String (over) + (over == 1 ? " sample" : " samples") + " over"
+                                    : juce::String (", inter-sample")),
+                    textArea, juce::Justification::centredLeft, true);
+    }
+
+    g.drawText (following ? "Last " + formatTime (visibleSeconds) : formatTime (start) + " - " + formatTime (end),
+                textArea, juce::Justification::centredRight, true);
+}
+
+void LevelHistoryView::resized()
+{
+    pixels.resize ((size_t) juce::jmax (0, getWidth()));
+}
+
+//==============================================================================
+void LevelHistoryView::mouseDown (const juce::MouseEvent& e)
+{
+    dragStartViewEnd = getViewEnd();
+
+    // The nearest clip marker within reach is selected, or else none
+    const auto start = getViewEnd() - visibleSeconds;
+    const auto secondsPerPixel = getSecondsPerPixel();
+    std::optional<double> nearest;
+    auto nearestDistance = (float) markerHitDistance;
+
+    if (e.position.y <= (float) textHeight)
+    {
+        for (const auto& clip : history.getClips())
+        {
+            const auto distance = std::abs ((float) ((clip.startSeconds - start) / secondsPerPixel) - e.position.x);
+
+            if (distance <= nearestDistance)
+            {
+                nearest = clip.startSeconds;
+                nearestDistance = distance;
+            }
+        }
+    }
+
+    selectedClipStart = nearest;
+    repaint();
+}
+
+void LevelHistoryView::mouseDrag (const juce::MouseEvent& e)
+{
+    if (e.getDistanceFromDragStartX() == 0)
+        return;
+
+    // Dragging right goes back in time. Reaching the newest audio follows it again.
+    const auto latest = history.getEndSeconds();
+    const auto earliest = juce::jmin (latest, history.getStartSeconds() + visibleSeconds);
+
+    viewEnd = juce::jlimit (earliest, latest, dragStartViewEnd - e.getDistanceFromDragStartX() * getSecondsPerPixel());
+    following = viewEnd >= latest;
+    repaint();
+}
+
+void LevelHistoryView::mouseDoubleClick (const juce::MouseEvent&)
+{
+    following = true;
+    repaint();
+}
+
+void LevelHistoryView::mouseWheelMove (const juce::MouseEvent&, const juce::MouseWheelDetails& wheel)
+{
+    // Zooms about the right-hand edge, which stays put
+    const auto end = getViewEnd();
+    const auto factor = std::pow (2.0, (double) -wheel.deltaY * (wheel.isReversed ? -1.0 : 1.0));
+
+    visibleSeconds = juce::jlimit (minVisibleSeconds, history.getRetentionSeconds(), visibleSeconds * factor);
+
+    if (! following)
+        viewEnd = end;
+
+    repaint();
+}
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    LevelHistoryView.h
+    A scrolling, zoomable strip of the output level history, with clip markers.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "LevelHistory.h"
+
+//==============================================================================
+/**
+    Draws a LevelHistory as one column per pixel, from the quietest to the loudest
+    peak in that slice of time, orange where it clipped, with a marker at the start
+    of every clip.
+
+    It follows the newest audio until dragged back through the history; the mouse
+    wheel zooms from a second up to the whole retention window, and a double-click
+    goes back to following. Clicking a clip marker shows when the clip happened and
+    how many samples went over. However far it's zoomed out, drawing reads a few
+    buckets per pixel from the history's pyramid, never the individual blocks.
+
+    The editor calls update() on each meter refresh, after adding the new frames.
+*/
+class LevelHistoryView : public juce::Component
+{
+public:
+    LevelHistoryView (const LevelHistory& history, const juce::Font& font);
+
+    /** Repaints if the history has changed and the view is following it. */
+    void update();
+
+    /** Formats seconds as m:ss.cc, or h:mm:ss.cc from an hour on. */
+    static juce::String formatTime (double seconds);
+
+    //==============================================================================
+    void paint (juce::Graphics&) override;
+    void resized() override;
+    void mouseDown (const juce::MouseEvent&) override;
+    void mouseDrag (const juce::MouseEvent&) override;
+    void mouseDoubleClick (const juce::MouseEvent&) override;
+    void mouseWheelMove (const juce::MouseEvent&, const juce::MouseWheelDetails&) override;
+
+private:
+    static constexpr float floorDb = -60.0f;
+    static constexpr double minVisibleSeconds = 1.0, defaultVisibleSeconds = 60.0;
+    static constexpr int textHeight = 12, markerSize = 4, markerHitDistance = 4;
+
+    double getViewEnd() const noexcept;
+    double getSecondsPerPixel() const noexcept  { return visibleSeconds / juce::jmax (1, getWidth()); }
+    float levelToY (float gain) const noexcept;
+
+    const LevelHistory& history;
+    juce::Font font;
+
+    std::vector<LevelHistory::Range> pixels;
+
+    double visibleSeconds = defaultVisibleSeconds;
+    bool following = true;
+    double viewEnd = 0.0, dragStartViewEnd = 0.0;   // viewEnd only counts while not following
+
+    std::optional<double> selectedClipStart;        // clips are told apart by when they started
+    juce::uint32 lastChangeCount = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelHistoryView)
+};
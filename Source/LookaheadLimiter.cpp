@@ -0,0 +1,218 @@
+/*
+  ==============================================================================
+
+    LookaheadLimiter.cpp
+    Brickwall lookahead limiter with a constant cost per sample.
+
+  ==============================================================================
+*/
+
+#include "LookaheadLimiter.h"
+
+//==============================================================================
+void LookaheadLimiter::prepare (double newSampleRate, int maximumBlockSize, int numChannels)
+{
+    sampleRate = newSampleRate;
+    maxDelayLength = juce::jmax (1, (int) std::ceil (maxLookaheadMs * 0.001 * sampleRate));
+    chunkSize = juce::jmax (1, maximumBlockSize);
+    numPreparedChannels = juce::jlimit (0, maxChannels, numChannels);
+
+    delayLines.assign ((size_t) (numPreparedChannels * maxDelayLength), 0.0);
+    gains.assign ((size_t) chunkSize, 1.0f);
+
+    // The deque never holds more than the window, so a power of two that size can be
+    // indexed with a mask
+    const auto dequeSize = (juce::uint32) juce::nextPowerOfTwo (maxDelayLength + 1);
+    dequeGains.assign (dequeSize, 1.0f);
+    dequeTimes.assign (dequeSize, 0);
+    dequeMask = dequeSize - 1;
+
+    averageRing.assign ((size_t) (maxDelayLength + 1), 1.0f);
+
+    delayLength = getDelayLengthFor (lookaheadMs);
+    windowLength = delayLength + 1;
+    updateReleaseCoefficient();
+    reset();
+}
+
+void LookaheadLimiter::reset() noexcept
+{
+    std::fill (delayLines.begin(), delayLines.end(), 0.0);
+    writePosition = 0;
+
+    dequeFront = dequeBack = time = 0;
+    envelope = 1.0f;
+
+    std::fill (averageRing.begin(), averageRing.end(), 1.0f);
+    averagePosition = 0;
+    averageSum = (double) windowLength;
+    lastMinimumGain = 1.0f;
+}
+
+void LookaheadLimiter::setLookahead (float milliseconds) noexcept
+{
+    lookaheadMs = milliseconds;
+
+    if (maxDelayLength == 0)
+        return;
+
+    const int newLength = getDelayLengthFor (milliseconds);
+
+    if (newLength != delayLength)
+    {
+        // The delay lines are always maxDelayLength long, so only the read position
+        // moves. The moving average starts again over the new window from the gain it
+        // had reached, so the gain carries on without a step; the sliding minimum lets
+        // go of anything older than the new window as it goes. Peaks already part way
+        // through the delay may meet a ramp that isn't quite down yet, which the
+        // ceiling clamp catches, but nothing is cleared.
+        const auto currentGain = (float) (averageSum / (double) windowLength);
+
+        delayLength = newLength;
+        windowLength = newLength + 1;
+
+        std::fill (averageRing.begin(), averageRing.begin() + windowLength, currentGain);
+        averagePosition = 0;
+        averageSum = (double) currentGain * (double) windowLength;
+    }
+}
+
+int LookaheadLimiter::getDelayLengthFor (float milliseconds) const noexcept
+{
+    return juce::jlimit (1, maxDelayLength, juce::roundToInt (milliseconds * 0.001 * sampleRate));
+}
+
+void LookaheadLimiter::setRelease (float milliseconds) noexcept
+{
+    if (milliseconds != releaseMs)
+    {
+        releaseMs = milliseconds;
+        updateReleaseCoefficient();
+    }
+}
+
+void LookaheadLimiter::updateReleaseCoefficient() noexcept
+{
+    releaseCoefficient = (float) std::exp (-1.0 / (juce::jmax (0.001f, releaseMs) * 0.001 * sampleRate));
+}
+
+//==============================================================================
+template <typename SampleType>
+void LookaheadLimiter::process (SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    numChannels = juce::jmin (numChannels, numPreparedChannels);
+    lastMinimumGain = 1.0f;
+
+    if (delayLength == 0)
+        return;
+
+    // A chunk at a time if the host's block is longer than it said it would be
+    for (int start = 0; start < numSamples; start += chunkSize)
+        processChunk (channels, numChannels, start, juce::jmin (chunkSize, numSamples - start));
+}
+
+template void LookaheadLimiter::process (float* const*, int, int) noexcept;
+template void LookaheadLimiter::process (double* const*, int, int) noexcept;
+
+template <typename SampleType>
+void LookaheadLimiter::processChunk (SampleType* const* channels, int numChannels, int startSample, int numSamples) noexcept
+{
+    // The loudest channel at each sample. NaNs lose to the running peak here, so they
+    // can't get into the envelope.
+    std::fill (gains.begin(), gains.begin() + numSamples, 0.0f);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto* data = channels[channel] + startSample;
+
+        for (int i = 0; i < numSamples; ++i)
+            gains[(size_t) i] = std::max (gains[(size_t) i], (float) std::abs (data[i]));
+    }
+
+    computeGains (numSamples);
+
+    // The delay is a ring per channel, read delayLength samples behind where it's
+    // written and walked in runs up to where either position wraps. The gain meets
+    // each sample as it comes out, and the clamp only ever catches the last bit of
+    // rounding in the moving average, or a ramp cut short by a lookahead change.
+    const int firstReadPosition = (writePosition + maxDelayLength - delayLength) % maxDelayLength;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* data = channels[channel] + startSample;
+        auto* line = delayLines.data() + (size_t) channel * (size_t) maxDelayLength;
+
+        for (int i = 0, readPosition = firstReadPosition, position = writePosition; i < numSamples;)
+        {
+            const int numToDo = juce::jmin (numSamples - i, maxDelayLength - readPosition, maxDelayLength - position);
+
+            for (int k = 0; k < numToDo; ++k)
+            {
+                const auto input = data[i + k];
+                const auto output = (SampleType) (line[readPosition + k] * gains[(size_t) (i + k)]);
+                line[position + k] = (double) input;
+                data[i + k] = juce::jlimit ((SampleType) -ceiling, (SampleType) ceiling, output);
+            }
+
+            i += numToDo;
+            readPosition += numToDo;
+            position += numToDo;
+
+            if (readPosition == maxDelayLength)
+                readPosition = 0;
+
+            if (position == maxDelayLength)
+                position = 0;
+        }
+    }
+
+    writePosition = (writePosition + numSamples) % maxDelayLength;
+}
+
+void LookaheadLimiter::computeGains (int numSamples) noexcept
+{
+    // The gain each sample needs to stay under the ceiling
+    for (int i = 0; i < numSamples; ++i)
+        gains[(size_t) i] = ceiling / std::max (gains[(size_t) i], ceiling);
+
+    const auto window = (juce::uint32) windowLength;
+    const auto inverseWindow = 1.0 / (double) windowLength;
+    float minimumGain = lastMinimumGain;
+
+    for (int i = 0; i < numSamples; ++i, ++time)
+    {
+        const auto needed = gains[(size_t) i];
+
+        // Sliding minimum: anything behind that needs no less than this sample can never
+        // be the minimum again, and the front leaves once it's older than the window
+        while (dequeBack != dequeFront && dequeGains[(dequeBack - 1) & dequeMask] >= needed)
+            --dequeBack;
+
+        dequeGains[dequeBack & dequeMask] = needed;
+        dequeTimes[dequeBack & dequeMask] = time;
+        ++dequeBack;
+
+        // More than one can leave at once after the window has shrunk
+        while (time - dequeTimes[dequeFront & dequeMask] >= window)
+            ++dequeFront;
+
+        // Drops are taken at once and recovered from at the release rate, which keeps
+        // the envelope at or under the held minimum
+        const auto held = dequeGains[dequeFront & dequeMask];
+        envelope = held < envelope ? held : held + (envelope - held) * releaseCoefficient;
+
+        averageSum += (double) (envelope - averageRing[(size_t) averagePosition]);
+        averageRing[(size_t) averagePosition] = envelope;
+
+        if (++averagePosition == windowLength)
+        {
+            averagePosition = 0;
+            averageSum = std::accumulate (averageRing.begin(), averageRing.begin() + windowLength, 0.0);
+        }
+
+        gains[(size_t) i] = (float) (averageSum * inverseWindow);
+        minimumGain = std::min (minimumGain, gains[(size_t) i]);
+    }
+
+    lastMinimumGain = minimumGain;
+}
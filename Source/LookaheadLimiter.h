@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    LookaheadLimiter.h
+    Brickwall lookahead limiter with a constant cost per sample.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Keeps every channel at or below the ceiling by turning the gain down ahead of
+    each peak, so nothing has to be clipped.
+
+    The signal is delayed by the lookahead, and the gain each sample needs (ceiling
+    over the loudest channel, so the channels stay linked and the image doesn't
+    move) is held at the lowest value in the lookahead window by a sliding minimum.
+    That is kept as a monotonic deque: each sample goes in once and comes out once,
+    so the cost per sample doesn't grow with the lookahead. The held gain recovers
+    at the release rate, and a moving average over the window then turns each drop
+    into a ramp that reaches the needed gain exactly as the peak comes out of the
+    delay.
+
+    All the buffers are allocated by prepare() for the longest lookahead, so the
+    lookahead can change on the audio thread. The delay lines stay that long and a
+    change only moves where they're read from, so the audio and the gain reduction
+    carry on through it.
+*/
+class LookaheadLimiter
+{
+public:
+    /** -0.1 dBFS. Nothing comes out above this. */
+    static constexpr float ceiling = 0.98855309f;
+
+    static constexpr float maxLookaheadMs = 10.0f;
+    static constexpr int maxChannels = 128;
+
+    //==============================================================================
+    /** Allocates everything for up to maxLookaheadMs and clears the limiter. Not on
+        the audio thread.
+    */
+    void prepare (double sampleRate, int maximumBlockSize, int numChannels);
+
+    /** Empties the delay and lets go of any gain reduction. */
+    void reset() noexcept;
+
+    /** Audio thread. The lookahead is also the latency, in samples. Changing it moves
+        the delay's read position and restarts the smoothing window, without clearing
+        anything.
+    */
+    void setLookahead (float milliseconds) noexcept;
+    int getLatencySamples() const noexcept                  { return delayLength; }
+
+    /** Audio thread. How long the gain takes to recover by about 63% after a peak. */
+    void setRelease (float milliseconds) noexcept;
+
+    /** The lowest gain applied during the last process() call. */
+    float getLastMinimumGain() const noexcept               { return lastMinimumGain; }
+
+    /** Audio thread. Limits the first numChannels channels in place. */
+    template <typename SampleType>
+    void process (SampleType* const* channels, int numChannels, int numSamples) noexcept;
+
+private:
+    //==============================================================================
+    void updateReleaseCoefficient() noexcept;
+    int getDelayLengthFor (float milliseconds) const noexcept;
+
+    // Works out the gain for numSamples from the linked peaks already in gains
+    void computeGains (int numSamples) noexcept;
+
+    template <typename SampleType>
+    void processChunk (SampleType* const* channels, int numChannels, int startSample, int numSamples) noexcept;
+
+    double sampleRate = 44100.0;
+    float lookaheadMs = 5.0f, releaseMs = 100.0f;
+    int maxDelayLength = 0, chunkSize = 0, numPreparedChannels = 0;
+    int delayLength = 0, windowLength = 1;
+
+    // Per channel, a ring of maxDelayLength samples, read delayLength behind writePosition
+    std::vector<double> delayLines;
+    int writePosition = 0;
+
+    // The linked peak, then the gain, for each sample of the current chunk
+    std::vector<float> gains;
+
+    // Sliding minimum: a ring of gains that only ever increase from front to back,
+    // with the sample count at which each went in
+    std::vector<float> dequeGains;
+    std::vector<juce::uint32> dequeTimes;
+    juce::uint32 dequeMask = 0, dequeFront = 0, dequeBack = 0, time = 0;
+
+    float releaseCoefficient = 0.0f, envelope = 1.0f;
+
+    // Moving average over the window. The running sum is added up again from scratch
+    // every time the ring wraps, so rounding errors can't build up in it.
+    std::vector<float> averageRing;
+    int averagePosition = 0;
+    double averageSum = 0.0;
+
+    float lastMinimumGain = 1.0f;
+};
@@ -0,0 +1,457 @@
+/*
+  ==============================================================================
+
+    LoudnessMeter.cpp
+    EBU R128 / ITU-R BS.1770 loudness: momentary, short-term, integrated and LRA.
+
+  ==============================================================================
+*/
+
+#include "LoudnessMeter.h"
+
+//==============================================================================
+/**
+    The one background thread that does the gating and histogram work for every
+    LoudnessMeter in the process, so that hundreds of plugin instances don't mean
+    hundreds of threads. The lock only guards the list of meters and is never taken
+    on the audio thread.
+*/
+class LoudnessAnalysisThread : private juce::Thread
+{
+public:
+    LoudnessAnalysisThread() : juce::Thread ("OpenGain loudness analysis")
+    {
+        startThread (juce::Thread::Priority::low);
+    }
+
+    ~LoudnessAnalysisThread() override
+    {
+        stopThread (2000);
+    }
+
+    void add (LoudnessMeter* meter)
+    {
+        const juce::ScopedLock sl (lock);
+        meters.addIfNotAlreadyThere (meter);
+    }
+
+    void remove (LoudnessMeter* meter)
+    {
+        const juce::ScopedLock sl (lock);
+        meters.removeFirstMatchingValue (meter);
+    }
+
+private:
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            {
+                const juce::ScopedLock sl (lock);
+
+                for (auto* meter : meters)
+                    meter->analysePendingHops();
+            }
+
+            // Hops arrive every 100 ms, so there's no point polling much faster
+            wait (50);
+        }
+    }
+
+    juce::CriticalSection lock;
+    juce::Array<LoudnessMeter*> meters;
+};
+
+//==============================================================================
+LoudnessMeter::LoudnessMeter()
+{
+    channelWeights.fill (1.0);
+    analysisThread->add (this);
+}
+
+LoudnessMeter::~LoudnessMeter()
+{
+    analysisThread->remove (this);
+}
+
+LoudnessMeter::KWeighting LoudnessMeter::getKWeighting (double sampleRate) noexcept
+{
+    // The BS.1770 high-shelf and high-pass stages, re-derived for any sample rate with
+    // the bilinear transform (these match the 48 kHz coefficients given in the standard)
+    KWeighting filter;
+
+    {
+        const double f0 = 1681.974450955533, gainDb = 3.999843853973347, q = 0.7071752369554196;
+        const double k = std::tan (juce::MathConstants<double>::pi * f0 / sampleRate);
+        const double vh = std::pow (10.0, gainDb / 20.0);
+        const double vb = std::pow (vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+
+        filter.shelf.b0 = (vh + vb * k / q + k * k) / a0;
+        filter.shelf.b1 = 2.0 * (k * k - vh) / a0;
+        filter.shelf.b2 = (vh - vb * k / q + k * k) / a0;
+        filter.shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+        filter.shelf.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    {
+        const double f0 = 38.13547087602444, q = 0.5003270373238773;
+        const double k = std::tan (juce::MathConstants<double>::pi * f0 / sampleRate);
+        const double a0 = 1.0 + k / q + k * k;
+
+        filter.highPass.b0 = 1.0;
+        filter.highPass.b1 = -2.0;
+        filter.highPass.b2 = 1.0;
+        filter.highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+        filter.highPass.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    return filter;
+}
+
+double LoudnessMeter::getChannelWeight (const juce::AudioChannelSet& channels, int channel) noexcept
+{
+    switch (channels.getTypeOfChannel (channel))
+    {
+        case juce::AudioChannelSet::LFE:
+        case juce::AudioChannelSet::LFE2:
+            return 0.0;
+
+        case juce::AudioChannelSet::leftSurround:
+        case juce::AudioChannelSet::rightSurround:
+        case juce::AudioChannelSet::leftSurroundSide:
+        case juce::AudioChannelSet::rightSurroundSide:
+        case juce::AudioChannelSet::leftSurroundRear:
+        case juce::AudioChannelSet::rightSurroundRear:
+            return 1.41;
+
+        default:
+            return 1.0;
+    }
+}
+
+void LoudnessMeter::prepare (double sampleRate, const juce::AudioChannelSet& channels)
+{
+    // K-weighting: two biquads per channel
+    const auto kWeighting = getKWeighting (sampleRate);
+    shelf = kWeighting.shelf;
+    highPass = kWeighting.highPass;
+
+    // Channel weights from BS.1770: surrounds count 1.41 times, the LFE not at all
+    for (int i = 0; i < maxChannels; ++i)
+        channelWeights[(size_t) i] = getChannelWeight (channels, i);
+
+    channelStates.fill ({});
+    hopLength = juce::jmax (1, juce::roundToInt (sampleRate * 0.1));
+    hopSamplesDone = 0;
+    hopEnergy = 0.0;
+    resetRequested = true;
+}
+
+//==============================================================================
+template <typename SampleType>
+double LoudnessMeter::weightAndSumSquares (int channel, const SampleType* data, int numSamples) noexcept
+{
+    auto& state = channelStates[(size_t) channel];
+    auto s1 = state.shelf1, s2 = state.shelf2, h1 = state.highPass1, h2 = state.highPass2;
+    double sum = 0.0;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const double x = data[i];
+
+        const double y = shelf.b0 * x + s1;
+        s1 = shelf.b1 * x - shelf.a1 * y + s2;
+        s2 = shelf.b2 * x - shelf.a2 * y;
+
+        const double z = highPass.b0 * y + h1;
+        h1 = highPass.b1 * y - highPass.a1 * z + h2;
+        h2 = highPass.b2 * y - highPass.a2 * z;
+
+        sum += z * z;
+    }
+
+    state = { s1, s2, h1, h2 };
+    return sum;
+}
+
+template <typename SampleType>
+void LoudnessMeter::process (const juce::AudioBuffer<SampleType>& buffer, int numChannels) noexcept
+{
+    numChannels = juce::jmin (numChannels, maxChannels);
+    const int numSamples = buffer.getNumSamples();
+
+    for (int position = 0; position < numSamples;)
+    {
+        const int numToDo = juce::jmin (numSamples - position, hopLength - hopSamplesDone);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            if (const auto weight = channelWeights[(size_t) channel]; weight > 0.0)
+                hopEnergy += weight * weightAndSumSquares (channel, buffer.getReadPointer (channel, position), numToDo);
+
+        position += numToDo;
+        advanceHop (numToDo);
+    }
+}
+
+template void LoudnessMeter::process (const juce::AudioBuffer<float>&, int) noexcept;
+template void LoudnessMeter::process (const juce::AudioBuffer<double>&, int) noexcept;
+
+template <typename SampleType>
+void LoudnessMeter::weighChannels (const SampleType* const* channels, int beginChannel, int endChannel, int numSamples,
+                                   double* hopEnergies) noexcept
+{
+    endChannel = juce::jmin (endChannel, maxChannels);
+
+    for (int channel = beginChannel; channel < endChannel; ++channel)
+    {
+        const auto weight = channelWeights[(size_t) channel];
+
+        if (weight <= 0.0)
+            continue;
+
+        // The same hop boundaries process() would split the block at
+        for (int position = 0, done = hopSamplesDone, hop = 0; position < numSamples; ++hop)
+        {
+            const int numToDo = juce::jmin (numSamples - position, hopLength - done);
+            hopEnergies[hop] += weight * weightAndSumSquares (channel, channels[channel] + position, numToDo);
+            position += numToDo;
+            done = 0;
+        }
+    }
+}
+
+template void LoudnessMeter::weighChannels (const float* const*, int, int, int, double*) noexcept;
+template void LoudnessMeter::weighChannels (const double* const*, int, int, int, double*) noexcept;
+
+void LoudnessMeter::addHopEnergies (const double* hopEnergies, int numSamples) noexcept
+{
+    for (int position = 0, hop = 0; position < numSamples; ++hop)
+    {
+        const int numToDo = juce::jmin (numSamples - position, hopLength - hopSamplesDone);
+        hopEnergy += hopEnergies[hop];
+        position += numToDo;
+        advanceHop (numToDo);
+    }
+}
+
+void LoudnessMeter::processSilence (int numSamples) noexcept
+{
+    // Silence adds no energy; the filter tails it would have let ring out are
+    // dropped along with it
+    channelStates.fill ({});
+
+    while (numSamples > 0)
+    {
+        const int numToDo = juce::jmin (numSamples, hopLength - hopSamplesDone);
+        numSamples -= numToDo;
+        advanceHop (numToDo);
+    }
+}
+
+void LoudnessMeter::advanceHop (int numSamples) noexcept
+{
+    hopSamplesDone += numSamples;
+
+    if (hopSamplesDone == hopLength)
+    {
+        const auto meanSquare = hopEnergy / hopLength;
+
+        // A full queue means the analysis thread is behind. Offline there's time to
+        // wait for it, and to do its work here; in realtime the hop is dropped, and
+        // counted, rather than doing any of that on the audio thread.
+        if (! hops.push (meanSquare))
+        {
+            if (nonRealtime.load (std::memory_order_relaxed))
+            {
+                flush();
+                hops.push (meanSquare);
+            }
+            else
+            {
+                numDroppedHops.store (numDroppedHops.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+        }
+
+        hopEnergy = 0.0;
+        hopSamplesDone = 0;
+    }
+}
+
+LoudnessMeter::Readings LoudnessMeter::getReadings() const noexcept
+{
+    return { momentary.load(), shortTerm.load(), integrated.load(), range.load() };
+}
+
+//==============================================================================
+float LoudnessMeter::loudnessOf (double meanSquare) noexcept
+{
+    if (meanSquare <= 0.0)
+        return silence;
+
+    return juce::jmax (silence, (float) (-0.691 + 10.0 * std::log10 (meanSquare)));
+}
+
+void LoudnessMeter::Histogram::clear() noexcept
+{
+    counts.fill (0);
+    energies.fill (0.0);
+}
+
+int LoudnessMeter::Histogram::binFor (float loudness) noexcept
+{
+    return juce::jlimit (0, numBins - 1, (int) ((loudness - lowest) / binWidth));
+}
+
+void LoudnessMeter::Histogram::add (double meanSquare) noexcept
+{
+    // Blocks under the -70 LUFS absolute gate never count towards anything
+    const auto loudness = loudnessOf (meanSquare);
+
+    if (loudness < lowest)
+        return;
+
+    const auto bin = (size_t) binFor (loudness);
+    ++counts[bin];
+    energies[bin] += meanSquare;
+}
+
+//==============================================================================
+bool LoudnessMeter::analysePendingHops()
+{
+    if (analysing.exchange (true, std::memory_order_acquire))
+        return false;
+
+    if (resetRequested.exchange (false))
+    {
+        recentHops.fill (0.0);
+        numHopsAnalysed = 0;
+        momentaryBlocks.clear();
+        shortTermBlocks.clear();
+        momentary = shortTerm = integrated = silence;
+        range = 0.0f;
+    }
+
+    bool anyNew = false;
+
+    for (double meanSquare; hops.pop (meanSquare);)
+    {
+        analyseHop (meanSquare);
+        anyNew = true;
+    }
+
+    if (anyNew)
+        updateGatedReadings();
+
+    analysing.store (false, std::memory_order_release);
+    return true;
+}
+
+void LoudnessMeter::flush()
+{
+    // Nothing more is queued while the caller is here, so once it gets a turn of its
+    // own every hop has been analysed and published
+    while (! analysePendingHops())
+        juce::Thread::yield();
+}
+
+void LoudnessMeter::analyseHop (double meanSquare) noexcept
+{
+    recentHops[(size_t) (numHopsAnalysed % hopsPerShortTerm)] = meanSquare;
+    ++numHopsAnalysed;
+
+    auto meanOfLast = [this] (int numHops)
+    {
+        double sum = 0.0;
+
+        for (int i = 1; i <= numHops; ++i)
+            sum += recentHops[(size_t) ((numHopsAnalysed - i) % hopsPerShortTerm)];
+
+        return sum / numHops;
+    };
+
+    // Every hop completes a new 400 ms block (75 % overlap) and a new 3 s window
+    if (numHopsAnalysed >= hopsPerMomentary)
+    {
+        const auto block = meanOfLast (hopsPerMomentary);
+        momentary = loudnessOf (block);
+        momentaryBlocks.add (block);
+    }
+
+    if (numHopsAnalysed >= hopsPerShortTerm)
+    {
+        const auto window = meanOfLast (hopsPerShortTerm);
+        shortTerm = loudnessOf (window);
+        shortTermBlocks.add (window);
+    }
+}
+
+void LoudnessMeter::updateGatedReadings() noexcept
+{
+    // The relative gate sits a fixed distance below the mean of everything above
+    // the absolute gate. Returns the first bin at or above it.
+    auto relativeGateBin = [] (const Histogram& h, float gateLU, juce::uint64& total)
+    {
+        double energy = 0.0;
+        total = 0;
+
+        for (int i = 0; i < Histogram::numBins; ++i)
+        {
+            energy += h.energies[(size_t) i];
+            total += h.counts[(size_t) i];
+        }
+
+        return total > 0 ? Histogram::binFor (loudnessOf (energy / (double) total) + gateLU) : Histogram::numBins;
+    };
+
+    // Integrated: the mean of the 400 ms blocks above a -10 LU relative gate
+    {
+        juce::uint64 total = 0;
+        const int gate = relativeGateBin (momentaryBlocks, -10.0f, total);
+        double energy = 0.0;
+        juce::uint64 count = 0;
+
+        for (int i = gate; i < Histogram::numBins; ++i)
+        {
+            energy += momentaryBlocks.energies[(size_t) i];
+            count += momentaryBlocks.counts[(size_t) i];
+        }
+
+        integrated = count > 0 ? loudnessOf (energy / (double) count) : silence;
+    }
+
+    // LRA: the spread between the 10th and 95th percentiles of the 3 s windows
+    // above a -20 LU relative gate
+    {
+        juce::uint64 total = 0;
+        const int gate = relativeGateBin (shortTermBlocks, -20.0f, total);
+        juce::uint64 count = 0;
+
+        for (int i = gate; i < Histogram::numBins; ++i)
+            count += shortTermBlocks.counts[(size_t) i];
+
+        if (count == 0)
+        {
+            range = 0.0f;
+            return;
+        }
+
+        auto percentileBin = [&] (double percentile)
+        {
+            const auto target = (juce::uint64) ((double) (count - 1) * percentile);
+            juce::uint64 seen = 0;
+
+            for (int i = gate; i < Histogram::numBins; ++i)
+            {
+                seen += shortTermBlocks.counts[(size_t) i];
+
+                if (seen > target)
+                    return i;
+            }
+
+            return Histogram::numBins - 1;
+        };
+
+        range = (float) (percentileBin (0.95) - percentileBin (0.10)) * Histogram::binWidth;
+    }
+}
@@ -0,0 +1,179 @@
+/*
+  ==============================================================================
+
+    LoudnessMeter.h
+    EBU R128 / ITU-R BS.1770 loudness: momentary, short-term, integrated and LRA.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpscQueue.h"
+
+class LoudnessAnalysisThread;
+
+//==============================================================================
+/**
+    Measures loudness the way BS.1770-4 and EBU Tech 3342 describe it.
+
+    The audio thread only K-weights the signal (two biquads per channel) and queues
+    the channel-weighted mean square of every 100 ms hop. Everything else, i.e. the
+    400 ms / 3 s windows, the gating and the histograms behind integrated loudness
+    and loudness range, runs on a background thread shared by every meter in the
+    process, never on the audio thread. In realtime the hop queue holds far more
+    than the analysis thread leaves in it between passes. Rendering offline can
+    outrun any polling thread, so there a full queue makes the rendering thread
+    wait for the analysis rather than drop a hop.
+
+    Integrated loudness and LRA are kept as histograms with 0.1 LU bins, so memory
+    stays fixed however long the measurement runs, and the relative gates are
+    resolved to the nearest bin.
+*/
+class LoudnessMeter
+{
+public:
+    LoudnessMeter();
+    ~LoudnessMeter();
+
+    /** Readings in LUFS (LU for range). Anything unmeasured or silent reads as silence. */
+    struct Readings
+    {
+        float momentary, shortTerm, integrated, range;
+    };
+
+    static constexpr float silence = -100.0f;
+    static constexpr int maxChannels = 128;
+
+    struct Biquad
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    };
+
+    /** The BS.1770 K-weighting filter: a high shelf, then a high-pass. */
+    struct KWeighting
+    {
+        Biquad shelf, highPass;
+    };
+
+    /** The K-weighting filter's coefficients at any sample rate. */
+    static KWeighting getKWeighting (double sampleRate) noexcept;
+
+    /** BS.1770's weight for one channel of a layout: 1.41 for the surrounds, 0 for
+        the LFE and 1 for everything else.
+    */
+    static double getChannelWeight (const juce::AudioChannelSet& channels, int channel) noexcept;
+
+    /** The loudness in LUFS of a channel-weighted, K-weighted mean square. */
+    static float loudnessOf (double meanSquare) noexcept;
+
+    //==============================================================================
+    /** Call before processing starts, when the audio thread isn't running. */
+    void prepare (double sampleRate, const juce::AudioChannelSet& channels);
+
+    /** Audio thread. Measures the first numChannels channels of the buffer. */
+    template <typename SampleType>
+    void process (const juce::AudioBuffer<SampleType>& buffer, int numChannels) noexcept;
+
+    /** Audio thread or a worker. The first half of process(), split so that groups of
+        channels can be weighted concurrently: adds the weighted energy of channels
+        [beginChannel, endChannel) to hopEnergies, one entry per hop the block reaches
+        into. It only touches those channels' filter state, so disjoint ranges can run
+        at the same time. Once every range is done, pass the summed energies on to
+        addHopEnergies() with the same numSamples.
+    */
+    template <typename SampleType>
+    void weighChannels (const SampleType* const* channels, int beginChannel, int endChannel, int numSamples,
+                        double* hopEnergies) noexcept;
+
+    /** Audio thread. The second half of process(), for energies from weighChannels(). */
+    void addHopEnergies (const double* hopEnergies, int numSamples) noexcept;
+
+    /** How many hopEnergies entries weighChannels() can write for a block of numSamples. */
+    int getMaxNumHops (int numSamples) const noexcept     { return numSamples / hopLength + 2; }
+
+    /** Audio thread. Counts numSamples of digital silence without filtering them. */
+    void processSilence (int numSamples) noexcept;
+
+    /** The thread that calls process(), when it's allowed to wait. Analyses every hop
+        queued so far, waiting for the background thread if it's part way through
+        them, so that the readings cover everything processed up to now. For offline
+        analysis, where the readings are wanted at the end of a file.
+    */
+    void flush();
+
+    /** Any thread. While rendering offline, a block that finds the hop queue full
+        waits for it to be analysed. Otherwise the hop has to be dropped.
+    */
+    void setNonRealtime (bool isNonRealtime) noexcept   { nonRealtime.store (isNonRealtime, std::memory_order_relaxed); }
+
+    /** How many hops were dropped because the analysis thread stalled in realtime. Any thread. */
+    juce::uint32 getNumDroppedHops() const noexcept     { return numDroppedHops.load (std::memory_order_relaxed); }
+
+    /** Any thread. Starts integrated loudness and LRA again from now. */
+    void resetIntegrated() noexcept         { resetRequested = true; }
+
+    /** Any thread. */
+    Readings getReadings() const noexcept;
+
+private:
+    //==============================================================================
+    friend class LoudnessAnalysisThread;
+
+    struct ChannelState
+    {
+        double shelf1 = 0.0, shelf2 = 0.0, highPass1 = 0.0, highPass2 = 0.0;
+    };
+
+    struct Histogram
+    {
+        static constexpr float lowest = -70.0f, highest = 10.0f, binWidth = 0.1f;
+        static constexpr int numBins = 800;
+
+        std::array<juce::uint32, numBins> counts {};
+        std::array<double, numBins> energies {};
+
+        void clear() noexcept;
+        void add (double meanSquare) noexcept;
+        static int binFor (float loudness) noexcept;
+    };
+
+    template <typename SampleType>
+    double weightAndSumSquares (int channel, const SampleType* data, int numSamples) noexcept;
+    void advanceHop (int numSamples) noexcept;
+    // Returns false, having done nothing, if another thread is already analysing. Never
+    // called on a realtime audio thread, as it does the gating and histogram work.
+    bool analysePendingHops();
+    void analyseHop (double meanSquare) noexcept;
+    void updateGatedReadings() noexcept;
+
+    //==============================================================================
+    // Audio thread
+    Biquad shelf, highPass;
+    std::array<ChannelState, maxChannels> channelStates;
+    std::array<double, maxChannels> channelWeights;
+    int hopLength = 4800, hopSamplesDone = 0;
+    double hopEnergy = 0.0;
+
+    // 12.8 s of hops, where the analysis thread polls every 50 ms
+    SpscQueue<double, 128> hops;
+    std::atomic<bool> nonRealtime { false };
+    std::atomic<juce::uint32> numDroppedHops { 0 };
+
+    // Held by whichever thread is consuming hops, as either side may do it
+    std::atomic<bool> analysing { false };
+
+    // Analysis thread
+    static constexpr int hopsPerMomentary = 4, hopsPerShortTerm = 30;
+    std::array<double, hopsPerShortTerm> recentHops {};
+    juce::int64 numHopsAnalysed = 0;
+    Histogram momentaryBlocks, shortTermBlocks;
+
+    std::atomic<bool> resetRequested { true };
+    std::atomic<float> momentary { silence }, shortTerm { silence }, integrated { silence }, range { 0.0f };
+
+    juce::SharedResourcePointer<LoudnessAnalysisThread> analysisThread;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoudnessMeter)
+};
@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    MeterBridge.cpp
+    A compact row of per-channel peak meters, for any bus layout.
+
+  ==============================================================================
+*/
+
+#include "MeterBridge.h"
+
+//==============================================================================
+MeterBridge::MeterBridge()
+{
+    levelsDb.fill (floorDb);
+    setOpaque (true);
+}
+
+void MeterBridge::setChannelLayout (const juce::AudioChannelSet& layout)
+{
+    numChannels = juce::jmin (layout.size(), ChannelLevels::maxChannels);
+    channelNames.clearQuick();
+
+    for (int i = 0; i < numChannels; ++i)
+        channelNames.add (layout.getAbbreviatedChannelTypeName (layout.getTypeOfChannel (i)));
+
+    levelsDb.fill (floorDb);
+    newPeaks.fill (0.0f);
+    clipped.fill (false);
+    repaint();
+}
+
+void MeterBridge::addLevels (const ChannelLevels& levels) noexcept
+{
+    const int numInLevels = juce::jmin (numChannels, levels.numChannels);
+
+    for (int i = 0; i < numInLevels; ++i)
+    {
+        newPeaks[(size_t) i] = std::max (newPeaks[(size_t) i], levels.peaks[(size_t) i]);
+
+        if (levels.clippedSamples[(size_t) i] > 0 && ! clipped[(size_t) i])
+        {
+            clipped[(size_t) i] = true;
+            clipsChanged = true;
+        }
+    }
+}
+
+bool MeterBridge::update()
+{
+    const auto now = juce::Time::getMillisecondCounterHiRes();
+    const auto fall = lastUpdateMs > 0.0 ? (float) ((now - lastUpdateMs) * 0.001) * fallDbPerSecond : 0.0f;
+    lastUpdateMs = now;
+
+    bool changed = std::exchange (clipsChanged, false);
+    bool anyUp = false;
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        const auto peakDb = juce::Decibels::gainToDecibels (newPeaks[(size_t) i], floorDb);
+        const auto level = juce::jmax (peakDb, levelsDb[(size_t) i] - fall, floorDb);
+
+        changed = changed || level != levelsDb[(size_t) i];
+        anyUp = anyUp || level > floorDb;
+        levelsDb[(size_t) i] = level;
+        newPeaks[(size_t) i] = 0.0f;
+    }
+
+    if (changed)
+        repaint();
+
+    return anyUp;
+}
+
+void MeterBridge::resetClips()
+{
+    clipped.fill (false);
+    repaint();
+}
+
+//==============================================================================
+void MeterBridge::paint (juce::Graphics& g)
+{
+    g.fillAll (juce::Colour (0xFF141414));
+
+    if (numChannels == 0)
+        return;
+
+    const auto laneWidth = (float) getWidth() / (float) numChannels;
+    const bool showNames = laneWidth >= (float) minBarWidthForNames;
+    const auto barTop = (float) (clipMarkerHeight + 1);
+    const auto barBottom = (float) (getHeight() - (showNames ? nameHeight : 0));
+    const auto gap = laneWidth >= 4.0f ? 1.0f : 0.0f;
+
+    if (showNames)
+        g.setFont (juce::Font (juce::FontOptions (8.0f)));
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        const auto x = (float) i * laneWidth + gap;
+        const auto width = laneWidth - 2.0f * gap;
+
+        // Proportion of the bar's height, linear in dB from the floor to full scale
+        const auto proportion = juce::jlimit (0.0f, 1.0f, (levelsDb[(size_t) i] - floorDb) / -floorDb);
+        const auto top = barBottom - proportion * (barBottom - barTop);
+
+        g.setColour (juce::Colour (0xFF0EA7B5));
+        g.fillRect (x, top, width, barBottom - top);
+
+        g.setColour (clipped[(size_t) i] ? juce::Colour (0xFFE8702A) : juce::Colour (0xFF3B3B3B));
+        g.fillRect (x, 0.0f, width, (float) clipMarkerHeight);
+
+        if (showNames)
+        {
+            g.setColour (juce::Colour (0xFFADB5BD));
+            g.drawText (channelNames[i], juce::Rectangle<float> (x, barBottom, width, (float) nameHeight),
+                        juce::Justification::centred, false);
+        }
+    }
+}
+
+void MeterBridge::mouseDown (const juce::MouseEvent&)
+{
+    resetClips();
+}
@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    MeterBridge.h
+    A compact row of per-channel peak meters, for any bus layout.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "MeterTelemetry.h"
+
+//==============================================================================
+/**
+    One thin bar per channel, from mono up to ChannelLevels::maxChannels, each with a
+    clip marker that stays lit until the bridge is clicked. Bars are labelled with
+    the channel names from the bus layout when there's room for them.
+
+    The editor hands it the channels' levels whenever there are new ones and calls
+    update() once per meter refresh. Bars jump up to new peaks and fall back at a fixed rate, and the bridge
+    only repaints itself while something on it is changing.
+*/
+class MeterBridge : public juce::Component
+{
+public:
+    MeterBridge();
+
+    /** Sets the number of bars and their names. Message thread. */
+    void setChannelLayout (const juce::AudioChannelSet& layout);
+
+    int getNumChannels() const noexcept     { return numChannels; }
+
+    /** Folds the channels' peaks and clip counts into the bars. */
+    void addLevels (const ChannelLevels& levels) noexcept;
+
+    /** Moves the bars on to the peaks added since the last call, or lets them fall,
+        and repaints if anything changed. Returns true while any bar is still up.
+    */
+    bool update();
+
+    /** Turns every clip marker off. */
+    void resetClips();
+
+    //==============================================================================
+    void paint (juce::Graphics&) override;
+    void mouseDown (const juce::MouseEvent&) override;
+
+private:
+    static constexpr float floorDb = -60.0f, fallDbPerSecond = 24.0f;
+    static constexpr int clipMarkerHeight = 3, nameHeight = 9, minBarWidthForNames = 12;
+
+    int numChannels = 0;
+    juce::StringArray channelNames;
+
+    std::array<float, ChannelLevels::maxChannels> levelsDb;
+    std::array<float, ChannelLevels::maxChannels> newPeaks {};
+    std::array<bool, ChannelLevels::maxChannels> clipped {};
+    bool clipsChanged = false;
+    double lastUpdateMs = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MeterBridge)
+};
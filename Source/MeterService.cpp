@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+
+    MeterService.cpp
+    One display-synced refresh tick shared by every processor and open editor in
+    the process.
+
+  ==============================================================================
+*/
+
+#include "MeterService.h"
+
+//==============================================================================
+MeterService::~MeterService()
+{
+    // Editors and processors hold the service, so they should all have gone by now
+    jassert (subscriptions.empty() && producers.empty());
+}
+
+void MeterService::subscribe (Client& client, juce::Component& component)
+{
+    const auto now = juce::Time::getMillisecondCounterHiRes();
+    subscriptions.push_back ({ &client, &component, now, now });
+
+    if (vBlankAttachment == nullptr)
+        attachVBlank();
+
+    if (! isTimerRunning())
+        startTimer ((int) activeIntervalMs);
+}
+
+void MeterService::unsubscribe (Client& client)
+{
+    const auto found = std::find_if (subscriptions.begin(), subscriptions.end(),
+                                     [&client] (const Subscription& s) { return s.client == &client; });
+
+    if (found == subscriptions.end())
+        return;
+
+    const bool wasVBlankSource = found->component == vBlankComponent;
+    subscriptions.erase (found);
+
+    if (subscriptions.empty())
+    {
+        // Nothing left to refresh; the timer keeps going for the processors, if any
+        vBlankAttachment.reset();
+        vBlankComponent = nullptr;
+
+        const juce::ScopedLock sl (producerLock);
+
+        if (producers.empty())
+            stopTimer();
+    }
+    else if (wasVBlankSource)
+    {
+        attachVBlank();
+    }
+}
+
+void MeterService::addProducer (Producer& producer)
+{
+    const juce::ScopedLock sl (producerLock);
+    producers.push_back (&producer);
+
+    if (! isTimerRunning())
+        startTimer ((int) activeIntervalMs);
+}
+
+void MeterService::removeProducer (Producer& producer)
+{
+    const juce::ScopedLock sl (producerLock);
+    producers.erase (std::remove (producers.begin(), producers.end(), &producer), producers.end());
+
+    // Every editor belongs to a processor, so once they've all gone there's nothing to tick
+    if (producers.empty())
+        stopTimer();
+}
+
+void MeterService::attachVBlank()
+{
+    vBlankAttachment.reset();
+    vBlankComponent = subscriptions.front().component;
+    vBlankAttachment = std::make_unique<juce::VBlankAttachment> (vBlankComponent, [this] { tick (true); });
+}
+
+//==============================================================================
+void MeterService::timerCallback()
+{
+    // Only stands in while the vblank callbacks aren't arriving, e.g. with the
+    // editor they're attached to minimised
+    if (juce::Time::getMillisecondCounterHiRes() - lastVBlankMs > vBlankTimeoutMs)
+        tick (false);
+}
+
+void MeterService::tick (bool fromVBlank)
+{
+    const auto now = juce::Time::getMillisecondCounterHiRes();
+
+    if (fromVBlank)
+        lastVBlankMs = now;
+
+    {
+        const juce::ScopedLock sl (producerLock);
+
+        for (auto* producer : producers)
+            producer->collectFromAudioThread();
+    }
+
+    for (auto& subscription : subscriptions)
+    {
+        if (now < subscription.nextRefreshMs)
+            continue;
+
+        if (subscription.client->refreshDisplays())
+            subscription.lastActiveMs = now;
+
+        const auto interval = now - subscription.lastActiveMs < idleAfterMs ? activeIntervalMs : idleIntervalMs;
+
+        // Early by a little, so jitter in the vblank callbacks doesn't skip a frame
+        subscription.nextRefreshMs = now + interval - jitterAllowanceMs;
+    }
+}
@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    MeterService.h
+    One display-synced refresh tick shared by every processor and open editor in
+    the process.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Drives the meter displays of every open editor from a single tick, instead of a
+    timer per editor. Processors and editors hold a juce::SharedResourcePointer to it,
+    so there is one per process, and it exists while any processor does.
+
+    The tick follows the display's vertical blank, through a juce::VBlankAttachment
+    on one of the subscribed editors, so meters move in step with the screen. When
+    that editor isn't on a display (or the platform has no vblank callback) a timer
+    takes over at the same rate. Each tick goes through the subscribers in one pass,
+    refreshing those that are due. A subscriber that has seen signal recently is due
+    every frame, up to 60 Hz; one that hasn't drops to 4 Hz after a second.
+
+    Every tick also goes to each processor, editor or not, so whatever its audio
+    thread hands over is picked up on the message thread without a timer of its own.
+
+    Message thread only, apart from adding and removing producers.
+*/
+class MeterService : private juce::Timer
+{
+public:
+    /** An editor whose meters the service refreshes. */
+    class Client
+    {
+    public:
+        virtual ~Client() = default;
+
+        /** Pulls the latest readings into the displays, repainting only what changed.
+            Returns false if no signal has come through since the last call.
+        */
+        virtual bool refreshDisplays() = 0;
+    };
+
+    /** A processor with work the audio thread leaves for the message thread. */
+    class Producer
+    {
+    public:
+        virtual ~Producer() = default;
+
+        /** Called on every tick, before any editor is refreshed. */
+        virtual void collectFromAudioThread() = 0;
+    };
+
+    MeterService() = default;
+    ~MeterService() override;
+
+    /** Starts refreshing the client, and ticking if it's the first. The component is
+        what the vblank callback can attach to, normally the client itself.
+    */
+    void subscribe (Client& client, juce::Component& component);
+
+    /** Stops refreshing the client, and ticking if it was the last. Call it before the
+        client is destroyed.
+    */
+    void unsubscribe (Client& client);
+
+    int getNumClients() const noexcept      { return (int) subscriptions.size(); }
+
+    /** Starts ticking the producer, and starts the timer if it's the first. Any thread,
+        as offline tools create processors on their own threads.
+    */
+    void addProducer (Producer& producer);
+
+    /** Stops ticking the producer, waiting for a tick that's under way. Any thread;
+        call it before the producer is destroyed.
+    */
+    void removeProducer (Producer& producer);
+
+private:
+    static constexpr double activeIntervalMs = 1000.0 / 60.0, idleIntervalMs = 250.0, idleAfterMs = 1000.0;
+    static constexpr double jitterAllowanceMs = 4.0, vBlankTimeoutMs = 100.0;
+
+    struct Subscription
+    {
+        Client* client;
+        juce::Component* component;
+        double nextRefreshMs, lastActiveMs;
+    };
+
+    void tick (bool fromVBlank);
+    void timerCallback() override;
+    void attachVBlank();
+
+    std::vector<Subscription> subscriptions;
+
+    std::vector<Producer*> producers;
+    juce::CriticalSection producerLock;
+
+    std::unique_ptr<juce::VBlankAttachment> vBlankAttachment;
+    juce::Component* vBlankComponent = nullptr;
+    double lastVBlankMs = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MeterService)
+};
@@ -0,0 +1,170 @@
+/*
+  ==============================================================================
+
+    MeterTelemetry.h
+    Per-block meter frames passed from the audio thread to the message thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpscQueue.h"
+
+//==============================================================================
+/** The meter readings for one processed block, across all channels. */
+struct MeterFrame
+{
+    float peak = 0.0f;              // largest absolute output sample
+    float truePeak = 0.0f;          // largest 4x interpolated output, never less than peak
+    float rms = 0.0f;
+    int numClippedSamples = 0;      // output samples above full scale
+    int numSamples = 0;
+    juce::int64 samplePosition = 0; // of the block's first sample, counted since prepareToPlay()
+    float gainDb = 0.0f;            // the gain the block was heading for at its end
+    bool autoGain = false;          // whether the auto gain set it
+
+    /** Folds a later frame into this one, so that it covers both blocks. */
+    void merge (const MeterFrame& later) noexcept
+    {
+        const auto totalSamples = numSamples + later.numSamples;
+
+        if (totalSamples > 0)
+            rms = std::sqrt ((rms * rms * (float) numSamples + later.rms * later.rms * (float) later.numSamples) / (float) totalSamples);
+
+        peak = std::max (peak, later.peak);
+        truePeak = std::max (truePeak, later.truePeak);
+        numClippedSamples += later.numClippedSamples;
+        numSamples = totalSamples;
+        gainDb = later.gainDb;
+        autoGain = later.autoGain;
+    }
+};
+
+//==============================================================================
+/**
+    Each channel's peak and clip count over however many blocks went by since the
+    consumer last took them. Kept apart from MeterFrame, as separate arrays so a
+    meter bridge reads each of them contiguously, so that the frame queue doesn't
+    carry maxChannels of each for every block. Only the first numChannels entries
+    mean anything.
+*/
+struct ChannelLevels
+{
+    static constexpr int maxChannels = 128;
+
+    int numChannels = 0;
+    std::array<float, maxChannels> peaks {};
+    std::array<int, maxChannels> clippedSamples {};
+
+    /** Folds one block's readings for numNewChannels channels into these. */
+    void add (const float* newPeaks, const int* newClippedSamples, int numNewChannels) noexcept
+    {
+        for (int i = numChannels; i < numNewChannels; ++i)
+        {
+            peaks[(size_t) i] = 0.0f;
+            clippedSamples[(size_t) i] = 0;
+        }
+
+        numChannels = std::max (numChannels, numNewChannels);
+
+        for (int i = 0; i < numNewChannels; ++i)
+        {
+            peaks[(size_t) i] = std::max (peaks[(size_t) i], newPeaks[i]);
+            clippedSamples[(size_t) i] += newClippedSamples[i];
+        }
+    }
+};
+
+//==============================================================================
+/**
+    Carries a MeterFrame for every processed block, and the channels' levels, from
+    the audio thread to one consumer of each (the processor's service tick and the
+    editor, or an analysis tool that doesn't run the message loop).
+
+    publish() never blocks or allocates. If the consumer falls behind or isn't
+    running, the frames that don't fit are merged into one pending frame, which is
+    published as soon as there is room. The channels' levels pile up on the audio
+    thread in the same way, and are handed over whenever the consumer has taken the
+    last lot. So peaks and clip counts are never lost, only time resolution.
+*/
+class MeterTelemetry
+{
+public:
+    /** Audio thread only. channelPeaks and channelClippedSamples have an entry for
+        each of numChannels channels.
+    */
+    void publish (const MeterFrame& frame, const float* channelPeaks, const int* channelClippedSamples, int numChannels) noexcept
+    {
+        pendingLevels.add (channelPeaks, channelClippedSamples, numChannels);
+        hasPendingLevels = true;
+        flush();
+
+        if (hasPending)
+        {
+            pending.merge (frame);
+            numMerged.store (numMerged.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+
+        if (! frames.push (frame))
+        {
+            pending = frame;
+            hasPending = true;
+        }
+    }
+
+    /** Audio thread only. Hands over anything still waiting for room, for blocks that
+        publish nothing of their own, so the last readings before a silence aren't held
+        back until it ends.
+    */
+    void flush() noexcept
+    {
+        if (hasPending && frames.push (pending))
+            hasPending = false;
+
+        if (hasPendingLevels && levels.push (pendingLevels))
+        {
+            pendingLevels.numChannels = 0;
+            hasPendingLevels = false;
+        }
+    }
+
+    /** Consumer only. Calls callback with each waiting frame, oldest first, and returns
+        how many there were.
+    */
+    template <typename Callback>
+    int drain (Callback&& callback)
+    {
+        int numFrames = 0;
+
+        for (MeterFrame frame; frames.pop (frame); ++numFrames)
+            callback (frame);
+
+        return numFrames;
+    }
+
+    /** Consumer only. Fills result with the channels' levels since the last call, if
+        any blocks were published since, and returns false otherwise.
+    */
+    bool takeChannelLevels (ChannelLevels& result) noexcept
+    {
+        return levels.pop (result);
+    }
+
+    /** How many frames have had to be merged because the consumer was behind. */
+    juce::uint32 getNumMergedFrames() const noexcept    { return numMerged.load (std::memory_order_relaxed); }
+
+private:
+    //==============================================================================
+    // A few dozen frames covers a refresh at 60 Hz for all but the smallest blocks
+    SpscQueue<MeterFrame, 32> frames;
+    SpscQueue<ChannelLevels, 1> levels;
+
+    // producer-side only
+    MeterFrame pending;
+    ChannelLevels pendingLevels;
+    bool hasPending = false, hasPendingLevels = false;
+    std::atomic<juce::uint32> numMerged { 0 };
+};
@@ -11,13 +11,15 @@
 
 //==============================================================================
 GainAudioProcessorEditor::GainAudioProcessorEditor (GainAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), audioProcessor (p),
+      levelHistoryView (p.levelHistory, customLnF.getTitlesFont().withHeight(11.0f)),
+      diagnosticsPanel (p, customLnF.getTitlesFont().withHeight(11.0f))
 {
 
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (400, 480);
-    startTimer(25);
+    setSize (400, 560);
+    setOpaque(true);
 
     gainSlider.setLookAndFeel(&customLnF);
     gainSlider.setSliderStyle(juce::Slider::Rotary);
@@ -37,13 +39,13 @@ GainAudioProcessorEditor::GainAudioProcessorEditor (GainAudioProcessor& p)
     gainLabel.setFont(customLnF.getTitlesFont());
     addAndMakeVisible(gainLabel);
 
-    peakHeader.setText("Peak", juce::dontSendNotification);
+    peakHeader.setText("True Peak", juce::dontSendNotification);
     peakHeader.setJustificationType(juce::Justification::centred);
     peakHeader.setColour(juce::Label::textColourId, juce::Colour(textColour));
     peakHeader.setFont(customLnF.getTitlesFont());
     addAndMakeVisible(peakHeader);
 
-    peakLabel.setText("-Inf dB", juce::dontSendNotification);
+    peakLabel.setText("-Inf dBTP", juce::dontSendNotification);
     peakLabel.setJustificationType(juce::Justification::centredBottom);
     peakLabel.addMouseListener(this, true);
     peakLabel.setColour(juce::Label::textColourId, juce::Colour(textColour));
@@ -58,6 +60,31 @@ GainAudioProcessorEditor::GainAudioProcessorEditor (GainAudioProcessor& p)
     clipWarning.setFont(customLnF.getTitlesFont());
     addAndMakeVisible(clipWarning);
 
+    loudnessHeader.setText("Loudness", juce::dontSendNotification);
+    loudnessHeader.setJustificationType(juce::Justification::centred);
+    loudnessHeader.addMouseListener(this, true);
+    loudnessHeader.setColour(juce::Label::textColourId, juce::Colour(textColour));
+    loudnessHeader.setFont(customLnF.getTitlesFont());
+    addAndMakeVisible(loudnessHeader);
+
+    loudnessLabel.setText("-Inf LUFS", juce::dontSendNotification);
+    loudnessLabel.setJustificationType(juce::Justification::centredBottom);
+    loudnessLabel.addMouseListener(this, true);
+    loudnessLabel.setColour(juce::Label::textColourId, juce::Colour(textColour));
+    loudnessLabel.setColour(juce::Label::backgroundColourId, juce::Colour(0xFF141414));
+    loudnessLabel.setFont(customLnF.getAudioParamsFont());
+    addAndMakeVisible(loudnessLabel);
+
+    loudnessDetail.setJustificationType(juce::Justification::centred);
+    loudnessDetail.setColour(juce::Label::textColourId, juce::Colour(textColour));
+    loudnessDetail.setFont(customLnF.getTitlesFont().withHeight(11.0f));
+    addAndMakeVisible(loudnessDetail);
+
+    meterBridge.setChannelLayout(audioProcessor.getChannelLayoutOfBus(false, 0));
+    addAndMakeVisible(meterBridge);
+
+    addAndMakeVisible(levelHistoryView);
+
     gainLogo.setText("Gain", juce::dontSendNotification);
     gainLogo.setJustificationType(juce::Justification::right);
     gainLogo.setColour(juce::Label::textColourId, juce::Colour(textColour));
@@ -68,95 +95,165 @@ GainAudioProcessorEditor::GainAudioProcessorEditor (GainAudioProcessor& p)
     OPLogo.setJustificationType(juce::Justification::left);
     OPLogo.setColour(juce::Label::textColourId, juce::Colour(textColour));
     OPLogo.setFont(customLnF.getOPLogoFont());
+    OPLogo.addMouseListener(this, false);
     addAndMakeVisible(OPLogo);
+
+    addChildComponent(diagnosticsPanel);
+
+    meterService->subscribe(*this, *this);
 }
 
 GainAudioProcessorEditor::~GainAudioProcessorEditor()
 {
+    meterService->unsubscribe(*this);
     gainSlider.setLookAndFeel(nullptr);
 }
 
 //==============================================================================
-void GainAudioProcessorEditor::timerCallback()
+bool GainAudioProcessorEditor::refreshDisplays()
 {
-    peakDisplay = juce::Decibels::gainToDecibels(audioProcessor.currentPeak.load());
-    repaint();
+    // Nothing here repaints the whole editor: the labels repaint themselves when their
+    // text changes, and the LED only when it switches
+    const bool active = refreshMeters();
+
+    if (diagnosticsPanel.isVisible())
+        diagnosticsPanel.update();
+
+    return active;
 }
 
-//==============================================================================
-void GainAudioProcessorEditor::paint (juce::Graphics& g)
+bool GainAudioProcessorEditor::refreshMeters()
 {
-    // (Our component is opaque, so we must completely fill the background with a solid colour)
-    g.fillAll (juce::Colour(0xFF222222));
+    bool active = false;
+
+    // The host can change the layout while the editor is open
+    if (meterBridge.getNumChannels() != audioProcessor.getTotalNumOutputChannels())
+        meterBridge.setChannelLayout(audioProcessor.getChannelLayoutOfBus(false, 0));
+
+    // The held peak and clip count live on this side only, so a reset from
+    // mouseDown can't race with the audio thread. The processor has drained the
+    // frames on the same tick, just before the editors.
+    const auto readings = audioProcessor.takeMeterReadings();
+    heldPeak = std::max(heldPeak, readings.truePeak);
+    numClippedSamples += readings.numClippedSamples;
+    active = readings.active;
+    autoGainDb = readings.gainDb;
+    autoGainOn = readings.autoGain;
+
+    if (audioProcessor.meterTelemetry.takeChannelLevels(channelLevels))
+        meterBridge.addLevels(channelLevels);
+
+    levelHistoryView.update();
 
-    customLnF.drawPluginHeader(g, 400);
+    // Falling bars keep the refresh at full rate until they've settled
+    active = meterBridge.update() || active;
 
-    g.setColour(juce::Colour(textColour));
-    g.setFont(customLnF.getAudioParamsFont());
+    peakDisplay = juce::Decibels::gainToDecibels(heldPeak);
 
     if (peakDisplay == -100.0f) {
-        peakLabel.setText("-Inf dB", juce::dontSendNotification);
+        peakLabel.setText("-Inf dBTP", juce::dontSendNotification);
     }
     else {
-        peakLabel.setText(juce::String(peakDisplay, 2) + " dB", juce::dontSendNotification);
+        peakLabel.setText(juce::String(peakDisplay, 2) + " dBTP", juce::dontSendNotification);
     }
 
-    auto clipLEDBounds = juce::Rectangle<float>(318, 444, 15, 15);
-    float ledDiameter = 15.0f;
-    juce::Rectangle<float> ledArea(clipLEDBounds.getCentreX() - ledDiameter * 0.5f,
-        clipLEDBounds.getCentreY() - ledDiameter * 0.5f,
-        ledDiameter, ledDiameter);
-    bool ledOn;
-    int ledGlowLayers = 3;
-    float ledGlowAlpha = 0.3f;
-    float ledGlowArea = 2.0f;
+    gainLabel.setText(autoGainOn ? "Auto " + juce::String(autoGainDb > 0.0f ? "+" : "") + juce::String(autoGainDb, 1) + " dB"
+                                 : juce::String("Gain"),
+                      juce::dontSendNotification);
 
-    if (audioProcessor.isClipping) ledOn = true;
+    clipWarning.setText(numClippedSamples > 0 ? "Clip " + juce::String(numClippedSamples) : juce::String("Clip"),
+                        juce::dontSendNotification);
 
-    else ledOn = false;
+    // Inter-sample overs light the LED too, even when no sample is above full scale
+    const bool shouldLightLED = numClippedSamples > 0 || heldPeak > 1.0f;
 
-    juce::Colour ledColour = ledOn ? juce::Colour(0xFFE8702A) : juce::Colours::darkgrey;
+    if (shouldLightLED != ledOn) {
+        ledOn = shouldLightLED;
+        repaint(ledBounds);
+    }
 
-    if (ledOn) {
-        // Base layer
-        g.setColour(ledColour);
-        g.fillEllipse(ledArea);
+    // Loudness is worked out on a background thread, so there's only ever a latest reading
+    auto lufs = [] (float loudness) {
+        return loudness <= LoudnessMeter::silence ? juce::String("-Inf") : juce::String(loudness, 1);
+    };
 
-        // Outline layer
-        g.setColour(juce::Colour(0xFF222222));
-        g.drawEllipse(ledArea, 5.0f);
+    const auto loudness = audioProcessor.loudnessMeter.getReadings();
+    loudnessLabel.setText(lufs(loudness.integrated) + " LUFS", juce::dontSendNotification);
+    loudnessDetail.setText("M " + lufs(loudness.momentary) + "  S " + lufs(loudness.shortTerm)
+                           + "  LRA " + juce::String(loudness.range, 1), juce::dontSendNotification);
 
-        g.setColour(juce::Colours::darkgrey);
-        g.drawEllipse(ledArea, 2.0f);
+    return active;
+}
 
-        // Adding glow
-        for (int i = 0; i < ledGlowLayers; i++) {
-            g.setColour(ledColour.withAlpha(ledGlowAlpha));
-            g.fillEllipse(ledArea.expanded(ledGlowArea));
+//==============================================================================
+void GainAudioProcessorEditor::paint (juce::Graphics& g)
+{
+    // (Our component is opaque, so we must completely fill the background with a solid colour)
+    g.fillAll (juce::Colour(0xFF222222));
+
+    if (g.clipRegionIntersects({ 0, 0, getWidth(), CustomLnF::headerHeight + CustomLnF::headerHighlightHeight }))
+        customLnF.drawPluginHeader(g, 400);
+
+    if (! g.clipRegionIntersects(ledBounds))
+        return;
+
+    // The LED's two states are pre-rendered, glow included, and just swapped
+    auto drawLED = [this] (juce::Graphics& led, bool on) {
+        float ledDiameter = 15.0f;
+        juce::Rectangle<float> ledArea(ledGlowMargin, ledGlowMargin, ledDiameter, ledDiameter);
+        int ledGlowLayers = 3;
+        float ledGlowAlpha = 0.3f;
+        float ledGlowArea = 2.0f;
+
+        juce::Colour ledColour = on ? juce::Colour(0xFFE8702A) : juce::Colours::darkgrey;
 
-            ledGlowAlpha -= 0.1f;
-            ledGlowArea += 3.0f;
-        }
-    }
-    else {
         // Base layer
-        g.setColour(ledColour);
-        g.fillEllipse(ledArea);
+        led.setColour(ledColour);
+        led.fillEllipse(ledArea);
 
         // Outline layer
-        g.setColour(juce::Colour(0xFF222222));
-        g.drawEllipse(ledArea, 5.0f);
+        led.setColour(juce::Colour(0xFF222222));
+        led.drawEllipse(ledArea, 5.0f);
 
-        g.setColour(juce::Colours::darkgrey);
-        g.drawEllipse(ledArea, 2.0f);
-    }
+        led.setColour(juce::Colours::darkgrey);
+        led.drawEllipse(ledArea, 2.0f);
+
+        if (on) {
+            // Adding glow
+            for (int i = 0; i < ledGlowLayers; i++) {
+                led.setColour(ledColour.withAlpha(ledGlowAlpha));
+                led.fillEllipse(ledArea.expanded(ledGlowArea));
+
+                ledGlowAlpha -= 0.1f;
+                ledGlowArea += 3.0f;
+            }
+        }
+    };
+
+    if (ledOn)
+        ledOnLayer.draw(g, ledBounds, [&] (juce::Graphics& led) { drawLED(led, true); });
+    else
+        ledOffLayer.draw(g, ledBounds, [&] (juce::Graphics& led) { drawLED(led, false); });
 }
 
 void GainAudioProcessorEditor::mouseDown(const juce::MouseEvent& e)
 {
     if (e.eventComponent == &peakLabel || e.eventComponent == &clipWarning || e.eventComponent == &peakHeader) {
-        audioProcessor.isClipping = false;
-        audioProcessor.currentPeak.store(0.0f);
+        heldPeak = 0.0f;
+        numClippedSamples = 0;
+        meterBridge.resetClips();
+        refreshMeters();
+    }
+    else if (e.eventComponent == &loudnessLabel || e.eventComponent == &loudnessHeader) {
+        audioProcessor.loudnessMeter.resetIntegrated();
+    }
+}
+
+void GainAudioProcessorEditor::mouseDoubleClick(const juce::MouseEvent& e)
+{
+    if (e.eventComponent == &OPLogo) {
+        diagnosticsPanel.setVisible(! diagnosticsPanel.isVisible());
+        diagnosticsPanel.update();
     }
 }
 
@@ -168,8 +265,14 @@ void GainAudioProcessorEditor::resized()
     gainLogo.setBounds(345, 1, 50, 25);
     OPLogo.setBounds(2, 1, 200, 25);
 
+    meterBridge.setBounds(10, 32, 380, 24);
     gainSlider.setBounds(50, 80, 300, 325);
-    peakHeader.setBounds(50, 420, 50, 20);
-    peakLabel.setBounds(45, 441, 60, 22);
-    clipWarning.setBounds(300, 420, 50, 35);
+    peakHeader.setBounds(35, 420, 75, 20);
+    peakLabel.setBounds(30, 441, 80, 22);
+    clipWarning.setBounds(280, 420, 90, 35);
+    loudnessHeader.setBounds(115, 420, 160, 20);
+    loudnessLabel.setBounds(115, 441, 160, 22);
+    loudnessDetail.setBounds(100, 463, 190, 16);
+    levelHistoryView.setBounds(10, 486, 380, 64);
+    diagnosticsPanel.setBounds(20, 70, 360, 340);
 }
@@ -10,6 +10,11 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "LayerCache.h"
+#include "MeterBridge.h"
+#include "DiagnosticsPanel.h"
+#include "MeterService.h"
+#include "LevelHistoryView.h"
 
 //==============================================================================
 /**
@@ -29,13 +34,25 @@ public:
         auto center = bounds.getCentre();
         auto rotaryCenterAngle = (rotaryStartAngle + rotaryEndAngle) / 2;
 
-        g.setColour(juce::Colours::darkgrey);
-        g.fillEllipse(bounds);
+        // The body, track and inner ring don't move with the value, so they're drawn
+        // once into a cached image and only the value arc and pointer are drawn live
+        knobBody.draw(g, { x, y, diameter, diameter }, [&] (juce::Graphics& body) {
+            auto bodyBounds = juce::Rectangle<float>(0, 0, diameter, diameter).reduced(25);
+            auto bodyCenter = bodyBounds.getCentre();
 
-        juce::Path backgroundArc;
-        backgroundArc.addCentredArc(center.x, center.y, reducedRadius, reducedRadius, 0.0f, rotaryStartAngle, rotaryEndAngle, true);
-        g.setColour(juce::Colour(0xFF3B3B3B));
-        g.strokePath(backgroundArc, juce::PathStrokeType(10.0f));
+            body.setColour(juce::Colours::darkgrey);
+            body.fillEllipse(bodyBounds);
+
+            juce::Path backgroundArc;
+            backgroundArc.addCentredArc(bodyCenter.x, bodyCenter.y, reducedRadius, reducedRadius, 0.0f, rotaryStartAngle, rotaryEndAngle, true);
+            body.setColour(juce::Colour(0xFF3B3B3B));
+            body.strokePath(backgroundArc, juce::PathStrokeType(10.0f));
+
+            juce::Path innerCircle;
+            innerCircle.addEllipse(bodyBounds.reduced(6));
+            body.setColour(juce::Colour(0xFF3B3B3B).withAlpha(0.7f));
+            body.strokePath(innerCircle, juce::PathStrokeType(4.0f));
+        });
 
         juce::Path arc;
         auto angle = rotaryStartAngle + sliderPosProportional * (rotaryEndAngle - rotaryStartAngle);
@@ -43,11 +60,6 @@ public:
         g.setColour(juce::Colour(pluginHighlightColour));
         g.strokePath(arc, juce::PathStrokeType(4.0f));
 
-        juce::Path innerCircle;
-        innerCircle.addEllipse(bounds.reduced(6));
-        g.setColour(juce::Colour(0xFF3B3B3B).withAlpha(0.7f));
-        g.strokePath(innerCircle, juce::PathStrokeType(4.0f));
-
         juce::Path p;
         auto pointerLength = reducedRadius - 65;
         auto pointerThickness = 4.0f;
@@ -57,19 +69,22 @@ public:
         g.fillPath(p);
     }
 
+    static constexpr int headerHeight = 26;
+    static constexpr int headerHighlightHeight = 2;
+
     void drawPluginHeader(juce::Graphics& g, int editorWidth)
     {
-        juce::Path headerRect;
-        int headerHeight = 26;
-        headerRect.addRectangle(0, 0, editorWidth, headerHeight);
-        g.setColour(juce::Colour(0xFF181818));
-        g.fillPath(headerRect);
-
-        juce::Path headerHighlightRect;
-        int headerHighlightHeight = 2;
-        headerHighlightRect.addRectangle(0, headerHeight, editorWidth, headerHighlightHeight);
-        g.setColour(juce::Colour(pluginHighlightColour));
-        g.fillPath(headerHighlightRect);
+        pluginHeader.draw(g, { 0, 0, editorWidth, headerHeight + headerHighlightHeight }, [&] (juce::Graphics& header) {
+            juce::Path headerRect;
+            headerRect.addRectangle(0, 0, editorWidth, headerHeight);
+            header.setColour(juce::Colour(0xFF181818));
+            header.fillPath(headerRect);
+
+            juce::Path headerHighlightRect;
+            headerHighlightRect.addRectangle(0, headerHeight, editorWidth, headerHighlightHeight);
+            header.setColour(juce::Colour(pluginHighlightColour));
+            header.fillPath(headerHighlightRect);
+        });
     }
 
     CustomLnF()
@@ -132,10 +147,13 @@ private:
     juce::Font oxanium;
 
     int pluginHighlightColour = 0xFF0EA7B5;
+
+    LayerCache pluginHeader;
+    LayerCache knobBody;
 };
 
 class GainAudioProcessorEditor : public juce::AudioProcessorEditor,
-    private juce::Timer
+    private MeterService::Client
 {
 public:
     GainAudioProcessorEditor (GainAudioProcessor&);
@@ -145,12 +163,20 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
     void mouseDown(const juce::MouseEvent& e) override;
+    void mouseDoubleClick(const juce::MouseEvent& e) override;
+
+    // Pulls the processor's latest meter frames and loudness readings into the displays.
+    // Returns false if no signal has come through since the last call.
+    bool refreshMeters();
 
 private:
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     GainAudioProcessor& audioProcessor;
-    void timerCallback() override;
+    bool refreshDisplays() override;
+
+    // Refreshes this editor along with every other open one
+    juce::SharedResourcePointer<MeterService> meterService;
 
     juce::Slider gainSlider;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> gainSliderAttachment;
@@ -160,13 +186,40 @@ private:
     juce::Label peakHeader;
     juce::Label peakLabel;
     juce::Label clipWarning;
+    juce::Label loudnessHeader;
+    juce::Label loudnessLabel;
+    juce::Label loudnessDetail;
+
+    // One bar per channel of the main bus, and the levels taken for it, kept here
+    // rather than on the stack of every refresh
+    MeterBridge meterBridge;
+    ChannelLevels channelLevels;
+
+    // The output level over time, scrollable back through the processor's history
+    LevelHistoryView levelHistoryView;
 
     juce::Label gainLogo;
     juce::Label OPLogo;
 
+    // Hidden until the OpenPlugins logo is double-clicked
+    DiagnosticsPanel diagnosticsPanel;
+
     int textColour = 0xFFADB5BD;
 
     float peakDisplay = 0.0f;
+    float heldPeak = 0.0f;          // true peak, as linear gain
+
+    // The gain the auto gain has set, from the latest frame, shown in place of the knob's title
+    float autoGainDb = 0.0f;
+    bool autoGainOn = false;
+
+    juce::int64 numClippedSamples = 0;
+
+    // The LED, with room around it for the glow
+    static constexpr int ledGlowMargin = 10;
+    const juce::Rectangle<int> ledBounds { 318 - ledGlowMargin, 444 - ledGlowMargin, 15 + 2 * ledGlowMargin, 15 + 2 * ledGlowMargin };
+    bool ledOn = false;
+    LayerCache ledOnLayer, ledOffLayer;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GainAudioProcessorEditor)
 };
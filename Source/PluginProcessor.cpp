@@ -8,6 +8,21 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "ClapThreadPool.h"
+
+static_assert(GainAudioProcessor::maxChannels <= ChannelStats::maxChannels
+                && GainAudioProcessor::maxChannels <= ChannelLevels::maxChannels
+                && GainAudioProcessor::maxChannels <= LoudnessMeter::maxChannels
+                && GainAudioProcessor::maxChannels <= TruePeakDetector::maxChannels
+                && GainAudioProcessor::maxChannels <= LookaheadLimiter::maxChannels
+                && GainAudioProcessor::maxChannels <= SoftClipper::maxChannels
+                && GainAudioProcessor::maxChannels <= DcBlocker::maxChannels
+                && GainAudioProcessor::maxChannels <= Dither::maxChannels
+                && GainAudioProcessor::maxChannels <= AutoGain::maxChannels,
+              "Every meter and every stage have to cover every channel the bus can have");
+
+static_assert(GainAudioProcessor::channelsPerTask % DcBlocker::channelsPerGroup == 0,
+              "Each task's channels have to start a new group of the DC blocker's lanes");
 
 //==============================================================================
 GainAudioProcessor::GainAudioProcessor()
@@ -19,16 +34,66 @@ GainAudioProcessor::GainAudioProcessor()
 #endif
         .withOutput("Output", juce::AudioChannelSet::stereo(), true)
 #endif
-    ), apvts(*this, nullptr, "Parameters", { 
-        std::make_unique<juce::AudioParameterFloat>("GAIN", "Gain", -12.0f, 12.0f, 0) 
-        }
-        )
+    ), apvts(*this, nullptr, "Parameters", createParameterLayout())
+#endif
+{
+    gainParameter = apvts.getParameter("GAIN");
+    meterService->addProducer(*this);
+
+#if OPENGAIN_CLAP
+    for (auto* parameter : getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            clapParameters.emplace_back((clap_id) ranged->paramID.hashCode(), ranged);
 #endif
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout GainAudioProcessor::createParameterLayout()
 {
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    layout.add(std::make_unique<juce::AudioParameterFloat>("GAIN", "Gain", -12.0f, 12.0f, 0));
+    layout.add(std::make_unique<juce::AudioParameterBool>("SILENCE", "Silence Detection", true));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("CLIP", "Soft Clip", juce::StringArray { "Off", "2x", "4x", "8x" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("CLIP_FILTER", "Soft Clip Filter",
+                                                            juce::StringArray { "Polyphase IIR", "Linear Phase FIR" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterBool>("LIMITER", "Limiter", false));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("LOOKAHEAD", "Limiter Lookahead",
+                                                           juce::NormalisableRange<float>(1.0f, LookaheadLimiter::maxLookaheadMs, 0.1f), 5.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("RELEASE", "Limiter Release",
+                                                           juce::NormalisableRange<float>(10.0f, 1000.0f, 1.0f, 0.4f), 100.0f));
+    layout.add(std::make_unique<juce::AudioParameterBool>("DC_BLOCK", "DC Blocker", false));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("DC_CUTOFF", "DC Blocker Cutoff",
+                                                           juce::NormalisableRange<float>(DcBlocker::minCutoffHz, DcBlocker::maxCutoffHz, 0.1f, 0.5f),
+                                                           DcBlocker::defaultCutoffHz));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("DITHER", "Dither", juce::StringArray { "Off", "16-bit", "24-bit" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("DITHER_SHAPE", "Dither Noise Shaping",
+                                                            juce::StringArray { "Flat", "First Order", "Lipshitz", "Wannamaker" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("GAIN_MODE", "Gain Mode",
+                                                            juce::StringArray { "Linked", "Left/Right", "Mid/Side" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("LEFT", "Left Trim", -12.0f, 12.0f, 0));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("RIGHT", "Right Trim", -12.0f, 12.0f, 0));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("MID", "Mid Trim", -12.0f, 12.0f, 0));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("SIDE", "Side Trim", -12.0f, 12.0f, 0));
+    layout.add(std::make_unique<juce::AudioParameterBool>("AUTO_GAIN", "Auto Gain", false));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("AUTO_TARGET", "Auto Gain Target",
+                                                           juce::NormalisableRange<float>(AutoGain::minTargetLufs, AutoGain::maxTargetLufs, 0.1f),
+                                                           AutoGain::defaultTargetLufs));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("AUTO_ATTACK", "Auto Gain Attack",
+                                                           juce::NormalisableRange<float>(AutoGain::minAttackMs, AutoGain::maxAttackMs, 1.0f, 0.4f),
+                                                           AutoGain::defaultAttackMs));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("AUTO_RELEASE", "Auto Gain Release",
+                                                           juce::NormalisableRange<float>(AutoGain::minReleaseMs, AutoGain::maxReleaseMs, 1.0f, 0.4f),
+                                                           AutoGain::defaultReleaseMs));
+    return layout;
 }
 
 GainAudioProcessor::~GainAudioProcessor()
 {
+    meterService->removeProducer(*this);
+
+#if OPENGAIN_CLAP
+    // In case the wrapper never said it was destroying the plugin
+    ClapThreadPool::detach(std::move(clapThreadPool));
+#endif
 }
 
 //==============================================================================
@@ -100,12 +165,97 @@ void GainAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
     // initialisation that you need..
 
     gainParam = apvts.getRawParameterValue("GAIN");
+    silenceDetectionParam = apvts.getRawParameterValue("SILENCE");
+    clipParam = apvts.getRawParameterValue("CLIP");
+    clipFilterParam = apvts.getRawParameterValue("CLIP_FILTER");
+    limiterParam = apvts.getRawParameterValue("LIMITER");
+    lookaheadParam = apvts.getRawParameterValue("LOOKAHEAD");
+    releaseParam = apvts.getRawParameterValue("RELEASE");
+    dcBlockParam = apvts.getRawParameterValue("DC_BLOCK");
+    dcCutoffParam = apvts.getRawParameterValue("DC_CUTOFF");
+    ditherParam = apvts.getRawParameterValue("DITHER");
+    ditherShapeParam = apvts.getRawParameterValue("DITHER_SHAPE");
+    gainModeParam = apvts.getRawParameterValue("GAIN_MODE");
+    trimParams = { apvts.getRawParameterValue("LEFT"), apvts.getRawParameterValue("RIGHT"),
+                   apvts.getRawParameterValue("MID"), apvts.getRawParameterValue("SIDE") };
+    autoGainParam = apvts.getRawParameterValue("AUTO_GAIN");
+    autoTargetParam = apvts.getRawParameterValue("AUTO_TARGET");
+    autoAttackParam = apvts.getRawParameterValue("AUTO_ATTACK");
+    autoReleaseParam = apvts.getRawParameterValue("AUTO_RELEASE");
+    const auto isa = GainKernelSupport::getBestAvailableISA();
+    floatKernels = &GainKernels<float>::forISA(isa);
+    doubleKernels = &GainKernels<double>::forISA(isa);
+
+    // Start at the current gain rather than ramping up from wherever we last were
+    lastGainDb = gainParam->load();
+    gainSmoother.reset(sampleRate, gainRampSeconds);
+    gainSmoother.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(lastGainDb));
+
+    for (auto& trim : pairTrims)
+        trim.reset(sampleRate, gainRampSeconds);
+
+    updatePairTrims(getTotalNumInputChannels(), 0, true);
+
+    // Picks up from the gain the parameter has just set
+    autoGain.prepare(sampleRate, getChannelLayoutOfBus(true, 0));
+    autoGainActive = false;
+    updateAutoGain();
+
+    truePeakDetector.prepare(samplesPerBlock, maxTasks);
+    dspLoad.prepare(sampleRate);
+
+    // An oversampler for every factor and filter, built for the precision the host is
+    // about to process in, so the audio thread can switch between them
+    clipper.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels(), isUsingDoublePrecision());
+    clipper.setOversampling((int) clipParam->load(), getClipFilter());
+    clipperActive = false;
+
+    // Sized for the longest lookahead, so the lookahead can change while playing
+    limiter.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+    limiterActive = false;
+
+    dcBlocker.prepare(sampleRate, getTotalNumInputChannels());
+    dcBlockerActive = false;
+    hostWasPlaying = false;
+    nextHostSample = -1;
+
+    // The error feedback state for every channel is allocated here
+    dither.prepare(samplesPerBlock, getTotalNumInputChannels());
+    ditherActive = false;
+
+    samplesHeld = 0;
+    updateDcBlocker();
+    updateClipper();
+    updateLimiter();
+    updateDither();
+    updateLatency();
+
+    // Here it goes to the host straight away, as it can't have started processing
+    setLatencySamples(latencySamples);
+    loudnessMeter.prepare(sampleRate, getChannelLayoutOfBus(false, 0));
+
+    // A row of hop energies per task, so blocks up to the prepared size can go to the pool
+    maxTaskSamples = samplesPerBlock;
+    maxTaskHops = loudnessMeter.getMaxNumHops(samplesPerBlock);
+    taskHopEnergies.assign((size_t) (maxTasks * maxTaskHops), 0.0);
+
+    samplePosition = 0;
+    idle = false;
 }
 
 void GainAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+
+    // Whatever comes in next won't follow on from the last block
+    dcBlocker.reset();
+}
+
+void GainAudioProcessor::setNonRealtime (bool isNonRealtime) noexcept
+{
+    juce::AudioProcessor::setNonRealtime(isNonRealtime);
+    loudnessMeter.setNonRealtime(isNonRealtime);
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -115,12 +265,11 @@ bool GainAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) con
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout the host offers, discrete, surround or ambisonic, up to maxChannels.
+    // Every channel gets the same gain, and the loudness meter weights them by type.
+    const auto& output = layouts.getMainOutputChannelSet();
+
+    if (output.isDisabled() || output.size() > maxChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -134,7 +283,39 @@ bool GainAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) con
 }
 #endif
 
-void GainAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+// Everything the audio thread does happens inside the tripwire's section, parameter
+// reads included: they all go through the APVTS's raw atomics. The section closes
+// after the timing does, so its report in a debug build isn't counted as load.
+void GainAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    const RealtimeTripwire::ScopedRealtimeSection realtime;
+    const DspLoadMonitor::ScopedBlock timing(dspLoad, buffer.getNumSamples());
+    processSamples(buffer);
+}
+
+void GainAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    const RealtimeTripwire::ScopedRealtimeSection realtime;
+    const DspLoadMonitor::ScopedBlock timing(dspLoad, buffer.getNumSamples());
+    processSamples(buffer);
+}
+
+bool GainAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template <typename SampleType>
+const GainKernels<SampleType>& GainAudioProcessor::getKernels() const noexcept
+{
+    if constexpr (std::is_same_v<SampleType, double>)
+        return *doubleKernels;
+    else
+        return *floatKernels;
+}
+
+template <typename SampleType>
+void GainAudioProcessor::processSamples (juce::AudioBuffer<SampleType>& buffer) noexcept
 {
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
@@ -156,30 +337,646 @@ void GainAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::M
     // Alternatively, you can process the samples with the channels
     // interleaved by keeping the same state.
 
-    float gainValue = juce::Decibels::decibelsToGain(gainParam->load());
-    float peak = 0.0f;
+    const int numSamples = buffer.getNumSamples();
+
+    // isBusesLayoutSupported() keeps the meters' per-channel arrays big enough
+    jassert(totalNumInputChannels <= maxChannels);
+
+    updateDcBlocker();
+    updateClipper();
+    updateLimiter();
+    updateDither();
+    updateAutoGain();
+    updateLatency();
+    checkForTransportJump(numSamples);
+    const bool inputIsSilent = silenceDetectionParam->load() >= 0.5f && isSilent(buffer, totalNumInputChannels);
+
+    if (inputIsSilent && samplesHeld <= 0) {
+        skipSilentBlock(buffer);
+        return;
+    }
+
+    idle.store(false, std::memory_order_relaxed);
+    numGainSteps = 0;
+
+    // The auto gain's points take the place of the host's, and of the parameter
+    if (autoGainActive) {
+        gainAutomation.clear();
+        autoGain.process(buffer.getArrayOfReadPointers(), totalNumInputChannels, numSamples, gainAutomation);
+    }
+
+    if (gainAutomation.isEmpty()) {
+        // The parameter is only read once per block, the smoother ramps on plain state from
+        // there. A block too short to finish one of the auto gain's sub-blocks carries on
+        // at the gain it has.
+        const float gainDb = autoGainActive ? lastGainDb : gainParam->load();
+
+        if (gainDb != lastGainDb) {
+            lastGainDb = gainDb;
+            gainSmoother.setTargetValue(juce::Decibels::decibelsToGain(gainDb));
+        }
+
+        planGainSegment(0, numSamples);
+    }
+    else {
+        // Sample-accurate automation: each segment ramps to reach its point's value
+        // exactly at the point's offset, and the block settles on the last value
+        int segmentStart = 0;
+
+        for (auto& point : gainAutomation) {
+            const int pointOffset = juce::jlimit(0, numSamples, point.sampleOffset);
+            const int segmentLength = pointOffset - segmentStart;
+            const float pointGain = juce::Decibels::decibelsToGain(point.gainDb);
+
+            if (segmentLength > 0) {
+                gainSmoother.setTargetValue(pointGain, segmentLength);
+                planGainSegment(segmentStart, segmentLength);
+                segmentStart = pointOffset;
+            }
+            else if (point.gainDb != lastGainDb) {
+                // A point at the very start of the block has no time to ramp into,
+                // so give it the normal smoothing ramp rather than a step
+                gainSmoother.setTargetValue(pointGain);
+            }
+
+            lastGainDb = point.gainDb;
+        }
+
+        gainAutomation.clear();
+
+        if (segmentStart < numSamples)
+            planGainSegment(segmentStart, numSamples - segmentStart);
+    }
+
+    updatePairTrims(totalNumInputChannels, numSamples, false);
+
+    // Wide buses go to the pool in groups of channels if there is one, otherwise the
+    // channels are done here one after another
+    std::fill_n(blockStats.peaks.begin(), totalNumInputChannels, 0.0f);
+    std::fill_n(blockStats.numClipped.begin(), totalNumInputChannels, 0);
+    blockStats.sumOfSquares = 0.0f;
+    float truePeak = 0.0f;
 
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
-    {
-        auto* channelData = buffer.getWritePointer(channel);
-        auto* channelReadData = buffer.getReadPointer(channel);
+    // The clipper's bypass and the limiter's gain are decided across every channel, so
+    // either keeps the block on the audio thread
+    if (! clipperActive && ! limiterActive && processChannelsInParallel(buffer, totalNumInputChannels, numSamples)) {
+        const int numTasks = (totalNumInputChannels + channelsPerTask - 1) / channelsPerTask;
+        auto* hopEnergies = taskHopEnergies.data();
 
-        for (int sample = 0; sample < buffer.getNumSamples(); ++sample) {
+        for (int task = 0; task < numTasks; ++task) {
+            truePeak = std::max(truePeak, taskResults[(size_t) task].truePeak);
+            blockStats.sumOfSquares += taskResults[(size_t) task].sumOfSquares;
 
-            channelData[sample] *= gainValue;
-            peak = std::max(peak, std::abs(channelReadData[sample]));
+            if (task > 0)
+                for (int hop = 0; hop < maxTaskHops; ++hop)
+                    hopEnergies[hop] += hopEnergies[task * maxTaskHops + hop];
         }
+
+        loudnessMeter.addHopEnergies(hopEnergies, numSamples);
+    }
+    else {
+        auto* channels = buffer.getArrayOfWritePointers();
+
+        if (dcBlockerActive)
+            dcBlocker.process(channels, 0, totalNumInputChannels, numSamples);
+
+        applyGainSteps(channels, totalNumInputChannels, blockStats);
+
+        // The meters show what leaves the plugin, so after clipping or limiting they measure again
+        if (clipperActive || limiterActive) {
+            if (clipperActive)
+                clipper.process(channels, totalNumInputChannels, numSamples, blockStats.combine(totalNumInputChannels).peak,
+                                getKernels<SampleType>());
+
+            if (limiterActive)
+                limiter.process(channels, totalNumInputChannels, numSamples);
+
+            samplesHeld = inputIsSilent ? samplesHeld - numSamples : latencySamples;
+
+            std::fill_n(blockStats.peaks.begin(), totalNumInputChannels, 0.0f);
+            std::fill_n(blockStats.numClipped.begin(), totalNumInputChannels, 0);
+            blockStats.sumOfSquares = 0.0f;
+
+            for (int channel = 0; channel < totalNumInputChannels; ++channel)
+                blockStats.add(channel, getKernels<SampleType>().measure(channels[channel], numSamples));
+        }
+
+        truePeak = truePeakDetector.process(buffer, totalNumInputChannels, blockStats.combine(totalNumInputChannels).peak);
+        loudnessMeter.process(buffer, totalNumInputChannels);
+    }
+
+    // The dither's noise is far below anything the meters show, so it goes on after
+    // they've measured the block
+    if (ditherActive)
+        dither.process(buffer.getArrayOfWritePointers(), totalNumInputChannels, numSamples);
+
+    // One frame per block goes to the editor; nothing here waits on the message thread
+    const auto total = blockStats.combine(totalNumInputChannels);
+
+    MeterFrame frame;
+    frame.peak = total.peak;
+    frame.truePeak = truePeak;
+    frame.numClippedSamples = total.numClipped;
+    frame.numSamples = numSamples;
+    frame.samplePosition = samplePosition;
+    frame.gainDb = lastGainDb;
+    frame.autoGain = autoGainActive;
+
+    if (const int numMeasured = numSamples * totalNumInputChannels; numMeasured > 0)
+        frame.rms = std::sqrt(total.sumOfSquares / (float) numMeasured);
+
+    meterTelemetry.publish(frame, blockStats.peaks.data(), blockStats.numClipped.data(), totalNumInputChannels);
+    samplePosition += numSamples;
+}
+
+void GainAudioProcessor::updateDcBlocker() noexcept
+{
+    const bool enabled = dcBlockParam->load() >= 0.5f;
+
+    // Switching on starts from empty state rather than whatever was left in it
+    if (enabled != dcBlockerActive) {
+        dcBlockerActive = enabled;
+        dcBlocker.reset();
+    }
+
+    dcBlocker.setCutoff(dcCutoffParam->load());
+}
+
+void GainAudioProcessor::checkForTransportJump (int numSamples) noexcept
+{
+    // Reading the position doesn't allocate or lock; hosts without a playhead, or
+    // without a timeline, never reset the filter this way
+    auto* playHead = getPlayHead();
+
+    if (playHead == nullptr)
+        return;
+
+    const auto position = playHead->getPosition();
+
+    if (! position.hasValue() || ! position->getTimeInSamples().hasValue())
+        return;
+
+    const auto time = *position->getTimeInSamples();
+    const bool playing = position->getIsPlaying();
+
+    if (playing && (! hostWasPlaying || time != nextHostSample))
+        dcBlocker.reset();
+
+    hostWasPlaying = playing;
+    nextHostSample = time + numSamples;
+}
+
+SoftClipper::Filter GainAudioProcessor::getClipFilter() const noexcept
+{
+    return clipFilterParam->load() >= 0.5f ? SoftClipper::Filter::linearPhaseFIR : SoftClipper::Filter::polyphaseIIR;
+}
+
+void GainAudioProcessor::updateClipper() noexcept
+{
+    const int factorLog2 = (int) clipParam->load();
+    const bool enabled = factorLog2 > 0;
+
+    // Every oversampler was built in prepareToPlay(), so a new factor or filter only
+    // picks another one. Switching off keeps the last, for switching back on.
+    if (enabled)
+        clipper.setOversampling(factorLog2, getClipFilter());
+
+    // Switching on starts from empty filters rather than whatever was left in them
+    if (enabled != clipperActive) {
+        clipperActive = enabled;
+        samplesHeld = 0;
+        clipper.reset();
     }
+}
+
+void GainAudioProcessor::updateLimiter() noexcept
+{
+    const bool enabled = limiterParam->load() >= 0.5f;
 
-    if (peak > currentPeak.load()) {
-        currentPeak.store(peak);
+    if (enabled != limiterActive) {
+        limiterActive = enabled;
+        samplesHeld = 0;
+        limiter.reset();
     }
 
-    if (peak > 1.0f) {
-        isClipping = true;
+    limiter.setLookahead(lookaheadParam->load());
+    limiter.setRelease(releaseParam->load());
+}
+
+void GainAudioProcessor::updateDither() noexcept
+{
+    const int choice = (int) ditherParam->load();
+    const bool enabled = choice > 0;
+
+    // Switching on starts without any error left over from before
+    if (enabled != ditherActive) {
+        ditherActive = enabled;
+        dither.reset();
+    }
+
+    dither.setFormat(choice == 1 ? 16 : 24, (Dither::Shape) juce::jlimit(0, 3, (int) ditherShapeParam->load()));
+}
+
+void GainAudioProcessor::updateAutoGain() noexcept
+{
+    autoGain.setParameters(autoTargetParam->load(), autoAttackParam->load(), autoReleaseParam->load());
+
+    // Switching on picks up from the gain as it stands. Switching off leaves lastGainDb
+    // where the auto gain had got to, so the gain ramps back to the parameter from there.
+    if (const bool enabled = autoGainParam->load() >= 0.5f; enabled != autoGainActive) {
+        autoGainActive = enabled;
+        autoGain.reset(lastGainDb);
     }
 }
 
+void GainAudioProcessor::updateLatency() noexcept
+{
+    const int latency = (clipperActive ? clipper.getLatencySamples() : 0) + (limiterActive ? limiter.getLatencySamples() : 0);
+
+    if (latency == latencySamples)
+        return;
+
+    // A longer delay reaches further back, possibly to signal from before a run of
+    // silence, so the silent blocks aren't skipped until that has come out too
+    if (latency > latencySamples)
+        samplesHeld = std::max(samplesHeld, latency);
+
+    // setLatencySamples() tells the listeners there and then, under their lock, so the
+    // host hears of it from collectFromAudioThread() on the next service tick
+    latencySamples = latency;
+    reportedLatency.store(latency, std::memory_order_relaxed);
+}
+
+void GainAudioProcessor::collectFromAudioThread()
+{
+    if (const int latency = reportedLatency.load(std::memory_order_relaxed); latency != getLatencySamples())
+        setLatencySamples(latency);
+
+    // Drained here rather than by the editor, so the history keeps its resolution
+    // while the editor is closed instead of the frames piling up into one
+    meterTelemetry.drain([this] (const MeterFrame& frame) {
+        meterReadings.truePeak = std::max(meterReadings.truePeak, frame.truePeak);
+        meterReadings.numClippedSamples += frame.numClippedSamples;
+        meterReadings.active = meterReadings.active || frame.peak > 0.0f;
+        meterReadings.gainDb = frame.gainDb;
+        meterReadings.autoGain = frame.autoGain;
+        levelHistory.addFrame(frame, getSampleRate());
+    });
+}
+
+GainAudioProcessor::MeterReadings GainAudioProcessor::takeMeterReadings() noexcept
+{
+    const auto readings = meterReadings;
+    meterReadings.truePeak = 0.0f;
+    meterReadings.numClippedSamples = 0;
+    meterReadings.active = false;
+    return readings;
+}
+
+void GainAudioProcessor::addGainChange (int sampleOffset, float gainDb) noexcept
+{
+    gainAutomation.add(sampleOffset, gainDb);
+}
+
+void GainAudioProcessor::setParameterFromHost (juce::RangedAudioParameter& parameter, float value, int sampleOffset)
+{
+    // As the plugin wrappers do it: the listeners are what update the APVTS values
+    // processBlock() reads, and the editor's attachments
+    const auto normalised = parameter.convertTo0to1(value);
+    parameter.setValue(normalised);
+    parameter.sendValueChangedMessageToListeners(normalised);
+
+    // Followed sample-accurately; the value just set is where the gain stays once the
+    // points stop
+    if (&parameter == gainParameter)
+        addGainChange(sampleOffset, parameter.convertFrom0to1(normalised));
+}
+
+#if OPENGAIN_CLAP
+//==============================================================================
+bool GainAudioProcessor::supportsDirectEvent (uint16_t spaceId, uint16_t type)
+{
+    return spaceId == CLAP_CORE_EVENT_SPACE_ID && type == CLAP_EVENT_PARAM_VALUE;
+}
+
+void GainAudioProcessor::handleDirectEvent (const clap_event_header_t* event, int sampleOffset)
+{
+    if (! supportsDirectEvent(event->space_id, event->type))
+        return;
+
+    const auto& change = *reinterpret_cast<const clap_event_param_value_t*>(event);
+    const auto found = std::find_if(clapParameters.begin(), clapParameters.end(),
+                                    [&] (const auto& entry) { return entry.first == change.param_id; });
+
+    if (found == clapParameters.end())
+        return;
+
+    // The value is in the parameter's own range, as the wrapper reports it to the host
+    setParameterFromHost(*found->second, (float) change.value, sampleOffset);
+}
+
+const void* GainAudioProcessor::getExtension (const char* extensionId)
+{
+    if (std::strcmp(extensionId, CLAP_EXT_THREAD_POOL) == 0)
+        return ClapThreadPool::getPluginExtension();
+
+    return nullptr;
+}
+
+void GainAudioProcessor::onClapPluginInit (const clap_plugin* plugin, const clap_host* host)
+{
+    clapThreadPool = ClapThreadPool::attach(plugin, host, *this);
+}
+
+void GainAudioProcessor::onClapPluginDestroy (const clap_plugin*)
+{
+    ClapThreadPool::detach(std::move(clapThreadPool));
+}
+#endif
+
+template <typename SampleType>
+bool GainAudioProcessor::isSilent (const juce::AudioBuffer<SampleType>& buffer, int numChannels) const noexcept
+{
+    if (buffer.hasBeenCleared())
+        return true;
+
+    // Stops at the first channel with anything audible in it
+    for (int channel = 0; channel < numChannels; ++channel)
+        if (! getKernels<SampleType>().isSilent(buffer.getReadPointer(channel), buffer.getNumSamples(), (SampleType) silenceThreshold))
+            return false;
+
+    return true;
+}
+
+template <typename SampleType>
+void GainAudioProcessor::skipSilentBlock (juce::AudioBuffer<SampleType>& buffer) noexcept
+{
+    // The gain has nothing to act on, so it jumps straight to where it should be
+    // rather than ramping, and any automation points for the block are used up
+    const float gainDb = autoGainActive ? autoGain.getGainDb()
+                       : gainAutomation.isEmpty() ? gainParam->load() : (gainAutomation.end() - 1)->gainDb;
+    gainAutomation.clear();
+    lastGainDb = gainDb;
+    gainSmoother.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(gainDb));
+    updatePairTrims(getTotalNumInputChannels(), 0, true);
+
+    // Sub-threshold input comes out as true silence, flagged as such for the host
+    buffer.clear();
+
+    // The filter and the delays only need emptying on the first silent block of a run
+    if (! isIdle()) {
+        dcBlocker.reset();
+        clipper.reset();
+        limiter.reset();
+    }
+
+    // No meter frame: the editor holds its peaks and backs off while nothing arrives.
+    // Anything the editor was too slow to take before the silence goes now, though.
+    // The loudness meter does need to see the silence, for its windows to decay.
+    meterTelemetry.flush();
+    truePeakDetector.reset();
+    loudnessMeter.processSilence(buffer.getNumSamples());
+
+    idle.store(true, std::memory_order_relaxed);
+    numSkippedBlocks.store(numSkippedBlocks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    samplePosition += buffer.getNumSamples();
+}
+
+void GainAudioProcessor::planGainSegment (int startSample, int numSamples) noexcept
+{
+    // Any part of the segment that is still ramping, then the rest at a fixed gain
+    auto ramp = gainSmoother.takeRamp(numSamples);
+
+    if (ramp.numSamples > 0)
+        gainSteps[(size_t) numGainSteps++] = { startSample, ramp.numSamples, ramp.start, ramp.increment };
+
+    if (numSamples > ramp.numSamples)
+        gainSteps[(size_t) numGainSteps++] = { startSample + ramp.numSamples, numSamples - ramp.numSamples,
+                                               gainSmoother.getTargetValue(), 0.0f };
+}
+
+std::array<float, 2> GainAudioProcessor::getPairTrimTargets (PairMode mode, bool unity) const noexcept
+{
+    // At unity mid/side passes the pair straight through: all direct, no cross
+    if (mode == PairMode::midSide)
+        return unity ? std::array<float, 2> { 1.0f, 0.0f }
+                     : std::array<float, 2> { (trimGains[2] + trimGains[3]) * 0.5f, (trimGains[2] - trimGains[3]) * 0.5f };
+
+    if (mode == PairMode::leftRight && ! unity)
+        return { trimGains[0], trimGains[1] };
+
+    return { 1.0f, 1.0f };
+}
+
+void GainAudioProcessor::updatePairTrims (int numChannels, int numSamples, bool jump) noexcept
+{
+    const auto wanted = numChannels == 2 ? (PairMode) juce::jlimit(0, 2, (int) gainModeParam->load()) : PairMode::linked;
+
+    for (size_t i = 0; i < trimParams.size(); ++i) {
+        if (const float db = trimParams[i]->load(); db != trimDb[i]) {
+            trimDb[i] = db;
+            trimGains[i] = juce::Decibels::decibelsToGain(db);
+        }
+    }
+
+    if (jump) {
+        pairMode = wanted;
+        const auto targets = getPairTrimTargets(pairMode, false);
+
+        for (size_t i = 0; i < pairTrims.size(); ++i)
+            pairTrims[i].setCurrentAndTargetValue(targets[i]);
+    }
+    else if (wanted != pairMode) {
+        // Every mode is the same as linked at unity, so once the trims have settled
+        // there the mode can switch without a click
+        const auto unity = getPairTrimTargets(pairMode, true);
+
+        if (! pairTrims[0].isSmoothing() && ! pairTrims[1].isSmoothing()
+              && pairTrims[0].getTargetValue() == unity[0] && pairTrims[1].getTargetValue() == unity[1]) {
+            pairMode = wanted;
+            const auto newUnity = getPairTrimTargets(pairMode, true);
+
+            for (size_t i = 0; i < pairTrims.size(); ++i)
+                pairTrims[i].setCurrentAndTargetValue(newUnity[i]);
+        }
+    }
+
+    const auto targets = getPairTrimTargets(pairMode, pairMode != wanted);
+
+    for (size_t i = 0; i < pairTrims.size(); ++i) {
+        if (targets[i] != pairTrims[i].getTargetValue())
+            pairTrims[i].setTargetValue(targets[i]);
+
+        pairTrimRamps[i] = pairTrims[i].takeRamp(numSamples);
+    }
+}
+
+template <typename SampleType>
+void GainAudioProcessor::applyPairGainSteps (SampleType* const* channels, ChannelStats& stats) const noexcept
+{
+    const auto& kernels = getKernels<SampleType>();
+
+    // A trim's value at a sample of the block: its ramp, then settled
+    auto trimAt = [this] (size_t trim, int sample) {
+        const auto& ramp = pairTrimRamps[trim];
+        return sample >= ramp.numSamples ? pairTrims[trim].getTargetValue()
+                                         : ramp.start + ramp.increment * (float) sample;
+    };
+
+    // Each step's gain times each trim is applied as one ramp. Where a trim is settled
+    // that's exact; where it's ramping too, the product is taken as a straight line
+    // between its values at either end of the step, which is near enough over a ramp.
+    for (int i = 0; i < numGainSteps; ++i) {
+        const auto& step = gainSteps[(size_t) i];
+        const int end = step.startSample + step.numSamples;
+        std::array<SampleType, 2> starts, increments;
+
+        for (size_t trim = 0; trim < 2; ++trim) {
+            if (step.startSample >= pairTrimRamps[trim].numSamples) {
+                const auto value = (SampleType) pairTrims[trim].getTargetValue();
+                starts[trim] = (SampleType) step.start * value;
+                increments[trim] = (SampleType) step.increment * value;
+            }
+            else {
+                const auto endGain = (SampleType) step.start + (SampleType) step.increment * (SampleType) step.numSamples;
+                starts[trim] = (SampleType) step.start * (SampleType) trimAt(trim, step.startSample);
+                increments[trim] = (endGain * (SampleType) trimAt(trim, end) - starts[trim]) / (SampleType) step.numSamples;
+            }
+        }
+
+        // Mid/side encodes, gains and decodes the pair in one pass
+        if (pairMode == PairMode::midSide) {
+            SampleStats leftStats, rightStats;
+            kernels.applyMidSide(channels[0] + step.startSample, channels[1] + step.startSample, step.numSamples,
+                                 starts[0], increments[0], starts[1], increments[1], leftStats, rightStats);
+            stats.add(0, leftStats);
+            stats.add(1, rightStats);
+            continue;
+        }
+
+        for (int channel = 0; channel < 2; ++channel) {
+            auto* data = channels[channel] + step.startSample;
+            const auto start = starts[(size_t) channel];
+            const auto increment = increments[(size_t) channel];
+
+            if (increment != (SampleType) 0)
+                stats.add(channel, kernels.applyGainRamp(data, step.numSamples, start, increment));
+            else if (start == (SampleType) 1)
+                stats.add(channel, kernels.measure(data, step.numSamples));
+            else
+                stats.add(channel, kernels.applyGain(data, step.numSamples, start));
+        }
+    }
+}
+
+template <typename SampleType>
+void GainAudioProcessor::applyGainSteps (SampleType* const* channels, int numChannels, ChannelStats& stats) const noexcept
+{
+    const auto& kernels = getKernels<SampleType>();
+
+    // A stereo pair in another mode has its own path; pairMode is only ever set on a
+    // stereo bus, which never goes to the pool
+    if (pairMode != PairMode::linked && numChannels == 2) {
+        applyPairGainSteps(channels, stats);
+        return;
+    }
+
+    // Gain and metering are done in one pass over each channel. Short stretches over
+    // many channels are done in one call across the channels, anything else one
+    // channel at a time; at unity the samples are only read for the meter.
+    for (int i = 0; i < numGainSteps; ++i) {
+        const auto& step = gainSteps[(size_t) i];
+        const auto start = (SampleType) step.start;
+        const auto increment = (SampleType) step.increment;
+
+        if (step.numSamples <= maxCrossChannelSamples && numChannels >= minCrossChannelChannels) {
+            kernels.applyGainAcrossChannels(channels, numChannels, step.startSample, step.numSamples, start, increment, stats);
+            continue;
+        }
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            auto* data = channels[channel] + step.startSample;
+
+            if (increment != (SampleType) 0)
+                stats.add(channel, kernels.applyGainRamp(data, step.numSamples, start, increment));
+            else if (start == (SampleType) 1)
+                stats.add(channel, kernels.measure(data, step.numSamples));
+            else
+                stats.add(channel, kernels.applyGain(data, step.numSamples, start));
+        }
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+bool GainAudioProcessor::processChannelsInParallel (juce::AudioBuffer<SampleType>& buffer, int numChannels, int numSamples) noexcept
+{
+    auto* pool = taskPool.load();
+
+    // The loudness rows are sized for the prepared block, so anything longer is done here
+    if (pool == nullptr || numChannels < minParallelChannels || numChannels * numSamples < minTaskWork.load()
+          || numSamples > maxTaskSamples)
+        return false;
+
+    // Taken here rather than by the tasks, as asking the buffer for write pointers
+    // also marks it as not cleared
+    auto* channels = buffer.getArrayOfWritePointers();
+
+    if constexpr (std::is_same_v<SampleType, double>)
+        doubleTaskChannels = channels;
+    else
+        floatTaskChannels = channels;
+
+    numTaskChannels = numChannels;
+    numTaskSamples = numSamples;
+
+    const bool done = pool->execute((numChannels + channelsPerTask - 1) / channelsPerTask);
+
+    floatTaskChannels = nullptr;
+    doubleTaskChannels = nullptr;
+    return done;
+}
+
+void GainAudioProcessor::runChannelTask (int taskIndex) noexcept
+{
+    const RealtimeTripwire::ScopedRealtimeSection realtime;
+    juce::ScopedNoDenormals noDenormals;
+
+    if (floatTaskChannels != nullptr)
+        processChannelGroup(floatTaskChannels, taskIndex);
+    else if (doubleTaskChannels != nullptr)
+        processChannelGroup(doubleTaskChannels, taskIndex);
+}
+
+template <typename SampleType>
+void GainAudioProcessor::processChannelGroup (SampleType* const* channels, int taskIndex) noexcept
+{
+    const int begin = taskIndex * channelsPerTask;
+    const int end = std::min(begin + channelsPerTask, numTaskChannels);
+    const int numChannels = end - begin;
+
+    // The group's channels are a whole number of the DC blocker's lane groups, so it
+    // only touches their own filter state
+    if (dcBlockerActive)
+        dcBlocker.process(channels, begin, end, numTaskSamples);
+
+    // The group's measurements go into its own slice of the block's, and its true peak
+    // is gated on its own sample peak
+    ChannelStats stats;
+    applyGainSteps(channels + begin, numChannels, stats);
+    std::copy_n(stats.peaks.begin(), numChannels, blockStats.peaks.begin() + begin);
+    std::copy_n(stats.numClipped.begin(), numChannels, blockStats.numClipped.begin() + begin);
+
+    auto& result = taskResults[(size_t) taskIndex];
+    result.sumOfSquares = stats.sumOfSquares;
+    result.truePeak = truePeakDetector.processChannels(channels, begin, end, numTaskSamples,
+                                                       stats.combine(numChannels).peak, taskIndex);
+
+    auto* hopEnergies = taskHopEnergies.data() + taskIndex * maxTaskHops;
+    std::fill_n(hopEnergies, maxTaskHops, 0.0);
+    loudnessMeter.weighChannels(channels, begin, end, numTaskSamples, hopEnergies);
+}
+
 //==============================================================================
 bool GainAudioProcessor::hasEditor() const
 {
@@ -198,9 +995,8 @@ void GainAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
 
-    auto state = apvts.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    // Written straight from the parameters, in the compact binary format; see BinaryState
+    BinaryState::write(apvts, destData);
 }
 
 void GainAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
@@ -208,6 +1004,12 @@ void GainAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
 
+    if (BinaryState::isBinaryState(data, sizeInBytes)) {
+        BinaryState::read(apvts, data, sizeInBytes);
+        return;
+    }
+
+    // Sessions saved before the binary format hold the APVTS's ValueTree as XML
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
     if (xmlState.get() != nullptr) {
         if (xmlState->hasTagName(apvts.state.getType())) {
@@ -9,11 +9,38 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "GainKernels.h"
+#include "GainSmoother.h"
+#include "GainAutomation.h"
+#include "MeterTelemetry.h"
+#include "LoudnessMeter.h"
+#include "TruePeakDetector.h"
+#include "ChannelTaskPool.h"
+#include "LookaheadLimiter.h"
+#include "SoftClipper.h"
+#include "DcBlocker.h"
+#include "Dither.h"
+#include "AutoGain.h"
+#include "DspLoadMonitor.h"
+#include "RealtimeTripwire.h"
+#include "BinaryState.h"
+#include "LevelHistory.h"
+#include "MeterService.h"
+
+#if OPENGAIN_CLAP
+ #include <clap-juce-extensions/clap-juce-extensions.h>
+
+ class ClapThreadPool;
+#endif
 
 //==============================================================================
 /**
 */
-class GainAudioProcessor  : public juce::AudioProcessor
+class GainAudioProcessor  : public juce::AudioProcessor,
+                            private MeterService::Producer
+                          #if OPENGAIN_CLAP
+                           , public clap_juce_extensions::clap_juce_audio_processor_capabilities
+                          #endif
 {
 public:
     //==============================================================================
@@ -29,6 +56,11 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
+
+    // Also tells the loudness meter, which may wait for its analysis when rendering offline
+    void setNonRealtime (bool isNonRealtime) noexcept override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -54,14 +86,298 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
 
     //==============================================================================
+    /** Queues a timestamped GAIN value (in dB) for the next processBlock() call.
+
+        Format wrappers that see the host's sample-accurate parameter events call this
+        on the audio thread before processBlock(), as the CLAP build does from
+        handleDirectEvent(). The block is then split at each point and ramped so that
+        the gain reaches each value exactly at its offset. Blocks without any queued
+        points fall back to reading the parameter once.
+    */
+    void addGainChange (int sampleOffset, float gainDb) noexcept;
+
+    /** Audio thread. Sets a parameter from a host event, in its own range, the way the
+        plugin wrappers do, so the values processBlock() reads and the editor follow it.
+        A GAIN change also goes to addGainChange() at sampleOffset.
+    */
+    void setParameterFromHost (juce::RangedAudioParameter& parameter, float value, int sampleOffset);
+
+    /** Message thread. Hands on what processBlock() has left for the message thread:
+        a new latency goes to the host from here, as setLatencySamples() notifies the
+        listeners, and the meter frames are drained into levelHistory and the meter
+        readings. The shared MeterService calls it on every tick, editor or not; tools
+        that don't run the message loop can call it themselves.
+    */
+    void collectFromAudioThread() override;
+
+    /** The meter frames drained since the readings were last taken, added up. */
+    struct MeterReadings
+    {
+        float truePeak = 0.0f;
+        juce::int64 numClippedSamples = 0;
+        bool active = false;            // whether any of the blocks had signal in them
+        float gainDb = 0.0f;            // as of the latest block
+        bool autoGain = false;
+    };
+
+    /** Message thread. Returns the readings since the last call, for the editor. */
+    MeterReadings takeMeterReadings() noexcept;
+
+    /** How long a change of the GAIN parameter takes to ramp in. */
+    static constexpr double gainRampSeconds = 0.02;
+
+    /** The most channels the main bus can have, in any layout: discrete, surround or ambisonic. */
+    static constexpr int maxChannels = 128;
+
+    /** Lets processBlock() hand groups of channels on wide buses to the pool's threads
+        rather than working through every channel itself. Pass nullptr to go back to
+        that. The pool has to outlive its use here. Any thread.
+
+        Blocks with fewer than minWork samples across all their channels stay on the
+        audio thread; the bench lowers it to time the pool on blocks of any size.
+    */
+    void setChannelTaskPool (ChannelTaskPool* pool, int minWork = minParallelWork) noexcept
+    {
+        minTaskWork.store (minWork);
+        taskPool.store (pool);
+    }
+
+    /** For the ChannelTaskPool: processes one group of channels of the current block.
+        Only valid while the processor is inside ChannelTaskPool::execute().
+    */
+    void runChannelTask (int taskIndex) noexcept;
+
+   #if OPENGAIN_CLAP
+    //==============================================================================
+    // clap-juce-extensions' hooks into the CLAP wrapper. CLAP_EVENT_PARAM_VALUE events
+    // come here rather than to the wrapper, so GAIN's reach addGainChange() at their
+    // offsets; the others are set just as the wrapper would set them. The host's
+    // clap.thread-pool, if it has one, is the channel task pool from the plugin's
+    // init() until it's destroyed.
+    bool supportsDirectEvent (uint16_t spaceId, uint16_t type) override;
+    void handleDirectEvent (const clap_event_header_t* event, int sampleOffset) override;
+    const void* getExtension (const char* extensionId) override;
+    void onClapPluginInit (const clap_plugin* plugin, const clap_host* host) override;
+    void onClapPluginDestroy (const clap_plugin* plugin) override;
+   #endif
+
+    /** Blocks go to the pool in groups of up to channelsPerTask channels when there are
+        at least minParallelChannels of them and minParallelWork samples in all. A block
+        costs roughly 6 ns per channel-sample on an x64 core, so that is about 25 us of work, a few
+        times what it takes a pool to wake its threads; smaller blocks are quicker done
+        on the audio thread alone.
+    */
+    static constexpr int channelsPerTask = 8, minParallelChannels = 2 * channelsPerTask, minParallelWork = 4096;
+
+    /** True if the last block was skipped by silence detection. Any thread. */
+    bool isIdle() const noexcept                        { return idle.load (std::memory_order_relaxed); }
+
+    /** How many blocks silence detection has skipped since the processor was created. Any thread. */
+    juce::uint64 getNumSkippedBlocks() const noexcept   { return numSkippedBlocks.load (std::memory_order_relaxed); }
+
+    //==============================================================================
+
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
     juce::AudioProcessorValueTreeState apvts;
     std::atomic<float>* gainParam = nullptr;
-    
-    std::atomic<float> currentPeak = 0.0f;
-    std::atomic<bool> isClipping = false;
+    std::atomic<float>* silenceDetectionParam = nullptr;
+    std::atomic<float>* clipParam = nullptr;
+    std::atomic<float>* clipFilterParam = nullptr;
+    std::atomic<float>* limiterParam = nullptr;
+    std::atomic<float>* lookaheadParam = nullptr;
+    std::atomic<float>* releaseParam = nullptr;
+    std::atomic<float>* dcBlockParam = nullptr;
+    std::atomic<float>* dcCutoffParam = nullptr;
+    std::atomic<float>* ditherParam = nullptr;
+    std::atomic<float>* ditherShapeParam = nullptr;
+    std::atomic<float>* gainModeParam = nullptr;
+    std::array<std::atomic<float>*, 4> trimParams {};     // LEFT, RIGHT, MID, SIDE
+    std::atomic<float>* autoGainParam = nullptr;
+    std::atomic<float>* autoTargetParam = nullptr;
+    std::atomic<float>* autoAttackParam = nullptr;
+    std::atomic<float>* autoReleaseParam = nullptr;
+
+    // A frame per processed block, drained by collectFromAudioThread(). The channels'
+    // levels are left for the editor's meter bridge.
+    MeterTelemetry meterTelemetry;
+
+    // Measures the output; readings are picked up by the editor
+    LoudnessMeter loudnessMeter;
+
+    // Times every processBlock() call, for the editor's diagnostics panel
+    DspLoadMonitor dspLoad;
+
+    // The output level over the last ten minutes, for the editor's history view. It's
+    // filled on the message thread by collectFromAudioThread(), whether or not the
+    // editor is open; the editor only reads it.
+    LevelHistory levelHistory;
 
 private:
     //==============================================================================
+    // Both processBlock() overloads run this, so each precision has its own native path
+    template <typename SampleType>
+    void processSamples (juce::AudioBuffer<SampleType>& buffer) noexcept;
+
+    // The gain for a block is worked out once as a list of steps, each a stretch of
+    // samples at start + increment * index, and then applied to every channel
+    struct GainStep
+    {
+        int startSample, numSamples;
+        float start, increment;
+    };
+
+    // Each automation segment takes up to two steps: a ramp, then a settled gain
+    std::array<GainStep, 2 * (GainAutomationQueue::capacity + 1)> gainSteps;
+    int numGainSteps = 0;
+
+    // Adds the steps for numSamples from startSample, taken from the smoother
+    void planGainSegment (int startSample, int numSamples) noexcept;
+
+    // Applies the block's steps to the channels and adds their measurements to stats
+    template <typename SampleType>
+    void applyGainSteps (SampleType* const* channels, int numChannels, ChannelStats& stats) const noexcept;
+
+    // The gain modes. On a stereo bus the main gain can be trimmed per channel, or for
+    // the mid and side, on top of the GAIN parameter; any other bus is always linked.
+    // The pair's two trims are smoothed like the gain, and a mode change first brings
+    // the old mode's trims back to unity, where every mode is the same as linked,
+    // before switching. For mid/side, the trims are kept as the direct and cross
+    // coefficients of GainKernels::applyMidSide() rather than as the mid and side gains.
+    enum class PairMode { linked, leftRight, midSide };
+
+    void updatePairTrims (int numChannels, int numSamples, bool jump) noexcept;
+    std::array<float, 2> getPairTrimTargets (PairMode mode, bool unity) const noexcept;
+
+    PairMode pairMode = PairMode::linked;
+    std::array<GainSmoother, 2> pairTrims;
+    std::array<GainSmoother::Ramp, 2> pairTrimRamps;   // this block's part of each trim's ramp
+
+    // The trim parameters as linear gains, only worked out again when one moves
+    std::array<float, 4> trimDb {}, trimGains { 1.0f, 1.0f, 1.0f, 1.0f };
+
+    template <typename SampleType>
+    void applyPairGainSteps (SampleType* const* channels, ChannelStats& stats) const noexcept;
+
+    // Stretches this short go through the cross-channel kernel when there are enough
+    // channels to fill its vectors; the bench has it ahead of one call per channel up
+    // to about 16 samples
+    static constexpr int maxCrossChannelSamples = 16, minCrossChannelChannels = 4;
+
+    // Silence detection: input blocks with nothing above silenceThreshold (-120 dBFS)
+    // skip the gain and the meters, and come out cleared
+    static constexpr float silenceThreshold = 1.0e-6f;
+
+    template <typename SampleType>
+    bool isSilent (const juce::AudioBuffer<SampleType>& buffer, int numChannels) const noexcept;
+
+    template <typename SampleType>
+    void skipSilentBlock (juce::AudioBuffer<SampleType>& buffer) noexcept;
+
+    // The optional DC blocker before the gain. Its state is cleared whenever the input
+    // stops following on from what it last saw: when it's switched on, when the host
+    // stops calling (releaseResources()), when the transport starts or jumps, and on
+    // the first block of a run of silence.
+    void updateDcBlocker() noexcept;
+    void checkForTransportJump (int numSamples) noexcept;
+
+    DcBlocker dcBlocker;
+    bool dcBlockerActive = false;
+    bool hostWasPlaying = false;
+    juce::int64 nextHostSample = -1;    // where the host's timeline should be at the next block
+
+    // The optional stages after the gain: the soft clipper, then the limiter. Both delay
+    // the signal, by the oversampling filters and by the lookahead, which is reported to
+    // the host as latency while they are on. Parameter changes are picked up on the
+    // audio thread, including a new oversampling factor or filter, as the clipper has an
+    // oversampler ready for each. A new latency is left in reportedLatency for the
+    // message thread to pass on, as telling the host takes locks.
+    void updateClipper() noexcept;
+    void updateLimiter() noexcept;
+    void updateLatency() noexcept;
+    SoftClipper::Filter getClipFilter() const noexcept;
+
+    // The optional auto gain, which drives the gain stage in place of the GAIN parameter
+    // and any host automation of it. It measures the input before anything else, and
+    // hands the gain stage a point to ramp to for every sub-block it completes.
+    void updateAutoGain() noexcept;
+
+    AutoGain autoGain;
+    bool autoGainActive = false;
+
+    // The optional dither, last of all, after the meters have measured the block
+    void updateDither() noexcept;
+
+    Dither dither;
+    bool ditherActive = false;
+
+    SoftClipper clipper;
+    bool clipperActive = false;
+    LookaheadLimiter limiter;
+    bool limiterActive = false;
+    int latencySamples = 0;
+    std::atomic<int> reportedLatency { 0 };
+
+    // How long those delays may still hold signal from before a run of silent blocks;
+    // silence detection only skips blocks once it has come out
+    int samplesHeld = 0;
+
+    // Picked in prepareToPlay() for the CPU we're running on
+    const GainKernels<float>* floatKernels = &GainKernels<float>::forISA (GainKernelISA::scalar);
+    const GainKernels<double>* doubleKernels = &GainKernels<double>::forISA (GainKernelISA::scalar);
+
+    template <typename SampleType>
+    const GainKernels<SampleType>& getKernels() const noexcept;
+
+    GainSmoother gainSmoother;
+    float lastGainDb = 0.0f;
+    GainAutomationQueue gainAutomation;
+
+    TruePeakDetector truePeakDetector;
+
+    // Parallel channel groups. The block's channels and sizes are set up on the audio
+    // thread before the pool runs the tasks, and each task writes only its own channels
+    // of blockStats and its own result slot and row of loudness energies, so nothing
+    // is shared between them and their results are merged without any locking.
+    template <typename SampleType>
+    bool processChannelsInParallel (juce::AudioBuffer<SampleType>& buffer, int numChannels, int numSamples) noexcept;
+
+    template <typename SampleType>
+    void processChannelGroup (SampleType* const* channels, int taskIndex) noexcept;
+
+    static constexpr int maxTasks = maxChannels / channelsPerTask;
+
+    struct alignas (64) TaskResult
+    {
+        float truePeak = 0.0f, sumOfSquares = 0.0f;
+    };
+
+    std::atomic<ChannelTaskPool*> taskPool { nullptr };
+
+    // Looked up once, so host events can be matched against it on the audio thread
+    juce::RangedAudioParameter* gainParameter = nullptr;
+
+   #if OPENGAIN_CLAP
+    // The wrapper's clap_id for each parameter, which is the hash of its ID
+    std::vector<std::pair<clap_id, juce::RangedAudioParameter*>> clapParameters;
+    std::unique_ptr<ClapThreadPool> clapThreadPool;
+   #endif
+
+    std::atomic<int> minTaskWork { minParallelWork };
+    float* const* floatTaskChannels = nullptr;
+    double* const* doubleTaskChannels = nullptr;
+    int numTaskChannels = 0, numTaskSamples = 0, maxTaskHops = 0, maxTaskSamples = 0;
+    ChannelStats blockStats;
+    std::array<TaskResult, maxTasks> taskResults;
+    std::vector<double> taskHopEnergies;
+
+    juce::int64 samplePosition = 0;
+
+    juce::SharedResourcePointer<MeterService> meterService;
+    MeterReadings meterReadings;    // message thread only
+
+    std::atomic<bool> idle { false };
+    std::atomic<juce::uint64> numSkippedBlocks { 0 };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GainAudioProcessor)
 };
@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    RealtimeTripwire.cpp
+    Debug-build check that the audio thread never allocates or takes a lock.
+
+  ==============================================================================
+*/
+
+#include "RealtimeTripwire.h"
+
+#if OPENGAIN_REALTIME_TRIPWIRE
+
+#include <new>
+
+#if JUCE_LINUX || JUCE_BSD || JUCE_MAC
+ #include <dlfcn.h>
+ #include <pthread.h>
+ #define OPENGAIN_TRIPWIRE_LOCKS 1
+#endif
+
+//==============================================================================
+namespace
+{
+    // How many sections the thread is inside. Plain thread_local ints need no
+    // allocation or lock to set up, so the hooks can read this from any thread.
+    thread_local int sectionDepth = 0;
+
+    std::atomic<juce::uint64> numAllocations { 0 }, numLocks { 0 };
+
+    inline void checkAllocation() noexcept
+    {
+        if (sectionDepth > 0)
+            numAllocations.fetch_add (1, std::memory_order_relaxed);
+    }
+
+    juce::uint64 getNumViolations() noexcept
+    {
+        return numAllocations.load (std::memory_order_relaxed) + numLocks.load (std::memory_order_relaxed);
+    }
+}
+
+RealtimeTripwire::ScopedRealtimeSection::ScopedRealtimeSection() noexcept
+    : violationsAtStart (getNumViolations())
+{
+    ++sectionDepth;
+}
+
+RealtimeTripwire::ScopedRealtimeSection::~ScopedRealtimeSection()
+{
+    --sectionDepth;
+
+    // Something in the section allocated, freed or locked. The counts can be read
+    // with getNumAllocations() and getNumLocks(), and a breakpoint in the hooks
+    // below will show where.
+    jassert (getNumViolations() == violationsAtStart);
+}
+
+juce::uint64 RealtimeTripwire::getNumAllocations() noexcept    { return numAllocations.load (std::memory_order_relaxed); }
+juce::uint64 RealtimeTripwire::getNumLocks() noexcept          { return numLocks.load (std::memory_order_relaxed); }
+
+//==============================================================================
+// The replacements for the global allocation functions. The array and nothrow forms
+// all come through these.
+void* operator new (std::size_t size)
+{
+    checkAllocation();
+
+    if (auto* p = std::malloc (size > 0 ? size : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new (std::size_t size, std::align_val_t alignment)
+{
+    checkAllocation();
+    const auto align = juce::jmax ((std::size_t) alignment, sizeof (void*));
+
+   #if JUCE_WINDOWS
+    if (auto* p = _aligned_malloc (size > 0 ? size : 1, align))
+        return p;
+   #else
+    void* p = nullptr;
+
+    if (posix_memalign (&p, align, size > 0 ? size : 1) == 0)
+        return p;
+   #endif
+
+    throw std::bad_alloc();
+}
+
+void operator delete (void* p) noexcept
+{
+    if (p != nullptr)
+        checkAllocation();
+
+    std::free (p);
+}
+
+void operator delete (void* p, std::align_val_t) noexcept
+{
+    if (p != nullptr)
+        checkAllocation();
+
+   #if JUCE_WINDOWS
+    _aligned_free (p);
+   #else
+    std::free (p);
+   #endif
+}
+
+void operator delete (void* p, std::size_t) noexcept                             { operator delete (p); }
+void operator delete (void* p, std::size_t, std::align_val_t alignment) noexcept { operator delete (p, alignment); }
+
+#if OPENGAIN_TRIPWIRE_LOCKS
+// Calls from this binary to pthread_mutex_lock end up here, and go on to the real
+// one, looked up on first use. JUCE builds plugins with hidden visibility, so the
+// host and other plugins never see this one. The pointer is constant-initialised,
+// so it has no guard that could itself lock.
+extern "C" int pthread_mutex_lock (pthread_mutex_t* mutex)
+{
+    using Lock = int (*) (pthread_mutex_t*);
+    static std::atomic<Lock> next { nullptr };
+    auto lock = next.load (std::memory_order_relaxed);
+
+    if (lock == nullptr)
+    {
+        lock = reinterpret_cast<Lock> (dlsym (RTLD_NEXT, "pthread_mutex_lock"));
+        next.store (lock, std::memory_order_relaxed);
+    }
+
+    if (sectionDepth > 0)
+        numLocks.fetch_add (1, std::memory_order_relaxed);
+
+    return lock (mutex);
+}
+#endif
+
+#else
+
+juce::uint64 RealtimeTripwire::getNumAllocations() noexcept    { return 0; }
+juce::uint64 RealtimeTripwire::getNumLocks() noexcept          { return 0; }
+
+#endif
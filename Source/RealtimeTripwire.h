@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    RealtimeTripwire.h
+    Debug-build check that the audio thread never allocates or takes a lock.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// On in debug builds unless the build says otherwise
+#ifndef OPENGAIN_REALTIME_TRIPWIRE
+ #if JUCE_DEBUG
+  #define OPENGAIN_REALTIME_TRIPWIRE 1
+ #else
+  #define OPENGAIN_REALTIME_TRIPWIRE 0
+ #endif
+#endif
+
+//==============================================================================
+/**
+    Catches allocations and locks in code that has to be real-time safe.
+
+    That code runs inside a ScopedRealtimeSection. With OPENGAIN_REALTIME_TRIPWIRE
+    set, the global operator new and operator delete count an allocation, and (on
+    Linux and macOS) pthread_mutex_lock counts a lock, whenever the thread calling
+    them is inside one; std::mutex and juce::CriticalSection both lock through it.
+    Nothing is reported from inside the hooks themselves, which would allocate in
+    turn: instead the section asserts as it closes if anything was counted while it
+    was open. Without OPENGAIN_REALTIME_TRIPWIRE it all compiles to nothing.
+*/
+struct RealtimeTripwire
+{
+    static constexpr bool isEnabled = OPENGAIN_REALTIME_TRIPWIRE != 0;
+
+    /** Marks the current thread as real-time until it goes out of scope. Sections
+        can nest.
+    */
+    class ScopedRealtimeSection
+    {
+    public:
+       #if OPENGAIN_REALTIME_TRIPWIRE
+        ScopedRealtimeSection() noexcept;
+        ~ScopedRealtimeSection();
+
+    private:
+        juce::uint64 violationsAtStart;
+       #else
+        ScopedRealtimeSection() noexcept {}
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedRealtimeSection)
+    };
+
+    /** How many allocations (or frees) and locks have been caught, since the
+        process started. Any thread.
+    */
+    static juce::uint64 getNumAllocations() noexcept;
+    static juce::uint64 getNumLocks() noexcept;
+};
@@ -0,0 +1,258 @@
+/*
+  ==============================================================================
+
+    SoftClipper.cpp
+    Oversampled soft clipper that drops out of oversampling on quiet passages.
+
+  ==============================================================================
+*/
+
+#include "SoftClipper.h"
+
+//==============================================================================
+void SoftClipper::prepare (double newSampleRate, int maximumBlockSize, int numChannels, bool doublePrecision)
+{
+    sampleRate = newSampleRate;
+    maxBlockSize = juce::jmax (1, maximumBlockSize);
+    numPreparedChannels = juce::jlimit (0, maxChannels, numChannels);
+    useDoubles = doublePrecision;
+
+    floatOversampler = nullptr;
+    doubleOversampler = nullptr;
+    int maxLatency = 0;
+
+    for (int factorLog2 = 1; factorLog2 <= maxFactorLog2; ++factorLog2)
+    {
+        for (auto filter : { Filter::polyphaseIIR, Filter::linearPhaseFIR })
+        {
+            const int index = getOversamplerIndex (factorLog2, filter);
+            floatOversamplers[(size_t) index].reset();
+            doubleOversamplers[(size_t) index].reset();
+            latencies[(size_t) index] = 0;
+
+            if (numPreparedChannels > 0)
+                latencies[(size_t) index] = useDoubles ? createOversampler (doubleOversamplers[(size_t) index], factorLog2, filter)
+                                                       : createOversampler (floatOversamplers[(size_t) index], factorLog2, filter);
+
+            maxLatency = juce::jmax (maxLatency, latencies[(size_t) index]);
+        }
+    }
+
+    // Room for priming and delaying behind the longest of them
+    historySize = maxLatency > 0 ? juce::nextPowerOfTwo (2 * maxLatency + 64 + maxLatency + maxBlockSize) : 0;
+    history.assign ((size_t) (numPreparedChannels * historySize), 0.0);
+
+    floatScratch.setSize (useDoubles || maxLatency == 0 ? 0 : numPreparedChannels, maxBlockSize);
+    doubleScratch.setSize (useDoubles && maxLatency > 0 ? numPreparedChannels : 0, maxBlockSize);
+
+    currentFactorLog2 = -1;
+    setOversampling (0, currentFilter);
+    reset();
+}
+
+void SoftClipper::setOversampling (int factorLog2, Filter filter) noexcept
+{
+    factorLog2 = juce::jlimit (0, maxFactorLog2, factorLog2);
+
+    if (isSetTo (factorLog2, filter))
+        return;
+
+    currentFactorLog2 = factorLog2;
+    currentFilter = filter;
+    floatOversampler = nullptr;
+    doubleOversampler = nullptr;
+    latency = 0;
+
+    if (currentFactorLog2 > 0 && numPreparedChannels > 0)
+    {
+        const auto index = (size_t) getOversamplerIndex (currentFactorLog2, currentFilter);
+        floatOversampler = floatOversamplers[index].get();
+        doubleOversampler = doubleOversamplers[index].get();
+        latency = latencies[index];
+    }
+
+    // The filters remember roughly twice their latency, so that much signal brings them
+    // back to where they would have been had they never stopped
+    primingLength = 2 * latency + 64;
+    fadeLength = juce::jlimit (1, 64, latency);
+    holdSamples = juce::jmax (primingLength, (int) (bypassHoldMs * 0.001 * sampleRate));
+
+    // Taking over while oversampling, the new filters start from the recent signal
+    // rather than from empty. While bypassed, the next loud block primes them anyway.
+    if (oversampling && doubleOversampler != nullptr)
+        prime (*doubleOversampler, numPreparedChannels);
+    else if (oversampling && floatOversampler != nullptr)
+        prime (*floatOversampler, numPreparedChannels);
+}
+
+bool SoftClipper::isSetTo (int factorLog2, Filter filter) const noexcept
+{
+    return factorLog2 == currentFactorLog2 && (factorLog2 == 0 || filter == currentFilter);
+}
+
+void SoftClipper::reset() noexcept
+{
+    for (auto& oversampler : floatOversamplers)
+        if (oversampler != nullptr)
+            oversampler->reset();
+
+    for (auto& oversampler : doubleOversamplers)
+        if (oversampler != nullptr)
+            oversampler->reset();
+
+    std::fill (history.begin(), history.end(), 0.0);
+    historyPosition = 0;
+
+    // Starts out oversampling, so the first loud block doesn't wait on priming
+    oversampling = true;
+    quietSamples = 0;
+}
+
+//==============================================================================
+template <typename SampleType>
+int SoftClipper::createOversampler (std::unique_ptr<juce::dsp::Oversampling<SampleType>>& oversampler, int factorLog2, Filter filter)
+{
+    using Oversampling = juce::dsp::Oversampling<SampleType>;
+    const auto type = filter == Filter::linearPhaseFIR ? Oversampling::filterHalfBandFIREquiripple
+                                                       : Oversampling::filterHalfBandPolyphaseIIR;
+
+    // Integer latency, so the bypass can match it with a plain delay
+    oversampler = std::make_unique<Oversampling> ((size_t) numPreparedChannels, (size_t) factorLog2, type, true, true);
+    oversampler->initProcessing ((size_t) maxBlockSize);
+    return juce::roundToInt (oversampler->getLatencyInSamples());
+}
+
+template <typename SampleType>
+juce::dsp::Oversampling<SampleType>* SoftClipper::getOversampler() const noexcept
+{
+    if constexpr (std::is_same_v<SampleType, double>)
+        return doubleOversampler;
+    else
+        return floatOversampler;
+}
+
+template <typename SampleType>
+void SoftClipper::process (SampleType* const* channels, int numChannels, int numSamples, float peak,
+                           const GainKernels<SampleType>& kernels) noexcept
+{
+    // Nothing to do without an oversampler for this precision
+    if (getOversampler<SampleType>() == nullptr)
+        return;
+
+    jassert (numChannels <= numPreparedChannels);
+    numChannels = juce::jmin (numChannels, numPreparedChannels);
+
+    // NaNs count as loud
+    const bool loud = ! (peak < knee * bypassLevel);
+
+    // The oversampler only takes up to the prepared block size at a time
+    for (int start = 0; start < numSamples; start += maxBlockSize)
+        processChunk (channels, numChannels, start, juce::jmin (maxBlockSize, numSamples - start), loud, kernels);
+}
+
+template void SoftClipper::process (float* const*, int, int, float, const GainKernels<float>&) noexcept;
+template void SoftClipper::process (double* const*, int, int, float, const GainKernels<double>&) noexcept;
+
+template <typename SampleType>
+void SoftClipper::processChunk (SampleType* const* channels, int numChannels, int startSample, int numSamples, bool loud,
+                                const GainKernels<SampleType>& kernels) noexcept
+{
+    auto& oversampler = *getOversampler<SampleType>();
+    const int mask = historySize - 1;
+
+    quietSamples = loud ? 0 : juce::jmin (quietSamples + numSamples, holdSamples);
+    const bool wanted = quietSamples < holdSamples;
+
+    if (wanted && ! oversampling)
+        prime (oversampler, numChannels);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto* input = channels[channel] + startSample;
+        auto* ring = history.data() + channel * historySize;
+
+        for (int i = 0; i < numSamples; ++i)
+            ring[(historyPosition + i) & mask] = (double) input[i];
+    }
+
+    if (wanted || oversampling)
+    {
+        juce::dsp::AudioBlock<SampleType> block (channels, (size_t) numChannels, (size_t) startSample, (size_t) numSamples);
+        auto upsampled = oversampler.processSamplesUp (block);
+
+        for (size_t channel = 0; channel < upsampled.getNumChannels(); ++channel)
+            kernels.softClip (upsampled.getChannelPointer (channel), (int) upsampled.getNumSamples(), (SampleType) knee);
+
+        oversampler.processSamplesDown (block);
+    }
+
+    // The delayed path, on its own or faded against the oversampled one. Switching on,
+    // the fade is over no more than the latency, so all of it comes from quiet samples
+    // that were already in the history.
+    if (wanted != oversampling || ! oversampling)
+    {
+        const int fade = wanted == oversampling ? 0 : juce::jmin (fadeLength, numSamples);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* output = channels[channel] + startSample;
+            const auto* ring = history.data() + channel * historySize;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto delayed = (SampleType) ring[(historyPosition + i - latency) & mask];
+
+                if (i < fade)
+                {
+                    const auto wet = (SampleType) (i + 1) / (SampleType) (fade + 1);
+                    const auto amount = wanted ? wet : (SampleType) 1 - wet;
+                    output[i] = delayed + (output[i] - delayed) * amount;
+                }
+                else if (! wanted)
+                {
+                    output[i] = delayed;
+                }
+            }
+        }
+
+        oversampling = wanted;
+    }
+
+    historyPosition = (historyPosition + numSamples) & mask;
+}
+
+template <typename SampleType>
+void SoftClipper::prime (juce::dsp::Oversampling<SampleType>& oversampler, int numChannels) noexcept
+{
+    auto& scratch = [this]() -> juce::AudioBuffer<SampleType>&
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleScratch;
+        else
+            return floatScratch;
+    }();
+
+    const int mask = historySize - 1;
+    oversampler.reset();
+
+    // Below the knee the curve does nothing, so the filters alone will do
+    for (int done = 0; done < primingLength;)
+    {
+        const int numSamples = juce::jmin (maxBlockSize, primingLength - done);
+        const int from = historyPosition - primingLength + done;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* data = scratch.getWritePointer (channel);
+            const auto* ring = history.data() + channel * historySize;
+
+            for (int i = 0; i < numSamples; ++i)
+                data[i] = (SampleType) ring[(from + i) & mask];
+        }
+
+        juce::dsp::AudioBlock<SampleType> block (scratch.getArrayOfWritePointers(), (size_t) numChannels, (size_t) numSamples);
+        oversampler.processSamplesUp (block);
+        oversampler.processSamplesDown (block);
+        done += numSamples;
+    }
+}
@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    SoftClipper.h
+    Oversampled soft clipper that drops out of oversampling on quiet passages.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "GainKernels.h"
+
+//==============================================================================
+/**
+    Rounds off peaks above the knee with the GainKernels' softClip() curve, run at 2,
+    4 or 8 times the sample rate so the harmonics it adds above the original Nyquist
+    are filtered out rather than aliased back down. The oversampling filters are
+    JUCE's half-band polyphase IIRs (little latency, not linear phase) or equiripple
+    FIRs (linear phase, more latency). The downsampling filter can ring slightly past
+    the curve's limit of 1, so this is not a brickwall; the limiter is.
+
+    Below the knee the curve does nothing, so once the signal has stayed well under it
+    for a while the oversampling is skipped and the samples just go through a delay as
+    long as the filters', keeping the latency the same either way. Switching back on
+    primes the filters with the recent signal first, and each switch crossfades between
+    the two paths.
+
+    prepare() builds an oversampler for every factor and filter, so switching between
+    them is left to the audio thread.
+*/
+class SoftClipper
+{
+public:
+    /** -6 dBFS. Samples below this come through untouched. */
+    static constexpr float knee = 0.5f;
+
+    /** The oversampling is skipped once blocks have peaked below knee * bypassLevel
+        (-12 dBFS) for bypassHoldMs, and resumes as soon as one doesn't.
+    */
+    static constexpr float bypassLevel = 0.5f, bypassHoldMs = 50.0f;
+
+    static constexpr int maxChannels = 128;
+    static constexpr int maxFactorLog2 = 3;
+
+    enum class Filter
+    {
+        polyphaseIIR,
+        linearPhaseFIR
+    };
+
+    //==============================================================================
+    /** Builds the oversamplers for every factor and filter, for doubles if
+        doublePrecision is true and floats otherwise, and sets the factor to 0. Not on
+        the audio thread.
+    */
+    void prepare (double sampleRate, int maximumBlockSize, int numChannels, bool doublePrecision);
+
+    /** Audio thread. Switches to the oversampler for 2^factorLog2 times the sample
+        rate, or none for 0. One that's taking over mid-stream is primed with the
+        recent signal first, so only the change of latency is heard.
+    */
+    void setOversampling (int factorLog2, Filter filter) noexcept;
+
+    /** True if the clipper was last set up for this factor and filter. */
+    bool isSetTo (int factorLog2, Filter filter) const noexcept;
+    int getFactorLog2() const noexcept                  { return currentFactorLog2; }
+
+    /** The oversampling filters' delay, which the bypass matches. */
+    int getLatencySamples() const noexcept              { return latency; }
+
+    /** False while quiet passages are going round the oversampling. */
+    bool isOversampling() const noexcept                { return oversampling; }
+
+    /** Empties the filters and the delay. */
+    void reset() noexcept;
+
+    /** Audio thread. Clips the first numChannels channels in place. peak is the
+        loudest sample among them, which decides whether they need oversampling.
+    */
+    template <typename SampleType>
+    void process (SampleType* const* channels, int numChannels, int numSamples, float peak,
+                  const GainKernels<SampleType>& kernels) noexcept;
+
+private:
+    //==============================================================================
+    // One oversampler per factor from 2x up, for each filter
+    static constexpr int numOversamplers = maxFactorLog2 * 2;
+    static int getOversamplerIndex (int factorLog2, Filter filter) noexcept  { return (factorLog2 - 1) * 2 + (int) filter; }
+
+    // Builds the oversampler for a factor and filter, and returns its latency
+    template <typename SampleType>
+    int createOversampler (std::unique_ptr<juce::dsp::Oversampling<SampleType>>& oversampler, int factorLog2, Filter filter);
+
+    template <typename SampleType>
+    juce::dsp::Oversampling<SampleType>* getOversampler() const noexcept;
+
+    template <typename SampleType>
+    void processChunk (SampleType* const* channels, int numChannels, int startSample, int numSamples, bool loud,
+                       const GainKernels<SampleType>& kernels) noexcept;
+
+    // Runs the primingLength samples before the current chunk through the filters
+    template <typename SampleType>
+    void prime (juce::dsp::Oversampling<SampleType>& oversampler, int numChannels) noexcept;
+
+    double sampleRate = 44100.0;
+    int maxBlockSize = 0, numPreparedChannels = 0;
+    bool useDoubles = false;
+
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, numOversamplers> floatOversamplers;
+    std::array<std::unique_ptr<juce::dsp::Oversampling<double>>, numOversamplers> doubleOversamplers;
+    std::array<int, numOversamplers> latencies {};
+
+    // The one in use, if any
+    int currentFactorLog2 = 0;
+    Filter currentFilter = Filter::polyphaseIIR;
+    juce::dsp::Oversampling<float>* floatOversampler = nullptr;
+    juce::dsp::Oversampling<double>* doubleOversampler = nullptr;
+    int latency = 0, primingLength = 0, fadeLength = 0, holdSamples = 0;
+
+    // The last samples in, per channel, for the delayed path and for priming. Sized
+    // for the oversampler with the most latency.
+    std::vector<double> history;
+    int historySize = 0, historyPosition = 0;
+
+    juce::AudioBuffer<float> floatScratch;
+    juce::AudioBuffer<double> doubleScratch;
+
+    bool oversampling = false;
+    int quietSamples = 0;
+};
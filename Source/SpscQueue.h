@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    SpscQueue.h
+    Wait-free single-producer, single-consumer queue of fixed capacity.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    A bounded queue for handing values from the audio thread to one consumer.
+
+    Both push() and pop() are wait-free and never allocate. The two indices live on
+    separate cache lines, and each side keeps its own copy of the other side's index,
+    only re-reading the shared one when the queue looks full (or empty). So in steady
+    state the audio and consumer threads don't keep stealing a cache line from
+    each other.
+*/
+template <typename Item, int capacity>
+class SpscQueue
+{
+public:
+    static_assert (capacity > 0 && (capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+    //==============================================================================
+    /** Producer only. Returns false, without blocking, if the queue is full. */
+    bool push (const Item& item) noexcept
+    {
+        const auto write = writeIndex.load (std::memory_order_relaxed);
+
+        if (write - producerReadIndex == (juce::uint32) capacity)
+        {
+            producerReadIndex = readIndex.load (std::memory_order_acquire);
+
+            if (write - producerReadIndex == (juce::uint32) capacity)
+                return false;
+        }
+
+        items[write & mask] = item;
+        writeIndex.store (write + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Consumer only. Returns false if there was nothing to pop. */
+    bool pop (Item& item) noexcept
+    {
+        const auto read = readIndex.load (std::memory_order_relaxed);
+
+        if (read == consumerWriteIndex)
+        {
+            consumerWriteIndex = writeIndex.load (std::memory_order_acquire);
+
+            if (read == consumerWriteIndex)
+                return false;
+        }
+
+        item = items[read & mask];
+        readIndex.store (read + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    //==============================================================================
+    static constexpr juce::uint32 mask = (juce::uint32) capacity - 1;
+
+    alignas (64) std::atomic<juce::uint32> writeIndex { 0 };
+    juce::uint32 producerReadIndex = 0;
+
+    alignas (64) std::atomic<juce::uint32> readIndex { 0 };
+    juce::uint32 consumerWriteIndex = 0;
+
+    alignas (64) std::array<Item, (size_t) capacity> items {};
+};
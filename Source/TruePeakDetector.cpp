@@ -0,0 +1,178 @@
+/*
+  ==============================================================================
+
+    TruePeakDetector.cpp
+    4x oversampled (ITU-R BS.1770 Annex 2) true-peak detection.
+
+  ==============================================================================
+*/
+
+#include "TruePeakDetector.h"
+
+#if defined (_M_X64) || defined (__x86_64__) || defined (__SSE2__) || (defined (_M_IX86_FP) && _M_IX86_FP == 2)
+ #define TRUE_PEAK_SSE 1
+ #include <immintrin.h>
+#elif defined (__ARM_NEON__) || defined (__ARM_NEON) || defined (_M_ARM64)
+ #define TRUE_PEAK_NEON 1
+ #include <arm_neon.h>
+#endif
+
+//==============================================================================
+// BS.1770-4 Annex 2, transposed: row t holds tap t of phases 0-3
+alignas (16) static const float coefficients[TruePeakDetector::tapsPerPhase][TruePeakDetector::numPhases]
+{
+    {  0.0017089843750f, -0.0291748046875f, -0.0189208984375f, -0.0083007812500f },
+    {  0.0109863281250f,  0.0292968750000f,  0.0330810546875f,  0.0148925781250f },
+    { -0.0196533203125f, -0.0517578125000f, -0.0582275390625f, -0.0266113281250f },
+    {  0.0332031250000f,  0.0891113281250f,  0.1015625000000f,  0.0476074218750f },
+    { -0.0594482421875f, -0.1665039062500f, -0.2003173828125f, -0.1022949218750f },
+    {  0.1373291015625f,  0.4650878906250f,  0.7797851562500f,  0.9721679687500f },
+    {  0.9721679687500f,  0.7797851562500f,  0.4650878906250f,  0.1373291015625f },
+    { -0.1022949218750f, -0.2003173828125f, -0.1665039062500f, -0.0594482421875f },
+    {  0.0476074218750f,  0.1015625000000f,  0.0891113281250f,  0.0332031250000f },
+    { -0.0266113281250f, -0.0582275390625f, -0.0517578125000f, -0.0196533203125f },
+    {  0.0148925781250f,  0.0330810546875f,  0.0292968750000f,  0.0109863281250f },
+    { -0.0083007812500f, -0.0189208984375f, -0.0291748046875f,  0.0017089843750f }
+};
+
+//==============================================================================
+float TruePeakDetector::interpolatedPeak (const float* samples, int numSamples) noexcept
+{
+    // Output n uses the input samples n + historyLength back to n, newest first
+    const float* newest = samples + historyLength;
+
+   #if TRUE_PEAK_SSE
+    const auto signMask = _mm_set1_ps (-0.0f);
+    auto peak = _mm_setzero_ps();
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        auto sum = _mm_setzero_ps();
+
+        for (int t = 0; t < tapsPerPhase; ++t)
+            sum = _mm_add_ps (sum, _mm_mul_ps (_mm_load_ps (coefficients[t]), _mm_set1_ps (newest[n - t])));
+
+        peak = _mm_max_ps (peak, _mm_andnot_ps (signMask, sum));
+    }
+
+    peak = _mm_max_ps (peak, _mm_movehl_ps (peak, peak));
+    peak = _mm_max_ss (peak, _mm_shuffle_ps (peak, peak, 1));
+    return _mm_cvtss_f32 (peak);
+   #elif TRUE_PEAK_NEON
+    auto peak = vdupq_n_f32 (0.0f);
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        auto sum = vdupq_n_f32 (0.0f);
+
+        for (int t = 0; t < tapsPerPhase; ++t)
+            sum = vmlaq_n_f32 (sum, vld1q_f32 (coefficients[t]), newest[n - t]);
+
+        peak = vmaxq_f32 (peak, vabsq_f32 (sum));
+    }
+
+    auto pair = vpmax_f32 (vget_low_f32 (peak), vget_high_f32 (peak));
+    pair = vpmax_f32 (pair, pair);
+    return vget_lane_f32 (pair, 0);
+   #else
+    float peak = 0.0f;
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        float sum[numPhases] {};
+
+        for (int t = 0; t < tapsPerPhase; ++t)
+            for (int phase = 0; phase < numPhases; ++phase)
+                sum[phase] += coefficients[t][phase] * newest[n - t];
+
+        for (auto s : sum)
+            peak = std::max (peak, std::abs (s));
+    }
+
+    return peak;
+   #endif
+}
+
+//==============================================================================
+void TruePeakDetector::prepare (int maximumBlockSize, int numWorkspaces)
+{
+    workspaceSize = historyLength + juce::jmax (1, maximumBlockSize);
+    scratch.assign ((size_t) (workspaceSize * juce::jmax (1, numWorkspaces)), 0.0f);
+    reset();
+}
+
+void TruePeakDetector::reset() noexcept
+{
+    for (auto& channel : history)
+        channel.fill (0.0f);
+}
+
+template <typename SampleType>
+void TruePeakDetector::updateHistory (int channel, const SampleType* data, int numSamples) noexcept
+{
+    auto& h = history[(size_t) channel];
+
+    if (numSamples >= historyLength)
+    {
+        std::copy (data + numSamples - historyLength, data + numSamples, h.begin());
+    }
+    else
+    {
+        std::move (h.begin() + numSamples, h.end(), h.begin());
+        std::copy (data, data + numSamples, h.end() - numSamples);
+    }
+}
+
+template <typename SampleType>
+float TruePeakDetector::process (const juce::AudioBuffer<SampleType>& buffer, int numChannels, float samplePeak) noexcept
+{
+    return processChannels (buffer.getArrayOfReadPointers(), 0, numChannels, buffer.getNumSamples(), samplePeak, 0);
+}
+
+template <typename SampleType>
+float TruePeakDetector::processChannels (const SampleType* const* channels, int beginChannel, int endChannel, int numSamples,
+                                         float samplePeak, int workspace) noexcept
+{
+    endChannel = juce::jmin (endChannel, maxChannels);
+    const bool interpolate = samplePeak >= detectionThreshold && ! scratch.empty();
+    auto* work = scratch.data() + workspace * workspaceSize;
+    float peak = samplePeak;
+
+    jassert (scratch.empty() || (size_t) ((workspace + 1) * workspaceSize) <= scratch.size());
+
+    for (int channel = beginChannel; channel < endChannel; ++channel)
+    {
+        const auto* data = channels[channel];
+
+        if (interpolate)
+        {
+            // The filter reads straight through from the history into the block, so
+            // both go into one buffer, a chunk at a time if the host's block is longer
+            // than it said it would be
+            const int chunkSize = workspaceSize - historyLength;
+
+            for (int start = 0; start < numSamples; start += chunkSize)
+            {
+                const int numToDo = juce::jmin (chunkSize, numSamples - start);
+                const auto& h = history[(size_t) channel];
+
+                std::copy (h.begin(), h.end(), work);
+                std::copy (data + start, data + start + numToDo, work + historyLength);
+
+                peak = std::max (peak, interpolatedPeak (work, numToDo));
+                updateHistory (channel, data + start, numToDo);
+            }
+        }
+        else
+        {
+            updateHistory (channel, data, numSamples);
+        }
+    }
+
+    return peak;
+}
+
+template float TruePeakDetector::process (const juce::AudioBuffer<float>&, int, float) noexcept;
+template float TruePeakDetector::process (const juce::AudioBuffer<double>&, int, float) noexcept;
+template float TruePeakDetector::processChannels (const float* const*, int, int, int, float, int) noexcept;
+template float TruePeakDetector::processChannels (const double* const*, int, int, int, float, int) noexcept;
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    TruePeakDetector.h
+    4x oversampled (ITU-R BS.1770 Annex 2) true-peak detection.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Finds the inter-sample peaks that a plain sample peak misses, by interpolating
+    each channel to 4x with the 48-tap polyphase FIR from BS.1770-4 Annex 2.
+
+    The coefficients are stored transposed, one row of the four phases per tap, so
+    that a single 4-lane vector multiply-add per tap produces all four interpolated
+    samples for an input sample.
+
+    Interpolating only matters when a block gets near full scale, so process() skips
+    the filter for blocks whose sample peak is below detectionThreshold and reports
+    the sample peak for them. The filter history is still kept up to date, so the
+    first block that does get checked is interpolated correctly from its first sample.
+*/
+class TruePeakDetector
+{
+public:
+    /** Blocks with a sample peak below this (-6 dBFS) aren't interpolated. */
+    static constexpr float detectionThreshold = 0.5f;
+
+    static constexpr int maxChannels = 128;
+
+    //==============================================================================
+    /** Allocates the working buffers and clears the history. Not on the audio thread.
+        Each of numWorkspaces can be used by one processChannels() call at a time.
+    */
+    void prepare (int maximumBlockSize, int numWorkspaces = 1);
+
+    void reset() noexcept;
+
+    /** Audio thread. Returns the true peak across the first numChannels channels of
+        the buffer, which is never less than samplePeak. Double buffers are interpolated
+        at float precision, which is plenty for a meter.
+    */
+    template <typename SampleType>
+    float process (const juce::AudioBuffer<SampleType>& buffer, int numChannels, float samplePeak) noexcept;
+
+    /** Audio thread or a worker. Like process(), for channels [beginChannel, endChannel)
+        only. Calls on disjoint channel ranges can run concurrently as long as each uses
+        a different workspace.
+    */
+    template <typename SampleType>
+    float processChannels (const SampleType* const* channels, int beginChannel, int endChannel, int numSamples,
+                           float samplePeak, int workspace) noexcept;
+
+    /** The largest absolute value of the 4x interpolated signal for numSamples output
+        positions, reading historyLength samples before each one. So samples must point
+        to historyLength + numSamples values.
+    */
+    static float interpolatedPeak (const float* samples, int numSamples) noexcept;
+
+    static constexpr int numPhases = 4, tapsPerPhase = 12, historyLength = tapsPerPhase - 1;
+
+private:
+    //==============================================================================
+    template <typename SampleType>
+    void updateHistory (int channel, const SampleType* data, int numSamples) noexcept;
+
+    std::vector<float> scratch;
+    int workspaceSize = 0;
+    std::array<std::array<float, historyLength>, maxChannels> history {};
+};
@@ -0,0 +1,273 @@
+/*
+  ==============================================================================
+
+    BatchFile.cpp
+    One file's trip through the batch tool: analysis, then a normalised render.
+
+  ==============================================================================
+*/
+
+#include "BatchFile.h"
+#include "ChunkedAudioReader.h"
+
+//==============================================================================
+BatchFile::BatchFile (const juce::File& inputFile, const juce::File& outputFile)
+    : input(inputFile), output(outputFile)
+{
+}
+
+bool BatchFile::fail (const juce::String& message)
+{
+    error = message;
+    return false;
+}
+
+std::unique_ptr<GainAudioProcessor> BatchFile::createProcessor (const BatchSettings& settings, float gain)
+{
+    auto processor = std::make_unique<GainAudioProcessor>();
+    const auto channelSet = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(channelSet);
+    layout.outputBuses.add(channelSet);
+
+    if (! processor->setBusesLayout(layout))
+        return nullptr;
+
+    auto setParameter = [&processor] (const juce::String& id, float value) {
+        if (auto* param = processor->apvts.getParameter(id))
+            param->setValueNotifyingHost(param->convertTo0to1(value));
+    };
+
+    setParameter("GAIN", gain);
+    setParameter("LIMITER", settings.useLimiter ? 1.0f : 0.0f);
+
+    processor->setNonRealtime(true);
+    processor->setRateAndBufferSizeDetails(sampleRate, settings.blockSize);
+    processor->prepareToPlay(sampleRate, settings.blockSize);
+    return processor;
+}
+
+//==============================================================================
+bool BatchFile::process (GainAudioProcessor& processor, juce::AudioFormatManager& formats, const BatchSettings& settings,
+                         juce::AudioFormatWriter* writer, Levels& levels)
+{
+    const auto chunkLength = juce::jmax((juce::int64) (settings.chunkSeconds * sampleRate), (juce::int64) settings.blockSize);
+    ChunkedAudioReader reader(formats, input, chunkLength);
+
+    if (reader.getReader() == nullptr)
+        return fail("couldn't open the file");
+
+    // The output lags the input by the processor's latency, so that many samples of
+    // silence are run in after the end and the same number dropped from the start
+    const int latency = processor.getLatencySamples();
+    const auto totalSamples = lengthInSamples + latency;
+
+    juce::AudioBuffer<float> buffer(numChannels, settings.blockSize);
+    juce::MidiBuffer midi;
+    float truePeak = 0.0f;
+
+    for (juce::int64 position = 0; position < totalSamples; position += settings.blockSize) {
+        const int numSamples = (int) juce::jmin((juce::int64) settings.blockSize, totalSamples - position);
+
+        if (! reader.read(buffer, position, numSamples))
+            return fail("read error at sample " + juce::String(position));
+
+        juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), numChannels, numSamples);
+        processor.processBlock(block, midi);
+
+        processor.meterTelemetry.drain([&truePeak] (const MeterFrame& frame) {
+            truePeak = std::max(truePeak, frame.truePeak);
+        });
+
+        if (writer != nullptr) {
+            const int skip = (int) juce::jlimit((juce::int64) 0, (juce::int64) numSamples, latency - position);
+
+            if (skip < numSamples && ! writer->writeFromAudioSampleBuffer(block, skip, numSamples - skip))
+                return fail("write error");
+        }
+    }
+
+    processor.loudnessMeter.flush();
+    const auto loudness = processor.loudnessMeter.getReadings();
+
+    levels.truePeak = truePeak;
+    levels.integrated = loudness.integrated;
+    levels.range = loudness.range;
+    return true;
+}
+
+//==============================================================================
+bool BatchFile::analyse (const BatchSettings& settings, juce::AudioFormatManager& formats)
+{
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    {
+        ChunkedAudioReader reader(formats, input, settings.blockSize);
+
+        if (auto* format = reader.getReader()) {
+            sampleRate = format->sampleRate;
+            numChannels = (int) format->numChannels;
+            inputBitsPerSample = (int) format->bitsPerSample;
+            lengthInSamples = format->lengthInSamples;
+        }
+        else {
+            return fail("couldn't open the file");
+        }
+    }
+
+    auto processor = createProcessor(settings, 0.0f);
+
+    if (processor == nullptr)
+        return fail("OpenGain doesn't support " + juce::String(numChannels) + " channel files");
+
+    if (! process(*processor, formats, settings, nullptr, inputLevels))
+        return false;
+
+    chooseGain(settings, processor->apvts.getParameterRange("GAIN"));
+    analysed = true;
+    analysisSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    return true;
+}
+
+void BatchFile::chooseGain (const BatchSettings& settings, const juce::NormalisableRange<float>& gainRange)
+{
+    const auto truePeakDb = juce::Decibels::gainToDecibels(inputLevels.truePeak, LoudnessMeter::silence);
+
+    if (settings.target == BatchSettings::Target::truePeak) {
+        if (inputLevels.truePeak <= 0.0f) {
+            gainDb = 0.0f;
+            gainLimitedBy = "silent";
+            return;
+        }
+
+        gainDb = settings.targetLevel - truePeakDb;
+        gainLimitedBy = "target";
+    }
+    else {
+        if (inputLevels.integrated <= LoudnessMeter::silence) {
+            gainDb = 0.0f;
+            gainLimitedBy = "silent";
+            return;
+        }
+
+        gainDb = settings.targetLevel - inputLevels.integrated;
+        gainLimitedBy = "target";
+
+        if (settings.hasMaxPeak && ! settings.useLimiter && truePeakDb + gainDb > settings.maxPeak) {
+            gainDb = settings.maxPeak - truePeakDb;
+            gainLimitedBy = "max-peak";
+        }
+    }
+
+    // As far as the Gain parameter goes
+    const float clamped = gainRange.getRange().clipValue(gainDb);
+
+    if (clamped != gainDb) {
+        gainDb = clamped;
+        gainLimitedBy = "gain-range";
+    }
+}
+
+//==============================================================================
+std::unique_ptr<juce::AudioFormatWriter> BatchFile::openOutput (juce::AudioFormatManager& formats, const BatchSettings& settings)
+{
+    auto* format = formats.findFormatForFileExtension(output.getFileExtension());
+
+    if (format == nullptr) {
+        fail("unsupported output format");
+        return nullptr;
+    }
+
+    int bitsPerSample = settings.bitsPerSample > 0 ? settings.bitsPerSample : inputBitsPerSample;
+
+    if (! format->getPossibleBitDepths().contains(bitsPerSample))
+        bitsPerSample = format->getPossibleBitDepths().getLast();
+
+    output.deleteFile();
+    std::unique_ptr<juce::FileOutputStream> stream(output.createOutputStream());
+
+    if (stream == nullptr) {
+        fail("couldn't write to " + output.getFullPathName());
+        return nullptr;
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), sampleRate, (unsigned int) numChannels,
+                                                                            bitsPerSample, {}, 0));
+
+    if (writer == nullptr) {
+        fail("couldn't create a " + format->getFormatName() + " writer");
+        return nullptr;
+    }
+
+    stream.release(); // now owned by the writer
+    return writer;
+}
+
+bool BatchFile::render (const BatchSettings& settings, juce::AudioFormatManager& formats)
+{
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    auto processor = createProcessor(settings, gainDb);
+
+    if (processor == nullptr)
+        return fail("OpenGain doesn't support " + juce::String(numChannels) + " channel files");
+
+    auto writer = openOutput(formats, settings);
+
+    if (writer == nullptr || ! process(*processor, formats, settings, writer.get(), outputLevels))
+        return false;
+
+    writer.reset();
+    rendered = true;
+    renderSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    return true;
+}
+
+//==============================================================================
+juce::String BatchFile::getSummary() const
+{
+    if (hasFailed())
+        return "FAILED " + input.getFileName() + ": " + error;
+
+    auto level = [] (float gain) { return juce::String(juce::Decibels::gainToDecibels(gain, LoudnessMeter::silence), 2); };
+
+    return input.getFileName() + ": " + juce::String(gainDb >= 0.0f ? "+" : "") + juce::String(gainDb, 2) + " dB ("
+           + gainLimitedBy + "), " + level(inputLevels.truePeak) + " -> " + level(outputLevels.truePeak) + " dBTP, "
+           + juce::String(inputLevels.integrated, 1) + " -> " + juce::String(outputLevels.integrated, 1) + " LUFS";
+}
+
+juce::var BatchFile::toJSON() const
+{
+    auto levelsToJSON = [] (const Levels& levels) {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("truePeak", juce::Decibels::gainToDecibels(levels.truePeak, LoudnessMeter::silence));
+        entry->setProperty("integrated", levels.integrated);
+        entry->setProperty("range", levels.range);
+        return juce::var(entry);
+    };
+
+    auto* entry = new juce::DynamicObject();
+    entry->setProperty("input", input.getFullPathName());
+    entry->setProperty("output", output.getFullPathName());
+    entry->setProperty("status", hasFailed() ? "failed" : "ok");
+
+    if (hasFailed())
+        entry->setProperty("error", error);
+
+    entry->setProperty("sampleRate", sampleRate);
+    entry->setProperty("channels", numChannels);
+    entry->setProperty("lengthInSamples", lengthInSamples);
+
+    if (analysed) {
+        entry->setProperty("inputLevels", levelsToJSON(inputLevels));
+        entry->setProperty("gainDb", gainDb);
+        entry->setProperty("gainLimitedBy", gainLimitedBy);
+        entry->setProperty("analysisSeconds", analysisSeconds);
+    }
+
+    if (rendered) {
+        entry->setProperty("outputLevels", levelsToJSON(outputLevels));
+        entry->setProperty("renderSeconds", renderSeconds);
+    }
+
+    return juce::var(entry);
+}
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    BatchFile.h
+    One file's trip through the batch tool: analysis, then a normalised render.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+//==============================================================================
+/** How every file in a batch is normalised. */
+struct BatchSettings
+{
+    enum class Target
+    {
+        truePeak,   // dBTP
+        loudness    // integrated, LUFS
+    };
+
+    Target target = Target::truePeak;
+    float targetLevel = -1.0f;
+
+    // For loudness targets: the gain is held down so the true peak stays under this,
+    // unless the limiter is on to take care of it
+    bool hasMaxPeak = false;
+    float maxPeak = -1.0f;
+
+    bool useLimiter = false;
+    int blockSize = 512;
+    double chunkSeconds = 10.0;     // how much of a file is mapped at a time
+    int bitsPerSample = 0;          // 0 to match each input
+};
+
+//==============================================================================
+/**
+    Both passes run the file through its own GainAudioProcessor, so the levels are
+    measured, and the gain applied, by exactly the DSP the plugin uses.
+
+    analyse() streams the input through a processor at unity gain and reads its true
+    peak and loudness meters, from which it works out the gain to reach the target.
+    render() then streams it through a second processor set to that gain (with the
+    limiter, if asked for) into the output file, removing the processor's latency,
+    and measures the result the same way.
+
+    Failures are recorded rather than thrown, so one bad file doesn't stop a batch.
+*/
+class BatchFile
+{
+public:
+    BatchFile (const juce::File& input, const juce::File& output);
+
+    /** Pass 1. Returns false if the file couldn't be read. */
+    bool analyse (const BatchSettings& settings, juce::AudioFormatManager& formats);
+
+    /** Pass 2, after a successful analyse(). */
+    bool render (const BatchSettings& settings, juce::AudioFormatManager& formats);
+
+    bool hasFailed() const noexcept                     { return error.isNotEmpty(); }
+    const juce::File& getInput() const noexcept         { return input; }
+    const juce::File& getOutput() const noexcept        { return output; }
+    double getLengthInSeconds() const noexcept          { return sampleRate > 0.0 ? (double) lengthInSamples / sampleRate : 0.0; }
+
+    /** A one-line summary for the console. */
+    juce::String getSummary() const;
+
+    /** The file's entry in the manifest. */
+    juce::var toJSON() const;
+
+private:
+    //==============================================================================
+    struct Levels
+    {
+        float truePeak = 0.0f;                              // linear
+        float integrated = LoudnessMeter::silence;          // LUFS
+        float range = 0.0f;                                 // LU
+    };
+
+    std::unique_ptr<GainAudioProcessor> createProcessor (const BatchSettings& settings, float gainDb);
+    bool process (GainAudioProcessor& processor, juce::AudioFormatManager& formats, const BatchSettings& settings,
+                  juce::AudioFormatWriter* writer, Levels& levels);
+    std::unique_ptr<juce::AudioFormatWriter> openOutput (juce::AudioFormatManager& formats, const BatchSettings& settings);
+    void chooseGain (const BatchSettings& settings, const juce::NormalisableRange<float>& gainRange);
+    bool fail (const juce::String& message);
+
+    const juce::File input, output;
+    juce::String error;
+
+    double sampleRate = 0.0;
+    int numChannels = 0, inputBitsPerSample = 0;
+    juce::int64 lengthInSamples = 0;
+
+    Levels inputLevels, outputLevels;
+    float gainDb = 0.0f;
+    juce::String gainLimitedBy;
+    double analysisSeconds = 0.0, renderSeconds = 0.0;
+    bool analysed = false, rendered = false;
+};
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    ChunkedAudioReader.h
+    Reads an audio file through a memory-mapped window of a fixed length.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Streams a file front to back with bounded memory, whatever its length. Formats
+    with a memory-mapped reader (WAV, AIFF) only ever have one chunk of the file
+    mapped, and the window moves on to start at the first block it doesn't cover.
+    Anything else (FLAC, Ogg) is decoded from a buffered stream instead.
+
+    One thread at a time.
+*/
+class ChunkedAudioReader
+{
+public:
+    ChunkedAudioReader (juce::AudioFormatManager& formats, const juce::File& file, juce::int64 chunkLengthInSamples)
+        : chunkLength (chunkLengthInSamples)
+    {
+        if (auto* format = formats.findFormatForFileExtension (file.getFileExtension()))
+            mapped.reset (format->createMemoryMappedReader (file));
+
+        if (mapped == nullptr)
+            streamed.reset (formats.createReaderFor (file));
+    }
+
+    /** Null if the file couldn't be opened. */
+    juce::AudioFormatReader* getReader() const noexcept
+    {
+        return mapped != nullptr ? static_cast<juce::AudioFormatReader*> (mapped.get()) : streamed.get();
+    }
+
+    /** Reads numSamples, at most the chunk length, into the buffer. Past the end of the
+        file the samples read as silence.
+    */
+    bool read (juce::AudioBuffer<float>& buffer, juce::int64 startSample, int numSamples)
+    {
+        auto* reader = getReader();
+        jassert (reader != nullptr && numSamples <= chunkLength);
+
+        // Mapped readers won't read outside the file at all, so the tail is cleared here
+        const int numInFile = (int) juce::jlimit ((juce::int64) 0, (juce::int64) numSamples, reader->lengthInSamples - startSample);
+        buffer.clear (numInFile, numSamples - numInFile);
+
+        if (numInFile == 0)
+            return true;
+
+        if (mapped != nullptr && ! mapped->getMappedSection().contains ({ startSample, startSample + numInFile }))
+            if (! mapped->mapSectionOfFile ({ startSample, juce::jmin (startSample + chunkLength, reader->lengthInSamples) }))
+                return false;
+
+        return reader->read (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), startSample, numInFile);
+    }
+
+private:
+    const juce::int64 chunkLength;
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped;
+    std::unique_ptr<juce::AudioFormatReader> streamed;
+
+    JUCE_DECLARE_NON_COPYABLE (ChunkedAudioReader)
+};
@@ -0,0 +1,209 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    OpenGainBatch: normalises many files to a true-peak or loudness target.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "BatchFile.h"
+#include "WorkStealingPool.h"
+
+//==============================================================================
+static float getLevelOption (const juce::ArgumentList& args, const juce::String& option)
+{
+    const auto value = args.getValueForOption(option);
+
+    if (! value.containsAnyOf("0123456789"))
+        juce::ConsoleApplication::fail(option + " needs a level in dB");
+
+    return value.getFloatValue();
+}
+
+static BatchSettings getSettings (const juce::ArgumentList& args)
+{
+    BatchSettings settings;
+
+    if (args.containsOption("--target-peak") == args.containsOption("--target-lufs"))
+        juce::ConsoleApplication::fail("Give one of --target-peak or --target-lufs");
+
+    if (args.containsOption("--target-peak")) {
+        settings.target = BatchSettings::Target::truePeak;
+        settings.targetLevel = getLevelOption(args, "--target-peak");
+    }
+    else {
+        settings.target = BatchSettings::Target::loudness;
+        settings.targetLevel = getLevelOption(args, "--target-lufs");
+    }
+
+    if (args.containsOption("--max-peak")) {
+        settings.hasMaxPeak = true;
+        settings.maxPeak = getLevelOption(args, "--max-peak");
+    }
+
+    settings.useLimiter = args.containsOption("--limiter");
+
+    if (args.containsOption("--block-size|-b"))
+        settings.blockSize = args.getValueForOption("--block-size|-b").getIntValue();
+
+    if (args.containsOption("--chunk-seconds"))
+        settings.chunkSeconds = args.getValueForOption("--chunk-seconds").getDoubleValue();
+
+    if (args.containsOption("--bits"))
+        settings.bitsPerSample = args.getValueForOption("--bits").getIntValue();
+
+    if (settings.blockSize <= 0)
+        juce::ConsoleApplication::fail("--block-size must be positive");
+
+    if (settings.chunkSeconds <= 0.0)
+        juce::ConsoleApplication::fail("--chunk-seconds must be positive");
+
+    return settings;
+}
+
+// The input file itself, or every audio file under the input directory, each with
+// its output at the same place relative to the output directory
+static std::vector<std::unique_ptr<BatchFile>> findFiles (juce::AudioFormatManager& formats, const juce::File& input,
+                                                          const juce::File& outputDirectory)
+{
+    std::vector<std::unique_ptr<BatchFile>> files;
+
+    if (input.isDirectory()) {
+        auto found = input.findChildFiles(juce::File::findFiles, true, formats.getWildcardForAllFormats());
+        found.sort();
+
+        for (auto& file : found)
+            files.push_back(std::make_unique<BatchFile>(file, outputDirectory.getChildFile(file.getRelativePathFrom(input))));
+    }
+    else {
+        files.push_back(std::make_unique<BatchFile>(input, outputDirectory.getChildFile(input.getFileName())));
+    }
+
+    return files;
+}
+
+//==============================================================================
+static void normalise (const juce::ArgumentList& args)
+{
+    const auto input = args.getExistingFileForOption("--input|-i");
+    const auto outputDirectory = args.getFileForOption("--output-dir|-o");
+    const auto settings = getSettings(args);
+    const int numThreads = args.containsOption("--threads|-j") ? args.getValueForOption("--threads|-j").getIntValue()
+                                                               : juce::SystemStats::getNumCpus();
+
+    if (numThreads <= 0)
+        juce::ConsoleApplication::fail("--threads must be positive");
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    auto files = findFiles(formats, input, outputDirectory);
+
+    if (files.empty())
+        juce::ConsoleApplication::fail("No audio files found in " + input.getFullPathName());
+
+    // Every output directory is made up front, rather than by jobs racing each other
+    for (auto& file : files) {
+        if (file->getOutput() == file->getInput())
+            juce::ConsoleApplication::fail("The output directory would overwrite " + file->getInput().getFullPathName());
+
+        if (! file->getOutput().getParentDirectory().createDirectory())
+            juce::ConsoleApplication::fail("Couldn't create " + file->getOutput().getParentDirectory().getFullPathName());
+    }
+
+    std::mutex consoleLock;
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    {
+        // Each analysis queues its file's render behind it on the same worker, while
+        // the other workers keep analysing, so the two passes overlap across files
+        WorkStealingPool pool(numThreads);
+
+        for (auto& file : files) {
+            pool.add([&pool, &file, &settings, &formats, &consoleLock] {
+                if (! file->analyse(settings, formats)) {
+                    const std::lock_guard<std::mutex> lock(consoleLock);
+                    std::cout << file->getSummary() << std::endl;
+                    return;
+                }
+
+                pool.add([&file, &settings, &formats, &consoleLock] {
+                    file->render(settings, formats);
+
+                    const std::lock_guard<std::mutex> lock(consoleLock);
+                    std::cout << file->getSummary() << std::endl;
+                });
+            });
+        }
+
+        pool.waitUntilDone();
+    }
+
+    const auto totalSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    double audioSeconds = 0.0;
+    int numFailed = 0;
+    juce::Array<juce::var> entries;
+
+    for (auto& file : files) {
+        audioSeconds += file->getLengthInSeconds();
+        numFailed += file->hasFailed() ? 1 : 0;
+        entries.add(file->toJSON());
+    }
+
+    auto* target = new juce::DynamicObject();
+    target->setProperty("type", settings.target == BatchSettings::Target::truePeak ? "truePeak" : "loudness");
+    target->setProperty("level", settings.targetLevel);
+
+    if (settings.hasMaxPeak)
+        target->setProperty("maxPeak", settings.maxPeak);
+
+    target->setProperty("limiter", settings.useLimiter);
+
+    auto* manifest = new juce::DynamicObject();
+    manifest->setProperty("version", 1);
+    manifest->setProperty("target", juce::var(target));
+    manifest->setProperty("threads", numThreads);
+    manifest->setProperty("totalSeconds", totalSeconds);
+    manifest->setProperty("audioSeconds", audioSeconds);
+    manifest->setProperty("files", entries);
+
+    const auto manifestFile = args.containsOption("--manifest") ? args.getFileForOption("--manifest")
+                                                                 : outputDirectory.getChildFile("manifest.json");
+
+    if (! manifestFile.replaceWithText(juce::JSON::toString(juce::var(manifest))))
+        juce::ConsoleApplication::fail("Couldn't write " + manifestFile.getFullPathName());
+
+    std::cout << "Normalised " << (int) files.size() - numFailed << " of " << (int) files.size() << " files ("
+              << juce::String(audioSeconds, 1) << " s of audio) in " << juce::String(totalSeconds, 2) << " s on "
+              << numThreads << " threads" << std::endl
+              << "Manifest: " << manifestFile.getFullPathName() << std::endl;
+
+    if (numFailed > 0)
+        juce::ConsoleApplication::fail(juce::String(numFailed) + " file(s) failed", 1);
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    // The processors' parameter state uses timers, which need a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ConsoleApplication app;
+    app.addHelpCommand("--help|-h", "Usage:", false);
+    app.addDefaultCommand({ "",
+                            "--input <file|dir> --output-dir <dir> (--target-peak <dBTP> | --target-lufs <LUFS>) "
+                            "[--max-peak <dBTP>] [--limiter] [--threads <n>] [--block-size <n>] [--chunk-seconds <s>] "
+                            "[--bits <n>] [--manifest <file.json>]",
+                            "Normalises a file, or every audio file under a directory, through GainAudioProcessor.",
+                            "Each file is analysed through the processor at unity gain, then rendered through it at the "
+                            "gain that reaches the target, clamped to the Gain parameter's range. With --target-lufs, "
+                            "--max-peak holds the gain down to keep the true peak under that level, unless --limiter "
+                            "turns the processor's limiter on instead. Outputs keep their paths relative to the input "
+                            "directory, and each file's levels, gain and timings go into the manifest (by default "
+                            "manifest.json in the output directory).",
+                            normalise });
+
+    return app.run(argc, argv);
+}
@@ -0,0 +1,194 @@
+/*
+  ==============================================================================
+
+    WorkStealingPool.h
+    Worker threads with a job deque each, that steal from each other when idle.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+//==============================================================================
+/**
+    Runs jobs across a fixed set of threads. Each worker has its own deque: jobs it
+    adds go to the back and it takes its next job from there too, so a job that adds
+    a follow-up gets it run next, on the same thread, while its data is still warm.
+    Jobs added from outside the pool wait in a shared queue, in order, which workers
+    take from when their own deque is empty. Failing that they steal from the front
+    of the others' deques, taking the oldest work first.
+
+    The batch tool uses this to pipeline its two passes: each file's analysis job
+    adds the file's render job, and the other workers carry on analysing the files
+    still waiting, so reading one file overlaps with processing another.
+*/
+class WorkStealingPool
+{
+public:
+    using Job = std::function<void()>;
+
+    explicit WorkStealingPool (int numThreads)
+        : workers ((size_t) juce::jmax (1, numThreads))
+    {
+        for (size_t i = 0; i < workers.size(); ++i)
+            workers[i].thread = std::thread ([this, i] { run (i); });
+    }
+
+    ~WorkStealingPool()
+    {
+        {
+            const std::lock_guard<std::mutex> lock (sleepLock);
+            quitting = true;
+        }
+
+        wakeUp.notify_all();
+
+        for (auto& worker : workers)
+            worker.thread.join();
+    }
+
+    int getNumThreads() const noexcept                  { return (int) workers.size(); }
+
+    /** Any thread, jobs included. */
+    void add (Job job)
+    {
+        if (currentWorker != nullptr && currentWorker->pool == this)
+        {
+            auto& worker = workers[currentWorker->index];
+            const std::lock_guard<std::mutex> lock (worker.lock);
+            worker.jobs.push_back (std::move (job));
+        }
+        else
+        {
+            const std::lock_guard<std::mutex> lock (incomingLock);
+            incoming.push_back (std::move (job));
+        }
+
+        {
+            const std::lock_guard<std::mutex> lock (sleepLock);
+            ++numQueued;
+            ++numUnfinished;
+        }
+
+        wakeUp.notify_one();
+    }
+
+    /** Not from a job. Returns once every job added so far, and every job they added,
+        has finished.
+    */
+    void waitUntilDone()
+    {
+        std::unique_lock<std::mutex> lock (sleepLock);
+        allDone.wait (lock, [this] { return numUnfinished == 0; });
+    }
+
+private:
+    //==============================================================================
+    struct Worker
+    {
+        std::mutex lock;
+        std::deque<Job> jobs;
+        std::thread thread;
+    };
+
+    struct WorkerIdentity
+    {
+        const WorkStealingPool* pool;
+        size_t index;
+    };
+
+    static bool takeFrom (std::mutex& lock, std::deque<Job>& jobs, bool newest, Job& job)
+    {
+        const std::lock_guard<std::mutex> scopedLock (lock);
+
+        if (jobs.empty())
+            return false;
+
+        job = std::move (newest ? jobs.back() : jobs.front());
+
+        if (newest)
+            jobs.pop_back();
+        else
+            jobs.pop_front();
+
+        return true;
+    }
+
+    // The newest of the worker's own jobs, or else the oldest from outside, or else
+    // the oldest of another worker's
+    bool takeJob (size_t index, Job& job)
+    {
+        if (takeFrom (workers[index].lock, workers[index].jobs, true, job)
+             || takeFrom (incomingLock, incoming, false, job))
+            return true;
+
+        for (size_t i = 1; i < workers.size(); ++i)
+        {
+            auto& victim = workers[(index + i) % workers.size()];
+
+            if (takeFrom (victim.lock, victim.jobs, false, job))
+                return true;
+        }
+
+        return false;
+    }
+
+    void run (size_t index)
+    {
+        const WorkerIdentity identity { this, index };
+        currentWorker = &identity;
+
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock (sleepLock);
+                wakeUp.wait (lock, [this] { return quitting || numQueued > 0; });
+
+                if (numQueued == 0)
+                    return;
+
+                // Claimed before it's taken, so no other worker goes looking for it
+                --numQueued;
+            }
+
+            Job job;
+
+            // It's in one of the queues, just maybe not yet visible from here
+            while (! takeJob (index, job))
+                std::this_thread::yield();
+
+            job();
+
+            bool finishedLast = false;
+
+            {
+                const std::lock_guard<std::mutex> lock (sleepLock);
+                finishedLast = --numUnfinished == 0;
+            }
+
+            if (finishedLast)
+                allDone.notify_all();
+        }
+    }
+
+    std::vector<Worker> workers;
+
+    std::mutex incomingLock;
+    std::deque<Job> incoming;
+
+    std::mutex sleepLock;
+    std::condition_variable wakeUp, allDone;
+    int numQueued = 0, numUnfinished = 0;
+    bool quitting = false;
+
+    static inline thread_local const WorkerIdentity* currentWorker = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE (WorkStealingPool)
+};
@@ -0,0 +1,193 @@
+/*
+  ==============================================================================
+
+    AutoGainBenchmarks.cpp
+    Auto gain: where it settles and how it gets there, and what the detector costs.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+
+//==============================================================================
+// What a stereo processor made of seconds of a 1 kHz sine at amplitude, in blocks of
+// blockSize: the last meter frame, the output's peak over the last block, and the
+// largest change of gain from one frame to the next
+struct AutoGainRun
+{
+    MeterFrame lastFrame;
+    float outputPeak = 0.0f, largestStepDb = 0.0f;
+};
+
+static AutoGainRun runAutoGain (GainAudioProcessor& processor, float amplitude, double seconds, int blockSize,
+                                juce::int64& position)
+{
+    constexpr double sampleRate = 48000.0;
+    const auto numSamples = (juce::int64) (seconds * sampleRate);
+
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::MidiBuffer midi;
+    AutoGainRun run;
+    float previousGainDb = processor.gainParam->load();
+
+    for (juce::int64 done = 0; done < numSamples; done += blockSize) {
+        const int thisBlock = (int) std::min((juce::int64) blockSize, numSamples - done);
+        buffer.setSize(2, thisBlock, false, false, true);
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < thisBlock; ++i)
+                buffer.setSample(channel, i, amplitude * (float) std::sin(juce::MathConstants<double>::twoPi * 1000.0 * (double) (position + i) / sampleRate));
+
+        processor.processBlock(buffer, midi);
+        position += thisBlock;
+        run.outputPeak = buffer.getMagnitude(0, thisBlock);
+
+        processor.meterTelemetry.drain([&] (const MeterFrame& frame) {
+            run.largestStepDb = std::max(run.largestStepDb, std::abs(frame.gainDb - previousGainDb));
+            previousGainDb = frame.gainDb;
+            run.lastFrame = frame;
+        });
+    }
+
+    return run;
+}
+
+static std::unique_ptr<GainAudioProcessor> createAutoGainProcessor (int blockSize)
+{
+    auto processor = createPreparedProcessor(2, 48000.0, blockSize);
+    processor->silenceDetectionParam->store(0.0f);
+    processor->autoGainParam->store(1.0f);
+    return processor;
+}
+
+// A stereo 1 kHz sine at -20 dBFS reads -20 LUFS, so a target of -18 asks for 2 dB more.
+// Switching on, the gain mustn't jump, and it has to ramp rather than step on the way;
+// silence leaves the gain where it was, too quiet an input holds at the top of the
+// range, and the block size makes no difference to any of it.
+static void checkAutoGain (BenchmarkRunner& runner)
+{
+    juce::int64 position = 0;
+    auto processor = createAutoGainProcessor(512);
+    processor->autoGainParam->store(0.0f);
+    runAutoGain(*processor, 0.1f, 0.5, 512, position);
+    processor->autoGainParam->store(1.0f);
+
+    const auto start = runAutoGain(*processor, 0.1f, 0.05, 512, position);
+
+    if (! start.lastFrame.autoGain)
+        runner.addFailure("Auto gain: the meter frames don't say it's on");
+
+    if (std::abs(start.lastFrame.gainDb) > 0.1f)
+        runner.addFailure("Auto gain: jumped to " + juce::String(start.lastFrame.gainDb, 2) + " dB on switching on");
+
+    const auto settled = runAutoGain(*processor, 0.1f, 10.0, 512, position);
+
+    if (std::abs(settled.lastFrame.gainDb - 2.0f) > 0.1f)
+        runner.addFailure("Auto gain: settled at " + juce::String(settled.lastFrame.gainDb, 2) + " dB on -20 LUFS rather than +2");
+
+    if (std::abs(settled.outputPeak - 0.1259f) > 0.002f)
+        runner.addFailure("Auto gain: output peak " + juce::String(settled.outputPeak, 4) + " after settling, rather than 0.1259");
+
+    if (settled.largestStepDb > 0.5f)
+        runner.addFailure("Auto gain: moved " + juce::String(settled.largestStepDb, 2) + " dB in one block");
+
+    const auto silent = runAutoGain(*processor, 0.0f, 2.0, 512, position);
+
+    if (std::abs(silent.lastFrame.gainDb - settled.lastFrame.gainDb) > 0.01f)
+        runner.addFailure("Auto gain: silence moved the gain from " + juce::String(settled.lastFrame.gainDb, 2) + " to "
+                          + juce::String(silent.lastFrame.gainDb, 2) + " dB");
+
+    const auto quiet = runAutoGain(*processor, 0.00316f, 20.0, 512, position);
+
+    if (quiet.lastFrame.gainDb != AutoGain::maxGainDb)
+        runner.addFailure("Auto gain: a -50 dBFS input got " + juce::String(quiet.lastFrame.gainDb, 2) + " dB rather than the maximum");
+
+    // The detector carries its sub-blocks across blocks, so 37 at a time gets the same
+    // answer as 512 at a time
+    float finalGainDb[2] {};
+
+    for (int i = 0; i < 2; ++i) {
+        const int blockSize = i == 0 ? 512 : 37;
+        juce::int64 blockPosition = 0;
+        auto blockProcessor = createAutoGainProcessor(blockSize);
+        finalGainDb[i] = runAutoGain(*blockProcessor, 0.1f, 37.0 * 512.0 * 8.0 / 48000.0, blockSize, blockPosition).lastFrame.gainDb;
+    }
+
+    if (std::abs(finalGainDb[0] - finalGainDb[1]) > 1.0e-3f)
+        runner.addFailure("Auto gain: blocks of 37 ended at " + juce::String(finalGainDb[1], 4) + " dB and blocks of 512 at "
+                          + juce::String(finalGainDb[0], 4));
+
+    // A block with more sub-blocks than the queue holds still fits its points in,
+    // evenly spread, and ends on the newest gain
+    for (int blockSize : { 2048, 8191, 65536 }) {
+        AutoGain detector;
+        detector.prepare(48000.0, juce::AudioChannelSet::stereo());
+        GainAutomationQueue points;
+
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        fillWithTestSignal(buffer, 48000.0);
+        detector.process(buffer.getArrayOfReadPointers(), 2, blockSize, points);
+
+        const int numSubBlocks = blockSize / AutoGain::subBlockSize;
+        const int stride = (numSubBlocks + GainAutomationQueue::capacity - 1) / GainAutomationQueue::capacity;
+        bool evenlySpread = true;
+
+        for (auto* point = points.begin(); point != points.end(); ++point)
+            if (point != points.begin() && point->sampleOffset - (point - 1)->sampleOffset != stride * AutoGain::subBlockSize)
+                evenlySpread = false;
+
+        if (points.size() != (numSubBlocks + stride - 1) / stride || ! evenlySpread
+             || (points.end() - 1)->sampleOffset != numSubBlocks * AutoGain::subBlockSize
+             || (points.end() - 1)->gainDb != detector.getGainDb())
+            runner.addFailure("Auto gain: a block of " + juce::String(blockSize) + " got " + juce::String(points.size())
+                              + " points, not every " + juce::String(stride) + " sub-blocks up to the last");
+    }
+}
+
+//==============================================================================
+void addAutoGainBenchmarks (BenchmarkRunner& runner)
+{
+    constexpr double sampleRate = 48000.0;
+
+    checkAutoGain(runner);
+
+    // The detector alone, every channel in SIMD lanes
+    for (int numChannels : { 2, 8, 64 }) {
+        for (int blockSize : { 64, 512 }) {
+            const auto name = "autoGain/" + juce::String(numChannels) + "ch/" + juce::String(blockSize);
+
+            if (! runner.shouldRun(name))
+                continue;
+
+            AutoGain autoGain;
+            autoGain.prepare(sampleRate, juce::AudioChannelSet::discreteChannels(numChannels));
+            GainAutomationQueue points;
+
+            juce::AudioBuffer<float> source(numChannels, blockSize);
+            fillWithTestSignal(source, sampleRate);
+
+            runner.run(name, numChannels * blockSize, [&] { points.clear(); },
+                       [&] { autoGain.process(source.getArrayOfReadPointers(), numChannels, blockSize, points); });
+        }
+    }
+
+    // The whole processor, with the gain stage following the detector's points
+    for (bool on : { false, true }) {
+        constexpr int blockSize = 512;
+        const auto name = juce::String("processBlock/stereo/512/auto-gain-") + (on ? "on" : "off");
+
+        if (! runner.shouldRun(name))
+            continue;
+
+        auto processor = createPreparedProcessor(2, sampleRate, blockSize);
+        processor->autoGainParam->store(on ? 1.0f : 0.0f);
+
+        juce::AudioBuffer<float> source(2, blockSize), buffer(2, blockSize);
+        juce::MidiBuffer midi;
+        fillWithTestSignal(source, sampleRate);
+        source.applyGain(0.1f);
+
+        runner.run(name, blockSize, [&] { buffer.makeCopyOf(source, true); },
+                   [&] { processor->processBlock(buffer, midi); });
+    }
+}
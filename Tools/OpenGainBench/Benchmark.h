@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    Benchmark.h
+    Timing harness and result format shared by the OpenGainBench cases.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "PluginProcessor.h"
+
+//==============================================================================
+struct BenchmarkResult
+{
+    juce::String name;
+    double nsPerCall = 0.0;
+    double nsPerSample = 0.0;   // zero for cases that don't process samples, e.g. paint
+};
+
+//==============================================================================
+/**
+    Runs and collects benchmark cases.
+
+    Each case is timed call by call, with an untimed prepare step before every call
+    (typically refilling the input buffer, so in-place processing always sees the
+    same signal). Calls are grouped into batches of about 2 ms and the median batch
+    average is reported, which keeps the odd preempted call from skewing a result.
+*/
+class BenchmarkRunner
+{
+public:
+    explicit BenchmarkRunner (const juce::String& nameFilter) : filter (nameFilter) {}
+
+    bool shouldRun (const juce::String& name) const
+    {
+        return filter.isEmpty() || name.contains (filter);
+    }
+
+    template <typename Prepare, typename Body>
+    void run (const juce::String& name, int samplesPerCall, Prepare&& prepare, Body&& body)
+    {
+        if (! shouldRun (name))
+            return;
+
+        auto timeCalls = [&] (int numCalls)
+        {
+            juce::int64 ticks = 0;
+
+            for (int i = 0; i < numCalls; ++i)
+            {
+                prepare();
+                const auto start = juce::Time::getHighResolutionTicks();
+                body();
+                ticks += juce::Time::getHighResolutionTicks() - start;
+            }
+
+            return juce::Time::highResolutionTicksToSeconds (ticks) * 1.0e9 / numCalls;
+        };
+
+        const auto warmUpNs = timeCalls (16);
+        const int callsPerBatch = juce::jlimit (1, 100000, (int) (batchNs / juce::jmax (1.0, warmUpNs)));
+
+        std::vector<double> batches;
+
+        for (int i = 0; i < numBatches; ++i)
+            batches.push_back (timeCalls (callsPerBatch));
+
+        std::sort (batches.begin(), batches.end());
+        const auto median = batches[batches.size() / 2];
+
+        addResult ({ name, median, samplesPerCall > 0 ? median / samplesPerCall : 0.0 });
+    }
+
+    /** Records a result the case timed itself, e.g. a percentile of single calls
+        rather than the median batch.
+    */
+    void addResult (const BenchmarkResult& result)
+    {
+        results.push_back (result);
+
+        std::cerr << result.name << ": " << juce::String (result.nsPerCall, 1) << " ns/call";
+
+        if (result.nsPerSample > 0.0)
+            std::cerr << ", " << juce::String (result.nsPerSample, 3) << " ns/sample";
+
+        std::cerr << std::endl;
+    }
+
+    /** Records a correctness problem found while setting up a case. */
+    void addFailure (const juce::String& message)
+    {
+        std::cerr << "FAILED: " << message << std::endl;
+        failures.add (message);
+    }
+
+    const std::vector<BenchmarkResult>& getResults() const noexcept   { return results; }
+    const juce::StringArray& getFailures() const noexcept               { return failures; }
+
+    //==============================================================================
+    juce::var toJSON() const;
+    static std::vector<BenchmarkResult> resultsFromJSON (const juce::var& json);
+
+    /** Prints each case against the baseline and returns the number that got slower
+        by more than thresholdPercent.
+    */
+    int compareWith (const std::vector<BenchmarkResult>& baseline, double thresholdPercent) const;
+
+private:
+    static constexpr double batchNs = 2.0e6;
+    static constexpr int numBatches = 11;
+
+    juce::String filter;
+    std::vector<BenchmarkResult> results;
+    juce::StringArray failures;
+};
+
+//==============================================================================
+/** Creates a processor with an in == out bus of numChannels, prepared for blockSize. */
+std::unique_ptr<GainAudioProcessor> createPreparedProcessor (int numChannels, double sampleRate, int blockSize);
+
+/** Fills every channel with a full-scale signal that never sits at zero. */
+void fillWithTestSignal (juce::AudioBuffer<float>& buffer, double sampleRate);
+
+void addKernelBenchmarks (BenchmarkRunner&);
+void addProcessorBenchmarks (BenchmarkRunner&);
+void addParallelBenchmarks (BenchmarkRunner&);
+void addStressBenchmarks (BenchmarkRunner&);
+void addDcBlockerBenchmarks (BenchmarkRunner&);
+void addDitherBenchmarks (BenchmarkRunner&);
+void addAutoGainBenchmarks (BenchmarkRunner&);
+void addSoftClipBenchmarks (BenchmarkRunner&);
+void addLimiterBenchmarks (BenchmarkRunner&);
+void addMeterBenchmarks (BenchmarkRunner&);
+void addEditorBenchmarks (BenchmarkRunner&);
+void addStateBenchmarks (BenchmarkRunner&);
@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    DcBlockerBenchmarks.cpp
+    DC blocker: agreement with a per-channel filter, and ns/sample by channel count.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+
+//==============================================================================
+// One plain biquad per channel, in the same form and precision as the DC blocker's
+// lanes: what it has to match, and what it's timed against
+struct ReferenceHighPass
+{
+    double b0, b1, a1, a2, z1 = 0.0, z2 = 0.0;
+
+    ReferenceHighPass (double cutoffHz, double sampleRate)
+    {
+        const auto omega = juce::MathConstants<double>::twoPi * cutoffHz / sampleRate;
+        const auto cosOmega = std::cos(omega);
+        const auto alpha = std::sin(omega) * juce::MathConstants<double>::sqrt2 * 0.5;
+        const auto a0 = 1.0 + alpha;
+
+        b0 = (1.0 + cosOmega) * 0.5 / a0;
+        b1 = -2.0 * b0;
+        a1 = -2.0 * cosOmega / a0;
+        a2 = (1.0 - alpha) / a0;
+    }
+
+    void process (float* data, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i) {
+            const double x = data[i];
+            const double y = x * b0 + z1;
+            z1 = x * b1 - y * a1 + z2;
+            z2 = x * b0 - y * a2;
+            data[i] = (float) y;
+        }
+    }
+};
+
+// A 997 Hz sine riding on a different DC offset in each channel
+static void fillWithOffsetSine (juce::AudioBuffer<float>& buffer, int startSample, double sampleRate)
+{
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel) {
+        auto* data = buffer.getWritePointer(channel);
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            data[i] = 0.5f * (float) std::sin(juce::MathConstants<double>::twoPi * 997.0 * (startSample + i) / sampleRate)
+                        + 0.1f * (float) (channel + 1);
+    }
+}
+
+//==============================================================================
+// An odd number of channels, so the last group of lanes is part empty, processed in
+// two calls the way the pool's tasks split them
+static void checkDcBlocker (BenchmarkRunner& runner)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr float cutoffHz = 10.0f;
+    constexpr int numChannels = 2 * DcBlocker::channelsPerGroup + 1, blockSize = 100, numBlocks = 960;
+
+    DcBlocker blocker;
+    blocker.prepare(sampleRate, numChannels);
+    blocker.setCutoff(cutoffHz);
+
+    std::vector<ReferenceHighPass> references(numChannels, ReferenceHighPass(cutoffHz, sampleRate));
+    juce::AudioBuffer<float> buffer(numChannels, blockSize), expected(numChannels, blockSize);
+    std::vector<double> lastSecondSums(numChannels, 0.0);
+    float largestError = 0.0f;
+
+    for (int block = 0; block < numBlocks; ++block) {
+        fillWithOffsetSine(buffer, block * blockSize, sampleRate);
+        expected.makeCopyOf(buffer, true);
+
+        blocker.process(buffer.getArrayOfWritePointers(), 0, DcBlocker::channelsPerGroup, blockSize);
+        blocker.process(buffer.getArrayOfWritePointers(), DcBlocker::channelsPerGroup, numChannels, blockSize);
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            references[(size_t) channel].process(expected.getWritePointer(channel), blockSize);
+
+            for (int i = 0; i < blockSize; ++i)
+                largestError = std::max(largestError, std::abs(buffer.getSample(channel, i) - expected.getSample(channel, i)));
+
+            // By the last second the offset is long gone. That second holds a whole
+            // number of the sine's cycles, so they average out to whatever DC is left.
+            if (block >= numBlocks - (int) sampleRate / blockSize)
+                for (int i = 0; i < blockSize; ++i)
+                    lastSecondSums[(size_t) channel] += buffer.getSample(channel, i);
+        }
+    }
+
+    if (largestError > 1.0e-6f)
+        runner.addFailure("DC blocker: differs from a filter per channel by " + juce::String(largestError, 8));
+
+    for (auto sum : lastSecondSums)
+        if (std::abs(sum / sampleRate) > 1.0e-3)
+            runner.addFailure("DC blocker: left an offset of " + juce::String(sum / sampleRate, 5));
+
+    // After a reset an impulse comes out as if nothing had gone before it, and its
+    // tail into silence is flushed to exactly zero rather than decaying forever
+    buffer.clear();
+    buffer.setSample(0, 0, 1.0f);
+    blocker.reset();
+    blocker.process(buffer.getArrayOfWritePointers(), 0, numChannels, blockSize);
+
+    bool wasReset = buffer.getSample(0, 0) == (float) references[0].b0;
+
+    for (int channel = 1; channel < numChannels; ++channel)
+        wasReset = wasReset && buffer.getMagnitude(channel, 0, blockSize) == 0.0f;
+
+    if (! wasReset)
+        runner.addFailure("DC blocker: reset() didn't empty the filter");
+
+    for (int block = 0; block < 1440; ++block) {
+        buffer.clear();
+        blocker.process(buffer.getArrayOfWritePointers(), 0, numChannels, blockSize);
+    }
+
+    if (buffer.getMagnitude(0, blockSize) != 0.0f)
+        runner.addFailure("DC blocker: an impulse's tail wasn't flushed to zero after three seconds");
+}
+
+//==============================================================================
+void addDcBlockerBenchmarks (BenchmarkRunner& runner)
+{
+    constexpr double sampleRate = 48000.0;
+
+    checkDcBlocker(runner);
+
+    // Every channel in SIMD lanes, against the same filter one channel at a time
+    for (int numChannels : { 2, 8, 64 }) {
+        for (int blockSize : { 64, 512 }) {
+            for (bool perChannel : { false, true }) {
+                const auto name = "dcBlocker/" + juce::String(numChannels) + "ch/" + juce::String(blockSize)
+                                + (perChannel ? "/per-channel" : "/simd");
+
+                if (! runner.shouldRun(name))
+                    continue;
+
+                DcBlocker blocker;
+                blocker.prepare(sampleRate, numChannels);
+                std::vector<ReferenceHighPass> references(numChannels, ReferenceHighPass(DcBlocker::defaultCutoffHz, sampleRate));
+
+                juce::AudioBuffer<float> source(numChannels, blockSize), buffer(numChannels, blockSize);
+                fillWithOffsetSine(source, 0, sampleRate);
+
+                runner.run(name, numChannels * blockSize, [&] { buffer.makeCopyOf(source, true); },
+                           [&] {
+                               if (! perChannel) {
+                                   blocker.process(buffer.getArrayOfWritePointers(), 0, numChannels, blockSize);
+                                   return;
+                               }
+
+                               for (int channel = 0; channel < numChannels; ++channel)
+                                   references[(size_t) channel].process(buffer.getWritePointer(channel), blockSize);
+                           });
+            }
+        }
+    }
+}
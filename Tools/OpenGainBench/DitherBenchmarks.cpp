@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+    DitherBenchmarks.cpp
+    Dither: the added noise's level and spectrum per shape, and its ns/sample.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+
+static const juce::String shapeNames[] { "flat", "first-order", "lipshitz", "wannamaker" };
+
+//==============================================================================
+// The noise the dither added, in LSBs: its power overall, and per bin of its spectrum
+struct NoiseSpectrum
+{
+    static constexpr int fftOrder = 12, fftSize = 1 << fftOrder;
+    static constexpr double sampleRate = 44100.0;
+
+    std::vector<double> power = std::vector<double>(fftSize / 2, 0.0);
+    double meanSquare = 0.0;
+
+    // The average power per bin over a band of frequencies, in dB
+
+    float getBandLevel (double lowHz, double highHz) const
+    {
+        double sum = 0.0;
+        int numBins = 0;
+
+        for (int bin = 1; bin < fftSize / 2; ++bin) {
+            const auto frequency = bin * sampleRate / fftSize;
+
+            if (frequency >= lowHz && frequency < highHz) {
+                sum += power[(size_t) bin];
+                ++numBins;
+            }
+        }
+
+        return (float) (10.0 * std::log10(sum / juce::jmax(1, numBins)));
+    }
+};
+
+//==============================================================================
+// A quiet 1 kHz sine through the dither at 16 bits, at 44.1 kHz, which the shapes are
+// designed for. Every sample has to land on the 16-bit grid, and the difference from
+// the input is the noise that gets measured.
+static NoiseSpectrum measureNoise (BenchmarkRunner& runner, Dither::Shape shape)
+{
+    constexpr double sampleRate = NoiseSpectrum::sampleRate, lsb = 1.0 / 32768.0;
+    constexpr int blockSize = 512, numFrames = 32;
+
+    Dither dither;
+    dither.prepare(blockSize, 1);
+    dither.setFormat(16, shape);
+
+    NoiseSpectrum spectrum;
+
+    juce::dsp::FFT fft(NoiseSpectrum::fftOrder);
+    juce::dsp::WindowingFunction<float> window(NoiseSpectrum::fftSize, juce::dsp::WindowingFunction<float>::hann, false);
+    std::vector<float> input(NoiseSpectrum::fftSize), output, noise(2 * NoiseSpectrum::fftSize);
+    bool onGrid = true;
+    int position = 0;
+
+    for (int frame = 0; frame < numFrames; ++frame) {
+        for (auto& sample : input)
+            sample = 0.01f * (float) std::sin(juce::MathConstants<double>::twoPi * 1000.0 * position++ / sampleRate);
+
+        output = input;
+
+        for (int start = 0; start < NoiseSpectrum::fftSize; start += blockSize) {
+            auto* block = output.data() + start;
+            dither.process(&block, 1, blockSize);
+        }
+
+        for (int i = 0; i < NoiseSpectrum::fftSize; ++i) {
+            const auto inLsbs = output[(size_t) i] / lsb;
+            onGrid = onGrid && inLsbs == std::round(inLsbs);
+            noise[(size_t) i] = (float) ((output[(size_t) i] - input[(size_t) i]) / lsb);
+            spectrum.meanSquare += (double) noise[(size_t) i] * noise[(size_t) i] / (numFrames * NoiseSpectrum::fftSize);
+        }
+
+        window.multiplyWithWindowingTable(noise.data(), (size_t) NoiseSpectrum::fftSize);
+        fft.performFrequencyOnlyForwardTransform(noise.data());
+
+        for (int bin = 0; bin < NoiseSpectrum::fftSize / 2; ++bin)
+            spectrum.power[(size_t) bin] += (double) noise[(size_t) bin] * noise[(size_t) bin] / numFrames;
+    }
+
+    if (! onGrid)
+        runner.addFailure("Dither " + shapeNames[(int) shape] + ": output isn't on the 16-bit grid");
+
+    return spectrum;
+}
+
+static void checkDither (BenchmarkRunner& runner)
+{
+    const auto flat = measureNoise(runner, Dither::Shape::flat);
+    const auto firstOrder = measureNoise(runner, Dither::Shape::firstOrder);
+    const auto lipshitz = measureNoise(runner, Dither::Shape::lipshitz);
+    const auto wannamaker = measureNoise(runner, Dither::Shape::wannamaker);
+
+    // Rounding adds 1/12 LSB squared and TPDF dither 1/6, whatever the signal
+    if (std::abs(flat.meanSquare - 0.25) > 0.0125)
+        runner.addFailure("Dither flat: adds " + juce::String(flat.meanSquare, 3) + " LSB squared of noise rather than 1/4");
+
+    // TPDF noise is white: the same level low and high
+    const auto flatLow = flat.getBandLevel(100.0, 4000.0), flatHigh = flat.getBandLevel(16000.0, 20000.0);
+
+    if (std::abs(flatLow - flatHigh) > 1.0f)
+        runner.addFailure("Dither flat: isn't white, " + juce::String(flatLow - flatHigh, 1) + " dB from low to high");
+
+    // First order rises 6 dB an octave, so the top band is well above the bottom one
+    if (firstOrder.getBandLevel(16000.0, 20000.0) - firstOrder.getBandLevel(100.0, 4000.0) < 12.0f)
+        runner.addFailure("Dither first-order: doesn't push the noise up in frequency");
+
+    // The shaped curves dig the noise out of 2-5 kHz, where hearing is most sensitive,
+    // and put it above 16 kHz instead
+    for (const auto* shaped : { &lipshitz, &wannamaker }) {
+        const auto name = shaped == &lipshitz ? shapeNames[2] : shapeNames[3];
+
+        if (shaped->getBandLevel(2000.0, 5000.0) > flat.getBandLevel(2000.0, 5000.0) - 15.0f)
+            runner.addFailure("Dither " + name + ": less than 15 dB quieter than flat from 2 to 5 kHz");
+
+        if (shaped->getBandLevel(16000.0, 20000.0) < flatHigh + 10.0f)
+            runner.addFailure("Dither " + name + ": doesn't move the noise above 16 kHz");
+    }
+}
+
+//==============================================================================
+void addDitherBenchmarks (BenchmarkRunner& runner)
+{
+    constexpr double sampleRate = 48000.0;
+
+    checkDither(runner);
+
+    // What the dither adds to every sample, by shape
+    for (int blockSize : { 64, 512 }) {
+        for (int shape = 0; shape < 4; ++shape) {
+            const auto name = "dither/stereo/" + juce::String(blockSize) + "/" + shapeNames[shape];
+
+            if (! runner.shouldRun(name))
+                continue;
+
+            Dither dither;
+            dither.prepare(blockSize, 2);
+            dither.setFormat(16, (Dither::Shape) shape);
+
+            juce::AudioBuffer<float> source(2, blockSize), buffer(2, blockSize);
+            fillWithTestSignal(source, sampleRate);
+            source.applyGain(0.5f);
+
+            runner.run(name, 2 * blockSize, [&] { buffer.makeCopyOf(source, true); },
+                       [&] { dither.process(buffer.getArrayOfWritePointers(), 2, blockSize); });
+        }
+    }
+}
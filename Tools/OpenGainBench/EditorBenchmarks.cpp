@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    EditorBenchmarks.cpp
+    GainAudioProcessorEditor paint and meter refresh, rendered offscreen.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+#include "PluginEditor.h"
+
+//==============================================================================
+void addEditorBenchmarks (BenchmarkRunner& runner)
+{
+    for (bool clipping : { false, true }) {
+        const auto name = juce::String("editor/paint/") + (clipping ? "clip-led-on" : "clip-led-off");
+
+        if (! runner.shouldRun(name))
+            continue;
+
+        auto processor = createPreparedProcessor(2, 48000.0, 512);
+        GainAudioProcessorEditor editor(*processor);
+
+        MeterFrame frame;
+        frame.peak = clipping ? 1.4f : 0.5f;
+        frame.truePeak = frame.peak;
+        frame.numClippedSamples = clipping ? 3 : 0;
+        frame.numSamples = 512;
+        const float channelPeaks[] { frame.peak, frame.peak };
+        const int channelClippedSamples[] { frame.numClippedSamples, 0 };
+        processor->meterTelemetry.publish(frame, channelPeaks, channelClippedSamples, 2);
+        processor->collectFromAudioThread();
+        editor.refreshMeters();
+
+        juce::Image image(juce::Image::ARGB, editor.getWidth(), editor.getHeight(), true);
+
+        runner.run(name, 0, [] {},
+                   [&] {
+                       juce::Graphics g(image);
+                       editor.paintEntireComponent(g, true);
+                   });
+    }
+
+    // What an open editor costs per timer tick while nothing is playing
+    if (runner.shouldRun("editor/refreshMeters/idle")) {
+        auto processor = createPreparedProcessor(2, 48000.0, 512);
+        GainAudioProcessorEditor editor(*processor);
+
+        runner.run("editor/refreshMeters/idle", 0, [] {},
+                   [&] { juce::ignoreUnused(editor.refreshMeters()); });
+    }
+}
@@ -0,0 +1,297 @@
+/*
+  ==============================================================================
+
+    KernelBenchmarks.cpp
+    Per-ISA gain, mid/side, silence and soft-clip kernels: agreement with scalar and ns/sample by block size.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+
+static constexpr GainKernelISA allISAs[] { GainKernelISA::scalar, GainKernelISA::sse2, GainKernelISA::avx2,
+                                           GainKernelISA::avx512, GainKernelISA::neon };
+
+template <typename SampleType>
+static juce::String getKernelName (GainKernelISA isa)
+{
+    return juce::String(GainKernelSupport::getISAName(isa)) + (std::is_same_v<SampleType, double> ? "-double" : "");
+}
+
+//==============================================================================
+template <typename SampleType>
+static void checkBitExact (BenchmarkRunner& runner, GainKernelISA isa)
+{
+    using Kernels = GainKernels<SampleType>;
+    const auto& scalar = Kernels::forISA(GainKernelISA::scalar);
+    const auto& kernels = Kernels::forISA(isa);
+    juce::Random random(0x0a1e);
+
+    // Every length up to a few vectors, so each tail length gets covered, plus some
+    // samples that don't survive a careless abs/max: -0, NaN and denormals
+    for (int numSamples = 0; numSamples <= 80; ++numSamples) {
+        std::vector<SampleType> input((size_t) numSamples);
+
+        for (auto& sample : input)
+            sample = (SampleType) (random.nextDouble() * 4.0 - 2.0);
+
+        if (numSamples > 3) {
+            input[0] = (SampleType) -0.0;
+            input[1] = std::numeric_limits<SampleType>::quiet_NaN();
+            input[2] = std::numeric_limits<SampleType>::denorm_min();
+        }
+
+        // Samples, peak and clip count must match exactly; the sum of squares is
+        // added up in a different order, so it only has to agree to rounding
+        auto statsMatch = [] (const SampleStats& expectedStats, const SampleStats& actualStats) {
+            const auto sumTolerance = 1.0e-5f * (std::abs(expectedStats.sumOfSquares) + 1.0f);
+            const bool sumsMatch = std::isnan(expectedStats.sumOfSquares) ? std::isnan(actualStats.sumOfSquares)
+                                                                         : std::abs(expectedStats.sumOfSquares - actualStats.sumOfSquares) <= sumTolerance;
+
+            return expectedStats.peak == actualStats.peak && expectedStats.numClipped == actualStats.numClipped && sumsMatch;
+        };
+
+        auto compare = [&] (const char* kernelName, auto&& process) {
+            auto expected = input, actual = input;
+            const auto expectedStats = process(scalar, expected.data());
+            const auto actualStats = process(kernels, actual.data());
+
+            if (! statsMatch(expectedStats, actualStats)
+                 || std::memcmp(expected.data(), actual.data(), input.size() * sizeof(SampleType)) != 0)
+                runner.addFailure(getKernelName<SampleType>(isa) + " " + kernelName
+                                  + " doesn't match scalar at " + juce::String(numSamples) + " samples");
+        };
+
+        compare("applyGain", [&] (const Kernels& k, SampleType* data) { return k.applyGain(data, numSamples, (SampleType) 0.7079458); });
+        compare("applyGainRamp", [&] (const Kernels& k, SampleType* data) { return k.applyGainRamp(data, numSamples, (SampleType) 0.5, (SampleType) 0.0123); });
+        compare("measure", [&] (const Kernels& k, SampleType* data) { return k.measure(data, numSamples); });
+
+        // Mid/side takes a pair: the input as the left channel and reversed as the right,
+        // so the odd samples meet ordinary ones on the other side. Fixed and ramping.
+        for (bool ramping : { false, true }) {
+            const std::vector<SampleType> right(input.rbegin(), input.rend());
+            auto expectedLeft = input, expectedRight = right, actualLeft = input, actualRight = right;
+            SampleStats expectedStats[2], actualStats[2];
+
+            auto process = [&] (const Kernels& k, SampleType* l, SampleType* r, SampleStats* stats) {
+                k.applyMidSide(l, r, numSamples, (SampleType) 0.9, (SampleType) (ramping ? 0.0071 : 0.0),
+                               (SampleType) -0.3, (SampleType) (ramping ? -0.0043 : 0.0), stats[0], stats[1]);
+            };
+
+            process(scalar, expectedLeft.data(), expectedRight.data(), expectedStats);
+            process(kernels, actualLeft.data(), actualRight.data(), actualStats);
+
+            if (! statsMatch(expectedStats[0], actualStats[0]) || ! statsMatch(expectedStats[1], actualStats[1])
+                 || std::memcmp(expectedLeft.data(), actualLeft.data(), input.size() * sizeof(SampleType)) != 0
+                 || std::memcmp(expectedRight.data(), actualRight.data(), input.size() * sizeof(SampleType)) != 0)
+                runner.addFailure(getKernelName<SampleType>(isa) + " applyMidSide" + (ramping ? " ramping" : "")
+                                  + " doesn't match scalar at " + juce::String(numSamples) + " samples");
+        }
+
+        // The soft clipper's curve, on samples either side of the knee and past where it
+        // flattens out. NaNs only have to stay NaNs.
+        for (auto knee : { (SampleType) 0.5, (SampleType) 0.8 }) {
+            auto expected = input, actual = input;
+            scalar.softClip(expected.data(), numSamples, knee);
+            kernels.softClip(actual.data(), numSamples, knee);
+
+            for (int i = 0; i < numSamples; ++i) {
+                if (! (std::isnan(expected[(size_t) i]) && std::isnan(actual[(size_t) i]))
+                      && std::memcmp(&expected[(size_t) i], &actual[(size_t) i], sizeof(SampleType)) != 0) {
+                    runner.addFailure(getKernelName<SampleType>(isa) + " softClip doesn't match scalar at "
+                                      + juce::String(numSamples) + " samples");
+                    break;
+                }
+            }
+        }
+
+        // The silence check has to spot a loud sample, or a NaN, wherever it is
+        const auto threshold = (SampleType) 1.0e-6;
+
+        for (int loudIndex = -1; loudIndex < numSamples; ++loudIndex) {
+            for (auto loud : { (SampleType) 2.0e-6, (SampleType) -1, std::numeric_limits<SampleType>::quiet_NaN() }) {
+                std::vector<SampleType> quiet((size_t) numSamples, (SampleType) -1.0e-7);
+
+                if (loudIndex >= 0)
+                    quiet[(size_t) loudIndex] = loud;
+
+                if (scalar.isSilent(quiet.data(), numSamples, threshold) != kernels.isSilent(quiet.data(), numSamples, threshold))
+                    runner.addFailure(getKernelName<SampleType>(isa) + " isSilent doesn't match scalar at "
+                                      + juce::String(numSamples) + " samples");
+            }
+        }
+    }
+}
+
+// The cross-channel kernel against the scalar one, and against the per-channel
+// kernels it stands in for, over channel counts either side of its vector width
+template <typename SampleType>
+static void checkAcrossChannels (BenchmarkRunner& runner, GainKernelISA isa)
+{
+    using Kernels = GainKernels<SampleType>;
+    const auto& scalar = Kernels::forISA(GainKernelISA::scalar);
+    const auto& kernels = Kernels::forISA(isa);
+    juce::Random random(0x0c4a);
+
+    for (int numChannels = 1; numChannels <= 13; ++numChannels) {
+        for (int numSamples = 0; numSamples <= 24; ++numSamples) {
+            for (bool ramping : { false, true }) {
+                const int startSample = numSamples % 3;
+                juce::AudioBuffer<SampleType> input(numChannels, startSample + numSamples);
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    for (int i = 0; i < input.getNumSamples(); ++i)
+                        input.setSample(channel, i, (SampleType) (random.nextDouble() * 4.0 - 2.0));
+
+                if (numSamples > 0)
+                    input.setSample(numChannels - 1, startSample, std::numeric_limits<SampleType>::quiet_NaN());
+
+                const auto start = (SampleType) (ramping ? 0.5 : 0.7079458);
+                const auto increment = (SampleType) (ramping ? 0.0123 : 0.0);
+
+                // Both start from non-zero stats, as they would after an earlier segment
+                auto process = [&] (auto&& apply) {
+                    juce::AudioBuffer<SampleType> buffer;
+                    buffer.makeCopyOf(input);
+                    ChannelStats stats;
+                    stats.peaks.fill(0.25f);
+                    stats.numClipped.fill(2);
+                    apply(buffer, stats);
+                    return std::make_pair(std::move(buffer), stats);
+                };
+
+                const auto expected = process([&] (auto& buffer, auto& stats) {
+                    for (int channel = 0; channel < numChannels; ++channel) {
+                        auto* data = buffer.getWritePointer(channel) + startSample;
+                        stats.add(channel, ramping ? scalar.applyGainRamp(data, numSamples, start, increment)
+                                                   : scalar.applyGain(data, numSamples, start));
+                    }
+                });
+
+                auto compare = [&] (const char* kernelName, const Kernels& k) {
+                    const auto actual = process([&] (auto& buffer, auto& stats) {
+                        k.applyGainAcrossChannels(buffer.getArrayOfWritePointers(), numChannels, startSample, numSamples,
+                                                  start, increment, stats);
+                    });
+
+                    bool matches = true;
+
+                    for (int channel = 0; channel < numChannels; ++channel)
+                        matches = matches && expected.second.peaks[(size_t) channel] == actual.second.peaks[(size_t) channel]
+                                          && expected.second.numClipped[(size_t) channel] == actual.second.numClipped[(size_t) channel]
+                                          && std::memcmp(expected.first.getReadPointer(channel), actual.first.getReadPointer(channel),
+                                                         (size_t) input.getNumSamples() * sizeof(SampleType)) == 0;
+
+                    if (! matches)
+                        runner.addFailure(getKernelName<SampleType>(isa) + " " + kernelName + " doesn't match the per-channel kernels at "
+                                          + juce::String(numChannels) + " channels x " + juce::String(numSamples) + " samples");
+                };
+
+                compare("scalar applyGainAcrossChannels", scalar);
+                compare("applyGainAcrossChannels", kernels);
+            }
+        }
+    }
+}
+
+template <typename SampleType>
+static void addKernelBenchmarksFor (BenchmarkRunner& runner, GainKernelISA isa)
+{
+    if (isa != GainKernelISA::scalar)
+        checkBitExact<SampleType>(runner, isa);
+
+    checkAcrossChannels<SampleType>(runner, isa);
+
+    const auto& kernels = GainKernels<SampleType>::forISA(isa);
+    const juce::String prefix = "kernel/" + getKernelName<SampleType>(isa) + "/";
+
+    for (int blockSize = 16; blockSize <= 8192; blockSize *= 2) {
+        juce::AudioBuffer<float> signal(1, blockSize);
+        fillWithTestSignal(signal, 48000.0);
+
+        juce::AudioBuffer<SampleType> source, work(1, blockSize);
+        source.makeCopyOf(signal);
+        auto refill = [&] { work.copyFrom(0, 0, source, 0, 0, blockSize); };
+        auto* data = work.getWritePointer(0);
+
+        runner.run(prefix + "applyGain/" + juce::String(blockSize), blockSize, refill,
+                   [&] { juce::ignoreUnused(kernels.applyGain(data, blockSize, (SampleType) 0.5)); });
+
+        runner.run(prefix + "applyGainRamp/" + juce::String(blockSize), blockSize, refill,
+                   [&] { juce::ignoreUnused(kernels.applyGainRamp(data, blockSize, (SampleType) 0.5, (SampleType) 1.0e-5)); });
+
+        runner.run(prefix + "softClip/" + juce::String(blockSize), blockSize, refill,
+                   [&] { kernels.softClip(data, blockSize, (SampleType) 0.5); });
+
+        runner.run(prefix + "measure/" + juce::String(blockSize), blockSize, [] {},
+                   [&] { juce::ignoreUnused(kernels.measure(data, blockSize)); });
+
+        // A stereo pair with mid/side gain, in its one fused pass, against the plain gain
+        // on both channels, which is what linked mode costs
+        juce::AudioBuffer<float> stereoSignal(2, blockSize);
+        fillWithTestSignal(stereoSignal, 48000.0);
+
+        juce::AudioBuffer<SampleType> stereoSource, stereo(2, blockSize);
+        stereoSource.makeCopyOf(stereoSignal);
+        auto refillStereo = [&] { stereo.makeCopyOf(stereoSource, true); };
+
+        runner.run(prefix + "applyGainStereo/" + juce::String(blockSize), 2 * blockSize, refillStereo,
+                   [&] {
+                       juce::ignoreUnused(kernels.applyGain(stereo.getWritePointer(0), blockSize, (SampleType) 0.5));
+                       juce::ignoreUnused(kernels.applyGain(stereo.getWritePointer(1), blockSize, (SampleType) 0.5));
+                   });
+
+        runner.run(prefix + "applyMidSide/" + juce::String(blockSize), 2 * blockSize, refillStereo,
+                   [&] {
+                       SampleStats leftStats, rightStats;
+                       kernels.applyMidSide(stereo.getWritePointer(0), stereo.getWritePointer(1), blockSize,
+                                            (SampleType) 0.6, (SampleType) 0, (SampleType) -0.1, (SampleType) 0, leftStats, rightStats);
+                   });
+
+        // Worst case for the silence check: every sample is quiet, so it reads them all
+        std::vector<SampleType> quiet((size_t) blockSize, (SampleType) 1.0e-7);
+
+        runner.run(prefix + "isSilent/" + juce::String(blockSize), blockSize, [] {},
+                   [&] { juce::ignoreUnused(kernels.isSilent(quiet.data(), blockSize, (SampleType) 1.0e-6)); });
+    }
+
+    // Short blocks on wide buses: one call across the channels against one per channel
+    for (int numChannels : { 8, 64 }) {
+        for (int blockSize : { 4, 16, 64 }) {
+            juce::AudioBuffer<float> signal(numChannels, blockSize);
+            fillWithTestSignal(signal, 48000.0);
+
+            juce::AudioBuffer<SampleType> source, work(numChannels, blockSize);
+            source.makeCopyOf(signal);
+            auto refill = [&] { work.makeCopyOf(source, true); };
+            const auto size = juce::String(numChannels) + "x" + juce::String(blockSize);
+
+            runner.run(prefix + "applyGainAcrossChannels/" + size, numChannels * blockSize, refill,
+                       [&] {
+                           ChannelStats stats;
+                           kernels.applyGainAcrossChannels(work.getArrayOfWritePointers(), numChannels, 0, blockSize,
+                                                           (SampleType) 0.5, (SampleType) 0, stats);
+                       });
+
+            runner.run(prefix + "applyGainPerChannel/" + size, numChannels * blockSize, refill,
+                       [&] {
+                           ChannelStats stats;
+
+                           for (int channel = 0; channel < numChannels; ++channel)
+                               stats.add(channel, kernels.applyGain(work.getWritePointer(channel), blockSize, (SampleType) 0.5));
+                       });
+        }
+    }
+}
+
+//==============================================================================
+void addKernelBenchmarks (BenchmarkRunner& runner)
+{
+    for (auto isa : allISAs) {
+        if (! GainKernelSupport::isAvailable(isa))
+            continue;
+
+        addKernelBenchmarksFor<float>(runner, isa);
+        addKernelBenchmarksFor<double>(runner, isa);
+    }
+}
@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+
+    LimiterBenchmarks.cpp
+    Lookahead limiter: ceiling, latency, lookahead changes and ns/sample across lookahead lengths.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+
+//==============================================================================
+// Noise bursts well over full scale, with a single spike far above them, on top of
+// a quiet stretch the limiter should leave alone
+static void fillWithLoudSignal (juce::AudioBuffer<float>& buffer, int startSample, juce::Random& random)
+{
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel) {
+        auto* data = buffer.getWritePointer(channel);
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i) {
+            const bool burst = ((startSample + i) / 2400) % 2 == 1;
+            data[i] = (random.nextFloat() * 2.0f - 1.0f) * (burst ? 4.0f : 0.25f);
+        }
+    }
+}
+
+static void checkLimiter (BenchmarkRunner& runner, float lookaheadMs)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 100;
+    const auto caseName = "Limiter at " + juce::String(lookaheadMs) + " ms lookahead";
+
+    LookaheadLimiter limiter;
+    limiter.prepare(sampleRate, blockSize, 2);
+    limiter.setLookahead(lookaheadMs);
+    limiter.setRelease(50.0f);
+    const int latency = limiter.getLatencySamples();
+
+    // Below the ceiling the gain stays at exactly one, so an impulse comes out whole
+    // and exactly latency samples later
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    std::vector<float> output;
+
+    for (int block = 0; block < 20; ++block) {
+        buffer.clear();
+
+        if (block == 0)
+            buffer.setSample(0, 3, 0.5f);
+
+        limiter.process(buffer.getArrayOfWritePointers(), 2, blockSize);
+        output.insert(output.end(), buffer.getReadPointer(0), buffer.getReadPointer(0) + blockSize);
+    }
+
+    const auto impulse = std::find_if(output.begin(), output.end(), [] (float x) { return x != 0.0f; });
+
+    if (impulse == output.end() || impulse - output.begin() != 3 + latency || *impulse != 0.5f)
+        runner.addFailure(caseName + ": an impulse under the ceiling isn't passed through unchanged after "
+                          + juce::String(latency) + " samples");
+
+    // Nothing over the ceiling gets out, whatever goes in
+    juce::Random random(1);
+    float loudest = 0.0f;
+
+    for (int block = 0; block < 960; ++block) {
+        fillWithLoudSignal(buffer, block * blockSize, random);
+
+        if (block == 500)
+            buffer.setSample(1, 50, 100.0f);
+
+        limiter.process(buffer.getArrayOfWritePointers(), 2, blockSize);
+        loudest = std::max(loudest, buffer.getMagnitude(0, blockSize));
+    }
+
+    if (loudest > LookaheadLimiter::ceiling)
+        runner.addFailure(caseName + ": output reached " + juce::String(loudest, 7) + ", over the ceiling");
+}
+
+// Moving the lookahead while a sine under the ceiling plays mustn't clear the delay:
+// every sample after a change is the input from the new latency ago, with none of
+// them silenced
+static void checkLookaheadChanges (BenchmarkRunner& runner)
+{
+    constexpr int blockSize = 256;
+
+    LookaheadLimiter limiter;
+    limiter.prepare(48000.0, blockSize, 1);
+    limiter.setRelease(50.0f);
+
+    juce::AudioBuffer<float> buffer(1, blockSize);
+    std::vector<float> input;
+    int numWrong = 0;
+
+    for (int block = 0; block < 60; ++block) {
+        constexpr float lookaheads[] { 5.0f, 2.0f, 10.0f, 1.0f, 7.5f, 5.0f };
+        limiter.setLookahead(lookaheads[block / 10]);
+        const int latency = limiter.getLatencySamples();
+
+        for (int i = 0; i < blockSize; ++i) {
+            input.push_back(0.5f * (float) std::sin(0.01 * (double) input.size()));
+            buffer.setSample(0, i, input.back());
+        }
+
+        limiter.process(buffer.getArrayOfWritePointers(), 1, blockSize);
+
+        for (int i = 0; i < blockSize; ++i) {
+            const auto position = (int) input.size() - blockSize + i;
+
+            if (position >= LookaheadLimiter::maxLookaheadMs * 48 && buffer.getSample(0, i) != input[(size_t) (position - latency)])
+                ++numWrong;
+        }
+    }
+
+    if (numWrong > 0)
+        runner.addFailure("Limiter: " + juce::String(numWrong) + " samples under the ceiling came out changed around lookahead changes");
+}
+
+//==============================================================================
+void addLimiterBenchmarks (BenchmarkRunner& runner)
+{
+    constexpr double sampleRate = 48000.0;
+
+    for (float lookaheadMs : { 1.0f, 5.0f, 10.0f })
+        checkLimiter(runner, lookaheadMs);
+
+    checkLookaheadChanges(runner);
+
+    // The sliding minimum should make these all cost the same per sample
+    for (int blockSize : { 64, 512 }) {
+        for (float lookaheadMs : { 1.0f, 2.0f, 5.0f, 10.0f }) {
+            const auto name = "limiter/stereo/" + juce::String(blockSize) + "/" + juce::String((int) lookaheadMs) + "ms-lookahead";
+
+            if (! runner.shouldRun(name))
+                continue;
+
+            LookaheadLimiter limiter;
+            limiter.prepare(sampleRate, blockSize, 2);
+            limiter.setLookahead(lookaheadMs);
+
+            // A second of signal to cycle through, so the limiter keeps working on
+            // bursts rather than settling on one block
+            juce::Random random(2);
+            juce::AudioBuffer<float> source(2, (int) sampleRate), buffer(2, blockSize);
+            fillWithLoudSignal(source, 0, random);
+            int position = 0;
+
+            runner.run(name, blockSize,
+                       [&] {
+                           position = (position + blockSize) % (source.getNumSamples() - blockSize);
+
+                           for (int channel = 0; channel < 2; ++channel)
+                               buffer.copyFrom(channel, 0, source, channel, position, blockSize);
+                       },
+                       [&] { limiter.process(buffer.getArrayOfWritePointers(), 2, blockSize); });
+        }
+    }
+}
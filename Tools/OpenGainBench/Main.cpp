@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    OpenGainBench: microbenchmarks for the processing, metering and paint paths.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+
+//==============================================================================
+juce::var BenchmarkRunner::toJSON() const
+{
+    juce::Array<juce::var> cases;
+
+    for (auto& result : results) {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("name", result.name);
+        entry->setProperty("nsPerCall", result.nsPerCall);
+        entry->setProperty("nsPerSample", result.nsPerSample);
+        cases.add(juce::var(entry));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("version", 1);
+    root->setProperty("kernels", GainKernelSupport::getISAName(GainKernelSupport::getBestAvailableISA()));
+    root->setProperty("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty("results", cases);
+    root->setProperty("failures", juce::var(failures));
+    return juce::var(root);
+}
+
+std::vector<BenchmarkResult> BenchmarkRunner::resultsFromJSON (const juce::var& json)
+{
+    std::vector<BenchmarkResult> loaded;
+
+    if (auto* cases = json["results"].getArray())
+        for (auto& entry : *cases)
+            loaded.push_back({ entry["name"].toString(), (double) entry["nsPerCall"], (double) entry["nsPerSample"] });
+
+    return loaded;
+}
+
+int BenchmarkRunner::compareWith (const std::vector<BenchmarkResult>& baseline, double thresholdPercent) const
+{
+    int numRegressions = 0;
+
+    for (auto& result : results) {
+        auto match = std::find_if(baseline.begin(), baseline.end(),
+                                  [&] (const BenchmarkResult& b) { return b.name == result.name; });
+
+        if (match == baseline.end() || match->nsPerCall <= 0.0) {
+            std::cerr << "  new        " << result.name << std::endl;
+            continue;
+        }
+
+        const auto changePercent = (result.nsPerCall / match->nsPerCall - 1.0) * 100.0;
+        const bool regressed = changePercent > thresholdPercent;
+        numRegressions += regressed ? 1 : 0;
+
+        std::cerr << (regressed ? "  REGRESSED " : "  ok        ")
+                  << result.name << ": " << juce::String(match->nsPerCall, 1) << " -> "
+                  << juce::String(result.nsPerCall, 1) << " ns/call ("
+                  << (changePercent >= 0.0 ? "+" : "") << juce::String(changePercent, 1) << "%)" << std::endl;
+    }
+
+    return numRegressions;
+}
+
+//==============================================================================
+static int runBenchmarks (const juce::ArgumentList& args)
+{
+    BenchmarkRunner runner(args.getValueForOption("--filter"));
+
+    addKernelBenchmarks(runner);
+    addProcessorBenchmarks(runner);
+    addParallelBenchmarks(runner);
+    addStressBenchmarks(runner);
+    addDcBlockerBenchmarks(runner);
+    addDitherBenchmarks(runner);
+    addAutoGainBenchmarks(runner);
+    addSoftClipBenchmarks(runner);
+    addLimiterBenchmarks(runner);
+    addMeterBenchmarks(runner);
+    addEditorBenchmarks(runner);
+    addStateBenchmarks(runner);
+
+    const auto json = juce::JSON::toString(runner.toJSON());
+
+    if (args.containsOption("--output|-o"))
+        args.getFileForOption("--output|-o").replaceWithText(json);
+    else
+        std::cout << json << std::endl;
+
+    int exitCode = runner.getFailures().isEmpty() ? 0 : 1;
+
+    if (args.containsOption("--compare")) {
+        const auto baselineFile = args.getExistingFileForOption("--compare");
+        const auto baseline = BenchmarkRunner::resultsFromJSON(juce::JSON::parse(baselineFile));
+        const double threshold = args.containsOption("--threshold") ? args.getValueForOption("--threshold").getDoubleValue() : 10.0;
+
+        std::cerr << std::endl << "Compared with " << baselineFile.getFileName()
+                  << " (threshold " << juce::String(threshold, 1) << "%):" << std::endl;
+
+        const int numRegressions = runner.compareWith(baseline, threshold);
+
+        if (numRegressions > 0) {
+            std::cerr << numRegressions << " case(s) regressed" << std::endl;
+            exitCode = 1;
+        }
+    }
+
+    return exitCode;
+}
+
+int main (int argc, char* argv[])
+{
+    // The editor and the processor's parameter state both need a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ConsoleApplication app;
+    app.addHelpCommand("--help|-h", "Usage:", false);
+    app.addDefaultCommand({ "",
+                            "[--filter <text>] [--output <file.json>] [--compare <baseline.json>] [--threshold <percent>]",
+                            "Runs the benchmarks and writes the results as JSON.",
+                            "--filter only runs cases whose name contains the text. With --compare, every case that is "
+                            "slower than the baseline by more than the threshold (default 10%) is flagged and the exit "
+                            "code is non-zero.",
+                            [] (const juce::ArgumentList& args) {
+                                if (const int exitCode = runBenchmarks(args))
+                                    juce::ConsoleApplication::fail({}, exitCode);
+                            } });
+
+    return app.run(argc, argv);
+}
@@ -0,0 +1,195 @@
+/*
+  ==============================================================================
+
+    MeterBenchmarks.cpp
+    True-peak detection accuracy and speed, offline loudness, and level history fills and reads.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+
+//==============================================================================
+static void checkTruePeakAccuracy (BenchmarkRunner& runner)
+{
+    // The EBU Tech 3341 true-peak sines (cases 15-18), at full scale rather than
+    // -6 dBFS so that their sample peaks clear the detection threshold. A meter has
+    // to read them within +0.2 / -0.4 dB of 0 dBTP.
+    struct Case { double frequency, phaseDegrees; };
+    constexpr Case cases[] { { 12000.0, 45.0 }, { 12000.0, 60.0 }, { 8000.0, 60.0 }, { 6000.0, 67.5 } };
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 480;
+
+    for (auto c : cases) {
+        TruePeakDetector detector;
+        detector.prepare(blockSize);
+
+        juce::AudioBuffer<float> buffer(1, blockSize);
+        float truePeak = 0.0f;
+        int position = 0;
+
+        for (int block = 0; block < 50; ++block) {
+            auto* data = buffer.getWritePointer(0);
+            float samplePeak = 0.0f;
+
+            for (int i = 0; i < blockSize; ++i, ++position) {
+                data[i] = (float) std::sin(juce::MathConstants<double>::twoPi * c.frequency * position / sampleRate
+                                           + juce::degreesToRadians(c.phaseDegrees));
+                samplePeak = std::max(samplePeak, std::abs(data[i]));
+            }
+
+            const auto blockPeak = detector.process(buffer, 1, samplePeak);
+
+            // The first block includes the filter filling up from silence
+            if (block > 0)
+                truePeak = std::max(truePeak, blockPeak);
+        }
+
+        // Compared at the 0.1 dB resolution a meter displays
+        const auto reading = std::round(juce::Decibels::gainToDecibels(truePeak) * 10.0f) / 10.0f;
+
+        if (reading > 0.2f || reading < -0.4f)
+            runner.addFailure("True peak of a " + juce::String(c.frequency / 1000.0) + " kHz sine at "
+                              + juce::String(c.phaseDegrees) + " degrees reads " + juce::String(reading, 1)
+                              + " dBTP, expected 0.0 +0.2/-0.4");
+    }
+}
+
+// A minute of a stereo 1 kHz sine at -20 dBFS, which reads -20 LUFS, measured as fast
+// as it can go. That's far more hops than the queue holds before the analysis thread
+// next looks at it, so rendering offline has to wait for the analysis rather than
+// lose any of them.
+static void checkOfflineLoudness (BenchmarkRunner& runner)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 4096, numSamples = 60 * 48000;
+
+    LoudnessMeter meter;
+    meter.prepare(sampleRate, juce::AudioChannelSet::stereo());
+    meter.setNonRealtime(true);
+
+    juce::AudioBuffer<float> buffer(2, blockSize);
+
+    for (int position = 0; position < numSamples; position += blockSize) {
+        const int thisBlock = std::min(blockSize, numSamples - position);
+        buffer.setSize(2, thisBlock, false, false, true);
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < thisBlock; ++i)
+                buffer.setSample(channel, i, 0.1f * (float) std::sin(juce::MathConstants<double>::twoPi * 1000.0 * (position + i) / sampleRate));
+
+        meter.process(buffer, 2);
+    }
+
+    meter.flush();
+    const auto integrated = meter.getReadings().integrated;
+
+    if (meter.getNumDroppedHops() != 0)
+        runner.addFailure("Loudness: " + juce::String(meter.getNumDroppedHops()) + " hops dropped rendering offline");
+
+    if (std::abs(integrated + 20.0f) > 0.1f)
+        runner.addFailure("Loudness: a minute of -20 LUFS rendered offline reads " + juce::String(integrated, 2) + " LUFS");
+}
+
+//==============================================================================
+// The processor fills its level history on the service tick with no editor open, so
+// each second of alternating loud and quiet signal has to come out on its own rather
+// than merged into the frames either side
+static void checkLevelHistoryWithoutEditor (BenchmarkRunner& runner)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512, numSeconds = 10, blocksPerTick = 8;
+
+    auto processor = createPreparedProcessor(2, sampleRate, blockSize);
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::MidiBuffer midi;
+    const auto numBlocks = (int) (numSeconds * sampleRate) / blockSize;
+
+    for (int block = 0; block < numBlocks; ++block) {
+        const bool loud = (int) (block * blockSize / sampleRate) % 2 == 0;
+
+        for (int channel = 0; channel < 2; ++channel)
+            juce::FloatVectorOperations::fill(buffer.getWritePointer(channel), loud ? 0.5f : 0.05f, blockSize);
+
+        processor->processBlock(buffer, midi);
+
+        if (block % blocksPerTick == blocksPerTick - 1)
+            processor->collectFromAudioThread();
+    }
+
+    if (processor->meterTelemetry.getNumMergedFrames() != 0)
+        runner.addFailure("Level history: " + juce::String(processor->meterTelemetry.getNumMergedFrames())
+                          + " frames merged with the service draining them");
+
+    // The middle of each second, clear of the blocks that straddle the changes
+    for (int second = 0; second < numSeconds; ++second) {
+        const auto expected = second % 2 == 0 ? 0.5f : 0.05f;
+        LevelHistory::Range range;
+        processor->levelHistory.getRanges(second + 0.25, second + 0.75, &range, 1);
+
+        if (range.isEmpty() || std::abs(range.high - expected) > 0.01f)
+            runner.addFailure("Level history: second " + juce::String(second) + " peaks at "
+                              + juce::String(range.high, 3) + " rather than " + juce::String(expected, 3));
+    }
+}
+
+//==============================================================================
+void addMeterBenchmarks (BenchmarkRunner& runner)
+{
+    checkTruePeakAccuracy(runner);
+    checkOfflineLoudness(runner);
+    checkLevelHistoryWithoutEditor(runner);
+
+    constexpr double sampleRate = 48000.0;
+
+    // Loud blocks run the 4x filter; quiet ones are under the threshold and only
+    // keep the filter history up to date
+    for (bool loud : { true, false }) {
+        for (int blockSize : { 64, 512, 4096 }) {
+            const auto name = "truePeak/stereo/" + juce::String(blockSize) + (loud ? "/near-full-scale" : "/quiet");
+
+            if (! runner.shouldRun(name))
+                continue;
+
+            TruePeakDetector detector;
+            detector.prepare(blockSize);
+
+            juce::AudioBuffer<float> buffer(2, blockSize);
+            fillWithTestSignal(buffer, sampleRate);
+
+            if (! loud)
+                buffer.applyGain(0.25f);
+
+            const auto samplePeak = buffer.getMagnitude(0, blockSize);
+
+            runner.run(name, blockSize * 2, [] {},
+                       [&] { juce::ignoreUnused(detector.process(buffer, 2, samplePeak)); });
+        }
+    }
+
+    // Drawing the level history reads a few buckets per pixel at any zoom, so the
+    // whole ten minutes should cost about what a second does
+    const auto windows = { 1, 60, 600 };
+
+    if (std::none_of(windows.begin(), windows.end(),
+                     [&] (int seconds) { return runner.shouldRun("levelHistory/getRanges/" + juce::String(seconds) + "s-380px"); }))
+        return;
+
+    LevelHistory history;
+    MeterFrame frame;
+    frame.numSamples = 512;
+
+    for (juce::int64 position = 0; position < (juce::int64) (history.getRetentionSeconds() * sampleRate); position += frame.numSamples) {
+        frame.samplePosition = position;
+        frame.peak = frame.truePeak = 0.5f + 0.4f * (float) std::sin((double) position * 1.0e-5);
+        history.addFrame(frame, sampleRate);
+    }
+
+    std::vector<LevelHistory::Range> pixels(380);
+
+    for (int seconds : windows) {
+        runner.run("levelHistory/getRanges/" + juce::String(seconds) + "s-380px", 0, [] {}, [&] {
+            history.getRanges(history.getEndSeconds() - seconds, history.getEndSeconds(), pixels.data(), (int) pixels.size());
+        });
+    }
+}
@@ -0,0 +1,198 @@
+/*
+  ==============================================================================
+
+    ParallelBenchmarks.cpp
+    Wide buses processed serially and split across a pool of worker threads.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+#include <thread>
+
+//==============================================================================
+// Stands in for a host's audio worker pool: the workers stay awake spinning while
+// blocks are being processed, as hosts keep theirs during the audio callback, and
+// the calling thread takes tasks too
+class SpinningWorkerPool : public ChannelTaskPool
+{
+public:
+    SpinningWorkerPool(GainAudioProcessor& p, int numWorkers) : processor(p)
+    {
+        for (int i = 0; i < numWorkers; ++i)
+            workers.emplace_back([this] { workerLoop(); });
+    }
+
+    ~SpinningWorkerPool() override
+    {
+        quit = true;
+
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    bool execute(int tasks) noexcept override
+    {
+        numTasks.store(tasks, std::memory_order_relaxed);
+        nextTask.store(0, std::memory_order_relaxed);
+        numUnfinished.store(tasks, std::memory_order_relaxed);
+        generation.fetch_add(1, std::memory_order_release);
+
+        runTasks();
+
+        while (numUnfinished.load(std::memory_order_acquire) > 0)
+            std::this_thread::yield();
+
+        return true;
+    }
+
+private:
+    void workerLoop()
+    {
+        for (int seen = 0; ! quit;) {
+            if (const int current = generation.load(std::memory_order_acquire); current != seen) {
+                seen = current;
+                runTasks();
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void runTasks()
+    {
+        for (int task; (task = nextTask.fetch_add(1, std::memory_order_relaxed)) < numTasks.load(std::memory_order_relaxed);) {
+            processor.runChannelTask(task);
+            numUnfinished.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    GainAudioProcessor& processor;
+    std::vector<std::thread> workers;
+    std::atomic<int> generation { 0 }, numTasks { 0 }, nextTask { 0 }, numUnfinished { 0 };
+    std::atomic<bool> quit { false };
+};
+
+//==============================================================================
+// The pool only changes which thread does each group of channels, so the audio and
+// every meter reading must come out exactly as they do from the serial loop
+static void checkParallelMatchesSerial(BenchmarkRunner& runner, int numChannels, int numWorkers)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256;
+
+    auto serial = createPreparedProcessor(numChannels, sampleRate, blockSize);
+    auto parallel = createPreparedProcessor(numChannels, sampleRate, blockSize);
+    SpinningWorkerPool pool(*parallel, numWorkers);
+    parallel->setChannelTaskPool(&pool, 0);
+
+    juce::AudioBuffer<float> source(numChannels, blockSize), serialBuffer, parallelBuffer;
+    juce::MidiBuffer midi;
+    fillWithTestSignal(source, sampleRate);
+
+    for (int block = 0; block < 32; ++block) {
+        // Ramps from parameter changes and from automation, including a point mid-block
+        for (auto* processor : { serial.get(), parallel.get() }) {
+            processor->gainParam->store(block % 3 == 0 ? 6.0f : -6.0f);
+
+            if (block % 5 == 2)
+                processor->addGainChange(blockSize / 3, 0.0f);
+        }
+
+        serialBuffer.makeCopyOf(source);
+        parallelBuffer.makeCopyOf(source);
+        serial->processBlock(serialBuffer, midi);
+        parallel->processBlock(parallelBuffer, midi);
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            if (! std::equal(serialBuffer.getReadPointer(channel), serialBuffer.getReadPointer(channel) + blockSize,
+                             parallelBuffer.getReadPointer(channel))) {
+                runner.addFailure("parallel/" + juce::String(numChannels) + "ch: channel " + juce::String(channel)
+                                  + " differs from the serial loop in block " + juce::String(block));
+                return;
+            }
+        }
+
+        std::vector<MeterFrame> serialFrames, parallelFrames;
+        serial->meterTelemetry.drain([&] (const MeterFrame& frame) { serialFrames.push_back(frame); });
+        parallel->meterTelemetry.drain([&] (const MeterFrame& frame) { parallelFrames.push_back(frame); });
+
+        ChannelLevels serialLevels, parallelLevels;
+        const bool hasLevels = serial->meterTelemetry.takeChannelLevels(serialLevels);
+
+        if (serialFrames.size() != parallelFrames.size() || hasLevels != parallel->meterTelemetry.takeChannelLevels(parallelLevels)) {
+            runner.addFailure("parallel/" + juce::String(numChannels) + "ch: published different meter readings in block "
+                              + juce::String(block));
+            return;
+        }
+
+        for (size_t i = 0; i < serialFrames.size(); ++i) {
+            const auto& a = serialFrames[i];
+            const auto& b = parallelFrames[i];
+
+            // The energy is summed in a different order, so rms can be off in its last bits
+            if (a.peak != b.peak || a.truePeak != b.truePeak || a.numClippedSamples != b.numClippedSamples
+                  || std::abs(a.rms - b.rms) > 1.0e-5f * a.rms) {
+                runner.addFailure("parallel/" + juce::String(numChannels) + "ch: the meter frame for block " + juce::String(block)
+                                  + " differs from the serial loop");
+                return;
+            }
+        }
+
+        if (hasLevels
+              && (serialLevels.numChannels != parallelLevels.numChannels
+                  || ! std::equal(serialLevels.peaks.begin(), serialLevels.peaks.begin() + serialLevels.numChannels, parallelLevels.peaks.begin())
+                  || ! std::equal(serialLevels.clippedSamples.begin(), serialLevels.clippedSamples.begin() + serialLevels.numChannels,
+                                  parallelLevels.clippedSamples.begin()))) {
+            runner.addFailure("parallel/" + juce::String(numChannels) + "ch: the channels' levels for block " + juce::String(block)
+                              + " differ from the serial loop");
+            return;
+        }
+    }
+}
+
+//==============================================================================
+void addParallelBenchmarks(BenchmarkRunner& runner)
+{
+    constexpr double sampleRate = 48000.0;
+
+    // One worker per core besides this thread, which takes tasks as a host's audio
+    // thread would
+    const int numWorkers = std::max(1, juce::SystemStats::getNumCpus() - 1);
+
+    for (int numChannels : { 16, 64, 128 }) {
+        if (runner.shouldRun("parallel/" + juce::String(numChannels) + "ch"))
+            checkParallelMatchesSerial(runner, numChannels, numWorkers);
+
+        // Both run at every size, the pool taking even blocks below the processor's own
+        // minParallelWork, to show where splitting the channels up starts to pay off
+        for (int blockSize : { 16, 32, 64, 128, 256, 512, 1024 }) {
+            for (bool useThePool : { false, true }) {
+                const auto name = "parallel/" + juce::String(numChannels) + "ch/" + juce::String(blockSize)
+                                + (useThePool ? "/" + juce::String(numWorkers + 1) + "-threads" : juce::String("/serial"));
+
+                if (! runner.shouldRun(name))
+                    continue;
+
+                auto processor = createPreparedProcessor(numChannels, sampleRate, blockSize);
+                std::unique_ptr<SpinningWorkerPool> pool;
+
+                if (useThePool) {
+                    pool = std::make_unique<SpinningWorkerPool>(*processor, numWorkers);
+                    processor->setChannelTaskPool(pool.get(), 0);
+                }
+
+                juce::AudioBuffer<float> source(numChannels, blockSize), buffer(numChannels, blockSize);
+                juce::MidiBuffer midi;
+                fillWithTestSignal(source, sampleRate);
+                processor->gainParam->store(-6.0f);
+
+                runner.run(name, blockSize, [&] { buffer.makeCopyOf(source, true); },
+                           [&] { processor->processBlock(buffer, midi); });
+
+                processor->setChannelTaskPool(nullptr);
+            }
+        }
+    }
+}
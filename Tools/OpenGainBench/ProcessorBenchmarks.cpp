@@ -0,0 +1,395 @@
+/*
+  ==============================================================================
+
+    ProcessorBenchmarks.cpp
+    GainAudioProcessor::processBlock across layouts, block sizes, gain and input.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+
+//==============================================================================
+std::unique_ptr<GainAudioProcessor> createPreparedProcessor (int numChannels, double sampleRate, int blockSize)
+{
+    auto processor = std::make_unique<GainAudioProcessor>();
+    const auto channelSet = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(channelSet);
+    layout.outputBuses.add(channelSet);
+    processor->setBusesLayout(layout);
+
+    processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+    processor->prepareToPlay(sampleRate, blockSize);
+    return processor;
+}
+
+void fillWithTestSignal (juce::AudioBuffer<float>& buffer, double sampleRate)
+{
+    // A full-scale 997 Hz sine with a small offset, so no sample is ever exactly zero
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel) {
+        auto* data = buffer.getWritePointer(channel);
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            data[i] = 0.99f * (float) std::sin(juce::MathConstants<double>::twoPi * 997.0 * i / sampleRate + channel) + 0.01f;
+    }
+}
+
+//==============================================================================
+// Runs every stage, changing gain, through loud and near-silent passages, and checks
+// the tripwire saw nothing on the audio thread and the load monitor timed every block
+static void checkRealtimeSafety (BenchmarkRunner& runner)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256, numBlocks = 400;
+
+    auto processor = createPreparedProcessor(6, sampleRate, blockSize);
+    processor->clipParam->store(2.0f);
+    processor->clipFilterParam->store(1.0f);
+    processor->limiterParam->store(1.0f);
+    processor->dcBlockParam->store(1.0f);
+    processor->ditherParam->store(1.0f);
+    processor->ditherShapeParam->store(3.0f);
+    processor->prepareToPlay(sampleRate, blockSize);
+
+    juce::AudioBuffer<float> source(6, blockSize), buffer(6, blockSize);
+    juce::MidiBuffer midi;
+    fillWithTestSignal(source, sampleRate);
+
+    const auto allocationsBefore = RealtimeTripwire::getNumAllocations();
+    const auto locksBefore = RealtimeTripwire::getNumLocks();
+
+    for (int block = 0; block < numBlocks; ++block) {
+        buffer.makeCopyOf(source, true);
+        buffer.applyGain((block / 50) % 2 == 0 ? 4.0f : 1.0e-7f);
+        processor->gainParam->store(block % 2 == 0 ? 6.0f : -6.0f);
+        processor->autoGainParam->store(block >= numBlocks / 2 ? 1.0f : 0.0f);
+        processor->processBlock(buffer, midi);
+    }
+
+    if (RealtimeTripwire::isEnabled) {
+        if (const auto n = RealtimeTripwire::getNumAllocations() - allocationsBefore; n > 0)
+            runner.addFailure("Realtime tripwire: processBlock allocated or freed " + juce::String(n) + " times");
+
+        if (const auto n = RealtimeTripwire::getNumLocks() - locksBefore; n > 0)
+            runner.addFailure("Realtime tripwire: processBlock took " + juce::String(n) + " locks");
+    }
+
+    if (processor->dspLoad.getSnapshot().numBlocks != (juce::uint64) numBlocks)
+        runner.addFailure("DSP load monitor: didn't time every processBlock call");
+}
+
+//==============================================================================
+// Checks the left/right and mid/side gain modes on a stereo bus: each trim lands on
+// its own channel or on the mid or side, mid/side at 0 dB is exactly linked, and a
+// change of mode or trim ramps rather than stepping
+static void checkGainModes (BenchmarkRunner& runner)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256, numSettlingBlocks = 20;
+
+    juce::AudioBuffer<float> source(2, blockSize), buffer(2, blockSize);
+    juce::MidiBuffer midi;
+    fillWithTestSignal(source, sampleRate);
+
+    // Runs enough blocks for every ramp to settle, and leaves the last one in buffer
+    auto settle = [&] (GainAudioProcessor& processor, const juce::AudioBuffer<float>& input) {
+        for (int block = 0; block < numSettlingBlocks; ++block) {
+            buffer.makeCopyOf(input, true);
+            processor.processBlock(buffer, midi);
+        }
+    };
+
+    auto setParameter = [] (GainAudioProcessor& processor, const char* id, float value) {
+        processor.apvts.getRawParameterValue(id)->store(value);
+    };
+
+    auto linked = createPreparedProcessor(2, sampleRate, blockSize);
+    linked->gainParam->store(-6.0f);
+    settle(*linked, source);
+    const juce::AudioBuffer<float> linkedOutput(buffer);
+
+    auto processor = createPreparedProcessor(2, sampleRate, blockSize);
+    processor->gainParam->store(-6.0f);
+    setParameter(*processor, "GAIN_MODE", 2.0f);
+    settle(*processor, source);
+
+    for (int channel = 0; channel < 2; ++channel)
+        if (std::memcmp(buffer.getReadPointer(channel), linkedOutput.getReadPointer(channel), blockSize * sizeof(float)) != 0)
+            runner.addFailure("Gain modes: mid/side at 0 dB doesn't match linked");
+
+    // A signal that is all mid doesn't hear the side trim
+    juce::AudioBuffer<float> mono(source);
+    mono.copyFrom(1, 0, mono, 0, 0, blockSize);
+    setParameter(*processor, "SIDE", -12.0f);
+    settle(*processor, mono);
+
+    const auto expectedMono = juce::Decibels::decibelsToGain(-6.0f) * mono.getSample(0, 100);
+
+    if (std::abs(buffer.getSample(0, 100) - expectedMono) > 1.0e-5f || std::abs(buffer.getSample(1, 100) - expectedMono) > 1.0e-5f)
+        runner.addFailure("Gain modes: mid/side trimmed the mid when only the side was turned down");
+
+    // Left/right, and a change of mode on the way: the channels' gains are the main
+    // gain times their own trims, and a steady input never jumps getting there
+    juce::AudioBuffer<float> steady(2, blockSize);
+
+    for (int channel = 0; channel < 2; ++channel)
+        juce::FloatVectorOperations::fill(steady.getWritePointer(channel), 0.25f, blockSize);
+
+    setParameter(*processor, "GAIN_MODE", 1.0f);
+    setParameter(*processor, "LEFT", 6.0f);
+    setParameter(*processor, "RIGHT", -6.0f);
+
+    float previous[2] = { buffer.getSample(0, blockSize - 1), buffer.getSample(1, blockSize - 1) };
+    float largestStep = 0.0f;
+
+    for (int block = 0; block < 2 * numSettlingBlocks; ++block) {
+        buffer.makeCopyOf(steady, true);
+        processor->processBlock(buffer, midi);
+
+        for (int channel = 0; channel < 2; ++channel) {
+            for (int i = 0; i < blockSize; ++i) {
+                // The first block picks up from the mono signal, so it isn't counted
+                if (block > 0 || i > 0)
+                    largestStep = std::max(largestStep, std::abs(buffer.getSample(channel, i) - previous[channel]));
+
+                previous[channel] = buffer.getSample(channel, i);
+            }
+        }
+    }
+
+    if (largestStep > 1.0e-3f)
+        runner.addFailure("Gain modes: changing mode stepped the output by " + juce::String(largestStep, 5));
+
+    if (std::abs(buffer.getSample(0, 0) - 0.25f) > 1.0e-5f || std::abs(buffer.getSample(1, 0) - 0.25f * juce::Decibels::decibelsToGain(-12.0f)) > 1.0e-5f)
+        runner.addFailure("Gain modes: left/right didn't settle on the channels' trims");
+}
+
+//==============================================================================
+// Renders a straight line in dB the way OpenGainRender's --gain-to does, with one
+// automation point at the end of every block, and compares each sample with the
+// line itself. Between points the gain ramps linearly in amplitude, which strays
+// from the curve by about ln(r)^2 / 8 of the gain for a segment spanning a ratio r
+// (the (1 + ln r) covers the next term); the rest has to be float rounding,
+// whatever the block size.
+static void checkAutomationCurve (BenchmarkRunner& runner)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numSamples = 96000;
+    constexpr float startDb = -12.0f, endDb = 12.0f, input = 0.25f;
+
+    auto curveDb = [] (juce::int64 sample) {
+        return startDb + (endDb - startDb) * (double) sample / (double) numSamples;
+    };
+
+    for (int blockSize : { 32, 512, 2048 }) {
+        auto processor = createPreparedProcessor(1, sampleRate, blockSize);
+        processor->gainParam->store(startDb);
+        processor->prepareToPlay(sampleRate, blockSize);
+
+        // The closed-form error of one block's linear segment, and the rounding on top
+        const auto segmentLog = (endDb - startDb) * blockSize / numSamples * std::log(10.0) / 20.0;
+        const auto tolerance = segmentLog * segmentLog / 8.0 * (1.0 + segmentLog) + 4.0e-6;
+
+        juce::AudioBuffer<float> buffer(1, blockSize);
+        juce::MidiBuffer midi;
+        double largestError = 0.0;
+
+        for (juce::int64 position = 0; position < numSamples; position += blockSize) {
+            const int thisBlock = (int) std::min((juce::int64) blockSize, numSamples - position);
+            juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), 1, thisBlock);
+            juce::FloatVectorOperations::fill(block.getWritePointer(0), input, thisBlock);
+
+            processor->addGainChange(thisBlock, (float) curveDb(position + thisBlock));
+            processor->processBlock(block, midi);
+
+            for (int i = 0; i < thisBlock; ++i) {
+                const auto expected = std::pow(10.0, curveDb(position + i) / 20.0);
+                largestError = std::max(largestError, std::abs(block.getSample(0, i) / input - expected) / expected);
+            }
+        }
+
+        if (largestError > tolerance)
+            runner.addFailure("Automation curve: blocks of " + juce::String(blockSize) + " are off the line in dB by "
+                              + juce::String(largestError, 7) + " of the gain, more than " + juce::String(tolerance, 7));
+    }
+}
+
+// A host's parameter events, set the way the CLAP build sets them, have to reach the
+// values processBlock() reads. GAIN's are followed sample-accurately, and once they
+// stop the gain stays where the last one left it rather than going back to the
+// parameter's old value.
+static void checkHostParameterEvents (BenchmarkRunner& runner)
+{
+    constexpr int blockSize = 512;
+    constexpr float input = 0.25f;
+
+    auto settings = createPreparedProcessor(1, 48000.0, blockSize);
+
+    for (auto [id, value] : { std::pair<const char*, float> { "LIMITER", 1.0f }, { "CLIP", 2.0f }, { "DITHER", 1.0f },
+                              { "DC_BLOCK", 1.0f }, { "GAIN_MODE", 1.0f }, { "MID", -3.0f }, { "GAIN", 6.0f } }) {
+        settings->setParameterFromHost(*settings->apvts.getParameter(id), value, 0);
+        const auto raw = settings->apvts.getRawParameterValue(id)->load();
+
+        if (std::abs(raw - value) > 1.0e-4f)
+            runner.addFailure("Host parameter events: " + juce::String(id) + " set to " + juce::String(value)
+                              + " reads " + juce::String(raw) + " in processBlock()");
+    }
+
+    auto processor = createPreparedProcessor(1, 48000.0, blockSize);
+    juce::AudioBuffer<float> buffer(1, blockSize);
+    juce::MidiBuffer midi;
+
+    for (int block = 0; block < 8; ++block) {
+        if (block == 0)
+            processor->setParameterFromHost(*processor->apvts.getParameter("GAIN"), 6.0f, blockSize / 2);
+
+        juce::FloatVectorOperations::fill(buffer.getWritePointer(0), input, blockSize);
+        processor->processBlock(buffer, midi);
+    }
+
+    const auto gainDb = juce::Decibels::gainToDecibels(buffer.getSample(0, blockSize - 1) / input);
+
+    if (std::abs(gainDb - 6.0f) > 0.01f)
+        runner.addFailure("Host parameter events: the gain went to " + juce::String(gainDb, 3)
+                          + " dB after the last GAIN event, rather than staying at 6");
+}
+
+//==============================================================================
+// Switching the limiter on changes the latency in processBlock(), but the host's
+// listeners must only hear of it on the message thread, from the service tick
+static void checkLatencyReporting (BenchmarkRunner& runner)
+{
+    constexpr int blockSize = 512;
+
+    struct LatencyListener : juce::AudioProcessorListener
+    {
+        void audioProcessorParameterChanged (juce::AudioProcessor*, int, float) override {}
+
+        void audioProcessorChanged (juce::AudioProcessor* processor, const ChangeDetails& details) override
+        {
+            if (details.latencyChanged)
+                latencies.push_back(processor->getLatencySamples());
+        }
+
+        std::vector<int> latencies;
+    };
+
+    auto processor = createPreparedProcessor(2, 48000.0, blockSize);
+    LatencyListener listener;
+    processor->addListener(&listener);
+
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::MidiBuffer midi;
+    fillWithTestSignal(buffer, 48000.0);
+
+    processor->limiterParam->store(1.0f);
+    processor->processBlock(buffer, midi);
+
+    if (! listener.latencies.empty())
+        runner.addFailure("Latency reporting: the listeners heard of the limiter's latency from processBlock()");
+
+    processor->collectFromAudioThread();
+    processor->collectFromAudioThread();
+    const int expected = processor->getLatencySamples();
+
+    if (listener.latencies.size() != 1 || expected <= 0 || listener.latencies.front() != expected)
+        runner.addFailure("Latency reporting: the service tick told the listeners " + juce::String((int) listener.latencies.size())
+                          + " times, rather than once, of the limiter's latency");
+
+    processor->removeListener(&listener);
+}
+
+//==============================================================================
+void addProcessorBenchmarks (BenchmarkRunner& runner)
+{
+    constexpr double sampleRate = 48000.0;
+
+    checkRealtimeSafety(runner);
+    checkGainModes(runner);
+    checkAutomationCurve(runner);
+    checkHostParameterEvents(runner);
+    checkLatencyReporting(runner);
+
+    // Mono and stereo, then 5.1 and 16 and 64 discrete channels
+    for (int numChannels : { 1, 2, 6, 16, 64 }) {
+        const auto layoutName = numChannels == 1 ? juce::String("mono") : numChannels == 2 ? juce::String("stereo")
+                                                                                         : juce::String(numChannels) + "ch";
+
+        for (int blockSize : { 16, 64, 256, 1024, 4096 }) {
+            for (bool changingGain : { false, true }) {
+                for (juce::String input : { "silent", "silent-detection-off", "full-scale" }) {
+                    const auto name = "processBlock/" + layoutName + "/"
+                                    + juce::String(blockSize)
+                                    + (changingGain ? "/changing-gain" : "/static-gain")
+                                    + "/" + input;
+
+                    if (! runner.shouldRun(name))
+                        continue;
+
+                    auto processor = createPreparedProcessor(numChannels, sampleRate, blockSize);
+                    juce::AudioBuffer<float> source(numChannels, blockSize), buffer(numChannels, blockSize);
+                    juce::MidiBuffer midi;
+
+                    // Silence is a faint signal well under the detection threshold rather
+                    // than a cleared buffer, so the detector has to scan every sample
+                    fillWithTestSignal(source, sampleRate);
+
+                    if (input != "full-scale")
+                        source.applyGain(1.0e-7f);
+
+                    processor->silenceDetectionParam->store(input == "silent" ? 1.0f : 0.0f);
+
+                    // Static gain sits off unity so the multiply isn't skipped; changing gain
+                    // moves the parameter every block, so every block is ramping
+                    processor->gainParam->store(-6.0f);
+                    float nextGainDb = 6.0f;
+
+                    runner.run(name, blockSize,
+                               [&] {
+                                   buffer.makeCopyOf(source, true);
+
+                                   if (changingGain) {
+                                       processor->gainParam->store(nextGainDb);
+                                       nextGainDb = -nextGainDb;
+                                   }
+                               },
+                               [&] { processor->processBlock(buffer, midi); });
+                }
+            }
+        }
+    }
+
+    // A 64-bit host calls the double processBlock directly. Without double support it
+    // would convert every block to float and back around the float one instead.
+    for (int blockSize : { 64, 512, 4096 }) {
+        for (bool native : { true, false }) {
+            const auto name = "processBlock/stereo/" + juce::String(blockSize) + (native ? "/double-native" : "/double-converted");
+
+            if (! runner.shouldRun(name))
+                continue;
+
+            auto processor = createPreparedProcessor(2, sampleRate, blockSize);
+            juce::AudioBuffer<float> floatBuffer(2, blockSize);
+            juce::AudioBuffer<double> source, buffer(2, blockSize);
+            juce::MidiBuffer midi;
+
+            fillWithTestSignal(floatBuffer, sampleRate);
+            source.makeCopyOf(floatBuffer);
+            processor->gainParam->store(-6.0f);
+
+            runner.run(name, blockSize, [&] { buffer.makeCopyOf(source, true); },
+                       [&] {
+                           if (native) {
+                               processor->processBlock(buffer, midi);
+                           }
+                           else {
+                               floatBuffer.makeCopyOf(buffer, true);
+                               processor->processBlock(floatBuffer, midi);
+                               buffer.makeCopyOf(floatBuffer, true);
+                           }
+                       });
+        }
+    }
+}
@@ -0,0 +1,148 @@
+/*
+  ==============================================================================
+
+    SoftClipBenchmarks.cpp
+    Oversampled soft clipper: latency, bypass, switching and ns/sample by factor and filter.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+
+static const juce::String filterNames[] { "iir", "fir" };
+
+static void fillWithSine (juce::AudioBuffer<float>& buffer, int startSample, float amplitude)
+{
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel) {
+        auto* data = buffer.getWritePointer(channel);
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            data[i] = amplitude * (float) std::sin(0.05 * (startSample + i));
+    }
+}
+
+//==============================================================================
+static void checkSoftClipper (BenchmarkRunner& runner, int factorLog2, SoftClipper::Filter filter)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 100;
+    const auto caseName = "Soft clip at " + juce::String(1 << factorLog2) + "x/" + filterNames[(int) filter];
+    const auto& kernels = GainKernels<float>::forISA(GainKernelSupport::getBestAvailableISA());
+
+    SoftClipper clipper;
+    clipper.prepare(sampleRate, blockSize, 2, false);
+    clipper.setOversampling(factorLog2, filter);
+    const int latency = clipper.getLatencySamples();
+
+    // Once quiet for long enough it goes round the oversampling, through a delay of the
+    // same length, so an impulse under the bypass level comes out whole and on time
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    std::vector<float> output;
+
+    for (int block = 0; block < 200; ++block) {
+        buffer.clear();
+
+        if (block == 150)
+            buffer.setSample(0, 3, 0.1f);
+
+        clipper.process(buffer.getArrayOfWritePointers(), 2, blockSize, buffer.getMagnitude(0, blockSize), kernels);
+
+        if (block >= 150)
+            output.insert(output.end(), buffer.getReadPointer(0), buffer.getReadPointer(0) + blockSize);
+    }
+
+    const auto impulse = std::find_if(output.begin(), output.end(), [] (float x) { return x != 0.0f; });
+
+    if (clipper.isOversampling())
+        runner.addFailure(caseName + ": still oversampling after a second of silence");
+    else if (impulse == output.end() || impulse - output.begin() != 3 + latency || *impulse != 0.1f)
+        runner.addFailure(caseName + ": the bypass doesn't delay by the reported " + juce::String(latency) + " samples");
+
+    // A sine 12 dB over full scale switches the oversampling straight back on, and is
+    // rounded off to about full scale; only the filters' ripple can take it past
+    float loudest = 0.0f;
+
+    for (int block = 0; block < 100; ++block) {
+        fillWithSine(buffer, block * blockSize, 4.0f);
+        clipper.process(buffer.getArrayOfWritePointers(), 2, blockSize, buffer.getMagnitude(0, blockSize), kernels);
+        loudest = std::max(loudest, buffer.getMagnitude(0, blockSize));
+
+        if (! clipper.isOversampling()) {
+            runner.addFailure(caseName + ": didn't start oversampling on a loud block");
+            break;
+        }
+    }
+
+    if (loudest > 1.1f)
+        runner.addFailure(caseName + ": let a peak of " + juce::String(loudest, 4) + " through");
+}
+
+// Every oversampler is built by prepare(), so the factor and filter can change while a
+// sine under the knee plays. The new filters are primed from the recent signal, so no
+// block after a switch comes out quieter or louder than the sine.
+static void checkOversamplingSwitches (BenchmarkRunner& runner)
+{
+    constexpr int blockSize = 100;
+    const auto& kernels = GainKernels<float>::forISA(GainKernelSupport::getBestAvailableISA());
+
+    SoftClipper clipper;
+    clipper.prepare(48000.0, blockSize, 2, false);
+
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    float quietest = 1.0f, loudest = 0.0f;
+
+    for (int block = 0; block < 120; ++block) {
+        constexpr int factors[] { 1, 3, 2, 2, 1, 3 };
+        const auto filter = block / 20 % 2 == 0 ? SoftClipper::Filter::polyphaseIIR : SoftClipper::Filter::linearPhaseFIR;
+        clipper.setOversampling(factors[block / 20], filter);
+
+        fillWithSine(buffer, block * blockSize, 0.3f);
+        clipper.process(buffer.getArrayOfWritePointers(), 2, blockSize, buffer.getMagnitude(0, blockSize), kernels);
+
+        // Past the first block, which has the filters' latency of silence in it
+        if (block > 1) {
+            quietest = std::min(quietest, buffer.getMagnitude(0, blockSize));
+            loudest = std::max(loudest, buffer.getMagnitude(0, blockSize));
+        }
+    }
+
+    if (quietest < 0.27f || loudest > 0.33f)
+        runner.addFailure("Soft clip: switching oversampling mid-stream made a 0.3 sine peak between "
+                          + juce::String(quietest, 3) + " and " + juce::String(loudest, 3));
+}
+
+//==============================================================================
+void addSoftClipBenchmarks (BenchmarkRunner& runner)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    const auto& kernels = GainKernels<float>::forISA(GainKernelSupport::getBestAvailableISA());
+
+    checkOversamplingSwitches(runner);
+
+    for (int factorLog2 = 1; factorLog2 <= SoftClipper::maxFactorLog2; ++factorLog2) {
+        for (auto filter : { SoftClipper::Filter::polyphaseIIR, SoftClipper::Filter::linearPhaseFIR }) {
+            checkSoftClipper(runner, factorLog2, filter);
+
+            // Loud blocks pay for the oversampling; quiet ones should only cost the delay
+            for (float amplitude : { 2.0f, 0.05f }) {
+                const auto name = "softClip/stereo/" + juce::String(1 << factorLog2) + "x/" + filterNames[(int) filter]
+                                + (amplitude > 1.0f ? "/loud" : "/quiet");
+
+                if (! runner.shouldRun(name))
+                    continue;
+
+                SoftClipper clipper;
+                clipper.prepare(sampleRate, blockSize, 2, false);
+                clipper.setOversampling(factorLog2, filter);
+
+                juce::AudioBuffer<float> source(2, blockSize), buffer(2, blockSize);
+                fillWithSine(source, 0, amplitude);
+                const float peak = source.getMagnitude(0, blockSize);
+
+                runner.run(name, blockSize, [&] { buffer.makeCopyOf(source, true); },
+                           [&] { clipper.process(buffer.getArrayOfWritePointers(), 2, blockSize, peak, kernels); });
+            }
+        }
+    }
+}
@@ -0,0 +1,140 @@
+/*
+  ==============================================================================
+
+    StateBenchmarks.cpp
+    Saving and restoring plugin state, binary against XML, across a large session.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+
+//==============================================================================
+// Every parameter away from its default
+static void setNonDefaultParameters (GainAudioProcessor& processor)
+{
+    auto set = [&processor] (const juce::String& id, float value) {
+        if (auto* param = processor.apvts.getParameter(id))
+            param->setValueNotifyingHost(param->convertTo0to1(value));
+    };
+
+    set("GAIN", -4.5f);
+    set("SILENCE", 0.0f);
+    set("CLIP", 2.0f);
+    set("CLIP_FILTER", 1.0f);
+    set("LIMITER", 1.0f);
+    set("LOOKAHEAD", 2.5f);
+    set("RELEASE", 250.0f);
+}
+
+// The format getStateInformation() wrote before the binary one
+static void writeXmlState (GainAudioProcessor& processor, juce::MemoryBlock& destData)
+{
+    std::unique_ptr<juce::XmlElement> xml(processor.apvts.copyState().createXml());
+    juce::AudioProcessor::copyXmlToBinary(*xml, destData);
+}
+
+static juce::String findMismatch (const GainAudioProcessor& expected, const GainAudioProcessor& actual)
+{
+    const auto& expectedParams = expected.getParameters();
+    const auto& actualParams = actual.getParameters();
+
+    for (int i = 0; i < expectedParams.size(); ++i)
+        if (expectedParams[i]->getValue() != actualParams[i]->getValue())
+            return expectedParams[i]->getName(64);
+
+    return {};
+}
+
+static void checkState (BenchmarkRunner& runner)
+{
+    GainAudioProcessor source;
+    setNonDefaultParameters(source);
+
+    juce::MemoryBlock binary, xml;
+    source.getStateInformation(binary);
+    writeXmlState(source, xml);
+
+    if (! BinaryState::isBinaryState(binary.getData(), (int) binary.getSize()))
+        runner.addFailure("State: getStateInformation() didn't write the binary format");
+
+    if (binary.getSize() >= xml.getSize())
+        runner.addFailure("State: the binary state (" + juce::String((int) binary.getSize()) + " bytes) isn't smaller than the XML ("
+                          + juce::String((int) xml.getSize()) + " bytes)");
+
+    // Both formats restore every parameter exactly
+    for (auto* state : { &binary, &xml }) {
+        GainAudioProcessor restored;
+        restored.setStateInformation(state->getData(), (int) state->getSize());
+
+        if (const auto mismatch = findMismatch(source, restored); mismatch.isNotEmpty())
+            runner.addFailure("State: " + juce::String(state == &binary ? "binary" : "XML") + " restore got " + mismatch + " wrong");
+    }
+
+    // A cut-short state changes nothing, and parameters a state leaves out go back to
+    // their defaults
+    {
+        GainAudioProcessor defaults, restored;
+        restored.setStateInformation(binary.getData(), (int) binary.getSize() - 1);
+
+        if (findMismatch(defaults, restored).isNotEmpty())
+            runner.addFailure("State: a truncated binary state changed parameters");
+
+        juce::MemoryBlock header(binary.getData(), 8);
+        header[6] = 0;
+        header[7] = 0;
+        setNonDefaultParameters(restored);
+        restored.setStateInformation(header.getData(), (int) header.getSize());
+
+        if (findMismatch(defaults, restored).isNotEmpty())
+            runner.addFailure("State: parameters missing from a binary state weren't reset to their defaults");
+    }
+}
+
+//==============================================================================
+void addStateBenchmarks (BenchmarkRunner& runner)
+{
+    checkState(runner);
+
+    // A large session's worth of instances, saved and opened in one go
+    constexpr int numInstances = 1000;
+    const auto suffix = "/" + juce::String(numInstances) + "-instances";
+
+    const auto names = { "state/save/binary", "state/save/xml", "state/restore/binary", "state/restore/xml" };
+
+    if (std::none_of(names.begin(), names.end(), [&] (const char* name) { return runner.shouldRun(name + suffix); }))
+        return;
+
+    std::vector<std::unique_ptr<GainAudioProcessor>> instances;
+
+    for (int i = 0; i < numInstances; ++i) {
+        instances.push_back(std::make_unique<GainAudioProcessor>());
+        setNonDefaultParameters(*instances.back());
+    }
+
+    juce::MemoryBlock binary, xml;
+    instances.front()->getStateInformation(binary);
+    writeXmlState(*instances.front(), xml);
+
+    std::vector<juce::MemoryBlock> saved((size_t) numInstances);
+
+    runner.run("state/save/binary" + suffix, 0, [] {}, [&] {
+        for (size_t i = 0; i < instances.size(); ++i)
+            instances[i]->getStateInformation(saved[i]);
+    });
+
+    runner.run("state/save/xml" + suffix, 0, [] {}, [&] {
+        for (size_t i = 0; i < instances.size(); ++i)
+            writeXmlState(*instances[i], saved[i]);
+    });
+
+    runner.run("state/restore/binary" + suffix, 0, [] {}, [&] {
+        for (auto& instance : instances)
+            instance->setStateInformation(binary.getData(), (int) binary.getSize());
+    });
+
+    runner.run("state/restore/xml" + suffix, 0, [] {}, [&] {
+        for (auto& instance : instances)
+            instance->setStateInformation(xml.getData(), (int) xml.getSize());
+    });
+}
@@ -0,0 +1,417 @@
+/*
+  ==============================================================================
+
+    StressBenchmarks.cpp
+    processBlock at random block sizes, alignments and channel counts, and its cost per call by block size.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+
+//==============================================================================
+// How many representable values apart two samples are: 0 if they're equal, 1 if
+// they're neighbours. A NaN is as far from everything as it gets.
+template <typename SampleType>
+static juce::uint64 ulpDistance (SampleType a, SampleType b)
+{
+    using Bits = std::conditional_t<std::is_same_v<SampleType, double>, juce::uint64, juce::uint32>;
+
+    if (a == b)
+        return 0;
+
+    if (std::isnan(a) || std::isnan(b))
+        return std::numeric_limits<juce::uint64>::max();
+
+    // The bit patterns, remapped so that they count up through every value in order,
+    // with both zeros in the middle
+    auto toOrdered = [] (SampleType x) {
+        constexpr auto signBit = (Bits) 1 << (8 * sizeof(Bits) - 1);
+        Bits bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        return (juce::uint64) ((bits & signBit) != 0 ? signBit - (bits & ~signBit) : signBit + bits);
+    };
+
+    const auto x = toOrdered(a), y = toOrdered(b);
+    return x > y ? x - y : y - x;
+}
+
+//==============================================================================
+// The processor's gain worked out one sample at a time. It has the same smoother,
+// which is what defines the ramps, and the same rules for reading the parameter,
+// splitting at automation points and jumping on a skipped block, but none of the
+// block planning, kernels or chunking that are under test.
+class GoldenGainModel
+{
+public:
+    struct Gain
+    {
+        float value = 1.0f;
+        float rampScale = 0.0f;     // the larger end of the ramp the sample is on, or 0 if it's settled
+    };
+
+    GoldenGainModel (double sampleRate, float gainDb) : lastGainDb(gainDb)
+    {
+        smoother.reset(sampleRate, GainAudioProcessor::gainRampSeconds);
+        smoother.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(gainDb));
+    }
+
+    // Fills gains with the gain for each of the block's samples. points are the
+    // block's automation points in the order the processor's queue keeps them.
+    void process (std::vector<Gain>& gains, int numSamples, float parameterDb,
+                  const std::vector<GainAutomationQueue::Point>& points, bool skipped)
+    {
+        gains.clear();
+
+        if (skipped) {
+            lastGainDb = points.empty() ? parameterDb : points.back().gainDb;
+            smoother.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(lastGainDb));
+            return;
+        }
+
+        if (points.empty()) {
+            if (parameterDb != lastGainDb) {
+                lastGainDb = parameterDb;
+                const float target = juce::Decibels::decibelsToGain(parameterDb);
+                startRamp(target);
+                smoother.setTargetValue(target);
+            }
+
+            advance(gains, numSamples);
+            return;
+        }
+
+        int segmentStart = 0;
+
+        for (auto& point : points) {
+            const int pointOffset = juce::jlimit(0, numSamples, point.sampleOffset);
+            const float pointGain = juce::Decibels::decibelsToGain(point.gainDb);
+
+            if (pointOffset > segmentStart) {
+                startRamp(pointGain);
+                smoother.setTargetValue(pointGain, pointOffset - segmentStart);
+                advance(gains, pointOffset - segmentStart);
+                segmentStart = pointOffset;
+            }
+            else if (point.gainDb != lastGainDb) {
+                startRamp(pointGain);
+                smoother.setTargetValue(pointGain);
+            }
+
+            lastGainDb = point.gainDb;
+        }
+
+        advance(gains, numSamples - segmentStart);
+    }
+
+private:
+    // A ramp's rounding is relative to the larger of its ends, however small the gain
+    // gets along the way
+    void startRamp (float target)
+    {
+        rampScale = std::max(smoother.getCurrentValue(), target);
+    }
+
+    void advance (std::vector<Gain>& gains, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i) {
+            const auto ramp = smoother.takeRamp(1);
+            gains.push_back(ramp.numSamples > 0 ? Gain { ramp.start, rampScale } : Gain { smoother.getTargetValue(), 0.0f });
+        }
+    }
+
+    GainSmoother smoother;
+    float lastGainDb = 0.0f, rampScale = 0.0f;
+};
+
+//==============================================================================
+// Block sizes as hosts hand them out. Most fit within the prepared size, but some
+// are empty or a single sample, some are exactly the prepared size, and some are
+// longer than that
+static int pickBlockSize (juce::Random& random, int preparedBlockSize)
+{
+    switch (random.nextInt(10)) {
+        case 0:  return 0;
+        case 1:  return 1;
+        case 2:
+        case 3:
+        case 4:  return 2 + random.nextInt(30);
+        case 5:
+        case 6:
+        case 7:  return 32 + random.nextInt(preparedBlockSize - 31);
+        case 8:  return preparedBlockSize;
+        default: return preparedBlockSize + 1 + random.nextInt(2 * preparedBlockSize + 7);
+    }
+}
+
+// A gain from the parameter's range in quarter-dB steps, so the same value sometimes
+// comes round again
+static float pickGainDb (juce::Random& random)
+{
+    return (float) random.nextInt(97) * 0.25f - 12.0f;
+}
+
+// One processor with a random layout, precision, prepared size and silence detection,
+// through a few hundred random blocks. Each block has its own alignment, and its gain
+// changes at random by parameter and by automation points. Every output sample is
+// compared with the model. Nothing outside the block may be written to, and the
+// block's meter frame has to read the output's exact peaks.
+template <typename SampleType>
+static void runStressTrial (BenchmarkRunner& runner, juce::Random& random, int trial)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numBlocks = 200, maxAlignmentOffset = 15, guardSize = 16;
+    constexpr double maxRampUlps = 4.0;
+    const auto guardValue = (SampleType) 1234.5;
+
+    static constexpr int channelCounts[] { 1, 2, 3, 5, 6, 8, 13, 16 };
+    static constexpr int preparedBlockSizes[] { 32, 64, 100, 256, 441, 512, 1024 };
+
+    const int numChannels = channelCounts[random.nextInt((int) std::size(channelCounts))];
+    const int preparedBlockSize = preparedBlockSizes[random.nextInt((int) std::size(preparedBlockSizes))];
+    const bool silenceDetection = random.nextBool();
+
+    const auto description = "Stress trial " + juce::String(trial) + " ("
+                           + (std::is_same_v<SampleType, double> ? "double" : "float") + ", "
+                           + juce::String(numChannels) + "ch, prepared for " + juce::String(preparedBlockSize)
+                           + (silenceDetection ? "" : ", silence detection off") + ")";
+
+    auto processor = createPreparedProcessor(numChannels, sampleRate, preparedBlockSize);
+    processor->silenceDetectionParam->store(silenceDetection ? 1.0f : 0.0f);
+
+    if constexpr (std::is_same_v<SampleType, double>) {
+        processor->setProcessingPrecision(juce::AudioProcessor::doublePrecision);
+        processor->prepareToPlay(sampleRate, preparedBlockSize);
+    }
+
+    // Each channel's block sits somewhere in its own storage, between guard values
+    const int maxBlockSize = 3 * preparedBlockSize + 7;
+    const int storageSize = guardSize + maxAlignmentOffset + maxBlockSize + guardSize;
+    std::vector<std::vector<SampleType>> storage((size_t) numChannels, std::vector<SampleType>((size_t) storageSize));
+    std::vector<SampleType*> channels((size_t) numChannels);
+    std::vector<SampleType> input;
+
+    GoldenGainModel model(sampleRate, processor->gainParam->load());
+    std::vector<GoldenGainModel::Gain> gains;
+    std::vector<GainAutomationQueue::Point> points;
+    juce::MidiBuffer midi;
+    juce::int64 position = 0;
+
+    for (int block = 0; block < numBlocks; ++block) {
+        const int numSamples = pickBlockSize(random, preparedBlockSize);
+
+        // Offsets of up to 15 samples from the storage's start, so most blocks are
+        // misaligned for any vector width
+        for (int channel = 0; channel < numChannels; ++channel) {
+            auto& span = storage[(size_t) channel];
+            std::fill(span.begin(), span.end(), guardValue);
+            channels[(size_t) channel] = span.data() + guardSize + random.nextInt(maxAlignmentOffset + 1);
+        }
+
+        // Random samples, none of them near enough to zero to count as silence
+        input.resize((size_t) (numChannels * numSamples));
+
+        for (auto& sample : input) {
+            const auto magnitude = 0.01 + 0.99 * random.nextDouble();
+            sample = (SampleType) (random.nextBool() ? magnitude : -magnitude);
+        }
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            std::copy_n(input.data() + channel * numSamples, numSamples, channels[(size_t) channel]);
+
+        // The parameter moves on about a third of blocks, and about a quarter of blocks
+        // bring automation points, anywhere from the block's start to its end
+        if (random.nextInt(3) == 0)
+            processor->gainParam->store(pickGainDb(random));
+
+        points.clear();
+
+        if (random.nextInt(4) == 0) {
+            for (int i = random.nextInt(4); i >= 0; --i) {
+                points.push_back({ random.nextInt(numSamples + 1), pickGainDb(random) });
+                processor->addGainChange(points.back().sampleOffset, points.back().gainDb);
+            }
+
+            std::stable_sort(points.begin(), points.end(), [] (const auto& a, const auto& b) { return a.sampleOffset < b.sampleOffset; });
+        }
+
+        const auto parameterDb = processor->gainParam->load();
+        juce::AudioBuffer<SampleType> buffer(channels.data(), numChannels, numSamples);
+        processor->processBlock(buffer, midi);
+
+        // Only an empty block can be silent, as every sample of the others is audible
+        const bool skipped = silenceDetection && numSamples == 0;
+        model.process(gains, numSamples, parameterDb, points, skipped);
+
+        juce::String problem;
+
+        for (int channel = 0; channel < numChannels && problem.isEmpty(); ++channel) {
+            const auto& span = storage[(size_t) channel];
+            const auto* data = channels[(size_t) channel];
+            const auto* source = input.data() + channel * numSamples;
+            const auto isGuard = [&] (SampleType sample) { return sample == guardValue; };
+            const auto begin = span.begin() + (data - span.data());
+
+            if (! std::all_of(span.begin(), begin, isGuard) || ! std::all_of(begin + numSamples, span.end(), isGuard))
+                problem = "channel " + juce::String(channel) + " was written outside the block";
+
+            for (int i = 0; i < numSamples && problem.isEmpty(); ++i) {
+                const auto& gain = gains[(size_t) i];
+                const auto expected = (SampleType) ((double) source[i] * (double) gain.value);
+
+                // At a settled gain the product is exact, so the sample has to be too.
+                // The smoother hands out its ramps in float, worked out from a different
+                // sample in the processor than in the model, so along one they can only
+                // agree to a few of float's ULPs of the ramp's larger end.
+                if (gain.rampScale == 0.0f) {
+                    if (const auto distance = ulpDistance(data[i], expected); distance > 0)
+                        problem = "channel " + juce::String(channel) + " sample " + juce::String(i) + " is "
+                                + juce::String((juce::int64) juce::jmin(distance, (juce::uint64) 1 << 62)) + " ULPs from the model";
+                }
+                else {
+                    const auto ulps = std::abs((double) data[i] - (double) expected)
+                                    / (std::numeric_limits<float>::epsilon() * std::abs((double) source[i]) * gain.rampScale);
+
+                    if (! (ulps <= maxRampUlps))
+                        problem = "channel " + juce::String(channel) + " sample " + juce::String(i) + " is "
+                                + juce::String(ulps, 1) + " ULPs of its ramp from the model";
+                }
+            }
+        }
+
+        // One frame for each block that wasn't skipped, at the block's position, and
+        // the channels' levels, with exactly the output's peaks and clip counts
+        int numFrames = 0;
+
+        processor->meterTelemetry.drain([&] (const MeterFrame& frame) {
+            if (++numFrames == 1 && problem.isEmpty() && (frame.numSamples != numSamples || frame.samplePosition != position))
+                problem = "the meter frame covers the wrong samples";
+        });
+
+        ChannelLevels levels;
+
+        if (processor->meterTelemetry.takeChannelLevels(levels) != ! skipped && problem.isEmpty())
+            problem = skipped ? "a skipped block published channel levels" : "no channel levels were published";
+        else if (! skipped && problem.isEmpty() && levels.numChannels != numChannels)
+            problem = "the channel levels cover " + juce::String(levels.numChannels) + " channels";
+
+        for (int channel = 0; ! skipped && channel < numChannels && problem.isEmpty(); ++channel) {
+            const auto* data = channels[(size_t) channel];
+            SampleType peak = 0;
+            int numClipped = 0;
+
+            for (int i = 0; i < numSamples; ++i) {
+                peak = std::max(peak, std::abs(data[i]));
+                numClipped += std::abs(data[i]) > (SampleType) 1 ? 1 : 0;
+            }
+
+            if (levels.peaks[(size_t) channel] != (float) peak || levels.clippedSamples[(size_t) channel] != numClipped)
+                problem = "the channel levels misread channel " + juce::String(channel);
+        }
+
+        if (problem.isEmpty() && numFrames != (skipped ? 0 : 1))
+            problem = "published " + juce::String(numFrames) + " meter frames";
+
+        if (problem.isNotEmpty()) {
+            runner.addFailure(description + ", block " + juce::String(block) + " of " + juce::String(numSamples) + " samples: " + problem);
+            return;
+        }
+
+        position += numSamples;
+    }
+}
+
+// A fixed seed, so that a failing trial comes out the same way every run
+static void checkRandomBlocks (BenchmarkRunner& runner)
+{
+    constexpr int numTrials = 32;
+    juce::Random random(0x4F70656E4761696ELL);
+
+    for (int trial = 0; trial < numTrials; ++trial) {
+        if (trial % 2 == 0)
+            runStressTrial<float>(runner, random, trial);
+        else
+            runStressTrial<double>(runner, random, trial);
+    }
+}
+
+//==============================================================================
+// Times every block size a host might send, including the awkward ones either side of
+// each power of two and ones longer than the prepared size. The calls are shuffled
+// and start at random alignments, and each one is timed on its own. The median is
+// each size's usual cost and the 99th percentile its slow calls. A slow path that
+// only some sizes take stands out against a baseline, even where an average over
+// every size would hide it.
+static void addBlockSizePercentiles (BenchmarkRunner& runner)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int preparedBlockSize = 512, numCallsPerSize = 300, maxAlignmentOffset = 15;
+    static constexpr int blockSizes[] { 1, 2, 3, 7, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 128, 129,
+                                        255, 256, 257, 511, 512, 513, 1024, 1500 };
+
+    auto getName = [] (int blockSize, const char* percentile) {
+        return "stress/stereo/" + juce::String(blockSize) + "/" + percentile;
+    };
+
+    std::vector<int> sequence;
+
+    for (int blockSize : blockSizes)
+        if (runner.shouldRun(getName(blockSize, "p50")) || runner.shouldRun(getName(blockSize, "p99")))
+            sequence.insert(sequence.end(), numCallsPerSize, blockSize);
+
+    if (sequence.empty())
+        return;
+
+    juce::Random random(0x4F47);
+
+    for (size_t i = sequence.size() - 1; i > 0; --i)
+        std::swap(sequence[i], sequence[(size_t) random.nextInt((int) i + 1)]);
+
+    // A static gain off unity, so every call multiplies and none ramps
+    auto processor = createPreparedProcessor(2, sampleRate, preparedBlockSize);
+    processor->gainParam->store(-6.0f);
+
+    const int storageSize = *std::max_element(sequence.begin(), sequence.end()) + maxAlignmentOffset;
+    juce::AudioBuffer<float> source(2, storageSize), storage(2, storageSize);
+    fillWithTestSignal(source, sampleRate);
+    juce::MidiBuffer midi;
+    std::map<int, std::vector<double>> callNs;
+
+    // Once through untimed to warm up, then again timing every call
+    for (bool timed : { false, true }) {
+        for (int blockSize : sequence) {
+            const int offset = random.nextInt(maxAlignmentOffset + 1);
+            storage.makeCopyOf(source, true);
+
+            float* channels[] { storage.getWritePointer(0) + offset, storage.getWritePointer(1) + offset };
+            juce::AudioBuffer<float> buffer(channels, 2, blockSize);
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            processor->processBlock(buffer, midi);
+            const auto ticks = juce::Time::getHighResolutionTicks() - start;
+
+            if (timed)
+                callNs[blockSize].push_back(juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9);
+        }
+    }
+
+    for (auto& [blockSize, times] : callNs) {
+        std::sort(times.begin(), times.end());
+
+        for (auto [percentile, fraction] : { std::pair<const char*, double> { "p50", 0.5 }, { "p99", 0.99 } }) {
+            const auto name = getName(blockSize, percentile);
+
+            if (runner.shouldRun(name)) {
+                const auto ns = times[(size_t) (fraction * (double) (times.size() - 1))];
+                runner.addResult({ name, ns, ns / blockSize });
+            }
+        }
+    }
+}
+
+//==============================================================================
+void addStressBenchmarks (BenchmarkRunner& runner)
+{
+    checkRandomBlocks(runner);
+    addBlockSizePercentiles(runner);
+}
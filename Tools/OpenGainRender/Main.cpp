@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    OpenGainRender: streams an audio file through GainAudioProcessor offline.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+//==============================================================================
+static std::unique_ptr<juce::AudioFormatReader> openInput (juce::AudioFormatManager& formats, const juce::File& file)
+{
+    // Memory-mapped where the format supports it (WAV, AIFF), so large files are paged
+    // in as they're read instead of being copied into RAM. FLAC has no mapped reader
+    // and is decoded from a stream instead.
+    if (auto* format = formats.findFormatForFileExtension(file.getFileExtension())) {
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(format->createMemoryMappedReader(file));
+
+        if (mapped != nullptr && mapped->mapEntireFile())
+            return mapped;
+    }
+
+    return std::unique_ptr<juce::AudioFormatReader>(formats.createReaderFor(file));
+}
+
+static std::unique_ptr<juce::AudioFormatWriter> openOutput (juce::AudioFormatManager& formats, const juce::File& file,
+                                                            const juce::AudioFormatReader& reader, int bitsPerSample)
+{
+    auto* format = formats.findFormatForFileExtension(file.getFileExtension());
+
+    if (format == nullptr)
+        juce::ConsoleApplication::fail("Unsupported output format: " + file.getFileName());
+
+    if (! format->getPossibleBitDepths().contains(bitsPerSample))
+        bitsPerSample = format->getPossibleBitDepths().getLast();
+
+    file.deleteFile();
+    std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+
+    if (stream == nullptr)
+        juce::ConsoleApplication::fail("Couldn't write to " + file.getFullPathName());
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), reader.sampleRate,
+                                                                            reader.numChannels, bitsPerSample, {}, 0));
+
+    if (writer == nullptr)
+        juce::ConsoleApplication::fail("Couldn't create a " + format->getFormatName() + " writer for " + file.getFileName());
+
+    stream.release(); // now owned by the writer
+    return writer;
+}
+
+static void setGain (GainAudioProcessor& processor, float gainDb)
+{
+    if (auto* param = processor.apvts.getParameter("GAIN"))
+        param->setValueNotifyingHost(param->convertTo0to1(gainDb));
+}
+
+//==============================================================================
+static void render (const juce::ArgumentList& args)
+{
+    const auto inputFile = args.getExistingFileForOption("--input|-i");
+    const auto outputFile = args.getFileForOption("--output|-o");
+    const int blockSize = args.containsOption("--block-size|-b") ? args.getValueForOption("--block-size|-b").getIntValue() : 512;
+    const float gainDb = args.getValueForOption("--gain|-g").getFloatValue();
+    const bool hasGainRamp = args.containsOption("--gain-to");
+    const float gainToDb = args.getValueForOption("--gain-to").getFloatValue();
+
+    if (blockSize <= 0)
+        juce::ConsoleApplication::fail("--block-size must be positive");
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    auto reader = openInput(formats, inputFile);
+
+    if (reader == nullptr)
+        juce::ConsoleApplication::fail("Couldn't read " + inputFile.getFullPathName());
+
+    const int numChannels = (int) reader->numChannels;
+    const auto sampleRate = reader->sampleRate;
+    const auto lengthInSamples = reader->lengthInSamples;
+    const int bitsPerSample = args.containsOption("--bits") ? args.getValueForOption("--bits").getIntValue() : (int) reader->bitsPerSample;
+
+    auto writer = openOutput(formats, outputFile, *reader, bitsPerSample);
+
+    GainAudioProcessor processor;
+    const auto channelSet = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(channelSet);
+    layout.outputBuses.add(channelSet);
+
+    if (! processor.setBusesLayout(layout))
+        juce::ConsoleApplication::fail("OpenGain doesn't support " + juce::String(numChannels) + " channel files");
+
+    processor.setNonRealtime(true);
+    processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+    setGain(processor, gainDb);
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    juce::AudioBuffer<float> buffer(numChannels, blockSize);
+    juce::MidiBuffer midi;
+    juce::int64 dspTicks = 0;
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    for (juce::int64 position = 0; position < lengthInSamples; position += blockSize) {
+        const int numSamples = (int) juce::jmin((juce::int64) blockSize, lengthInSamples - position);
+        reader->read(buffer.getArrayOfWritePointers(), numChannels, position, numSamples);
+
+        // --gain-to automates a straight line in dB across the file, one point per block
+        if (hasGainRamp) {
+            const auto endProportion = (double) (position + numSamples) / (double) lengthInSamples;
+            processor.addGainChange(numSamples, (float) (gainDb + (gainToDb - gainDb) * endProportion));
+        }
+
+        juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), numChannels, numSamples);
+
+        const auto blockStart = juce::Time::getHighResolutionTicks();
+        processor.processBlock(block, midi);
+        dspTicks += juce::Time::getHighResolutionTicks() - blockStart;
+
+        writer->writeFromAudioSampleBuffer(block, 0, numSamples);
+    }
+
+    writer.reset();
+    processor.releaseResources();
+
+    const auto totalSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    const auto dspSeconds = juce::Time::highResolutionTicksToSeconds(dspTicks);
+    const auto audioSeconds = (double) lengthInSamples / sampleRate;
+
+    auto realtimeMultiple = [audioSeconds] (double seconds) {
+        return seconds > 0.0 ? juce::String(audioSeconds / seconds, 1) + "x realtime" : juce::String("n/a");
+    };
+
+    std::cout << "Rendered " << juce::String(audioSeconds, 2) << " s (" << numChannels << " ch @ "
+              << sampleRate << " Hz) in blocks of " << blockSize << std::endl
+              << "DSP:   " << juce::String(dspSeconds, 4) << " s (" << realtimeMultiple(dspSeconds) << ")" << std::endl
+              << "Total: " << juce::String(totalSeconds, 4) << " s (" << realtimeMultiple(totalSeconds) << ", including file I/O)" << std::endl
+              << "Silent blocks skipped: " << (juce::int64) processor.getNumSkippedBlocks() << std::endl;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    // The processor's parameter state uses timers, which need a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ConsoleApplication app;
+    app.addHelpCommand("--help|-h", "Usage:", false);
+    app.addDefaultCommand({ "",
+                            "--input <file> --output <file> [--gain <dB>] [--gain-to <dB>] [--block-size <n>] [--bits <n>]",
+                            "Renders a WAV/AIFF/FLAC file through GainAudioProcessor and reports throughput.",
+                            "--gain-to automates the gain in a straight line from --gain to this value across the file.",
+                            render });
+
+    return app.run(argc, argv);
+}